@@ -0,0 +1,106 @@
+/******************************************************************************
+* File:             artstore.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Deduplicated storage for picture data
+*****************************************************************************/
+
+#ifndef ARTSTORE_HPP
+#define ARTSTORE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace ID3 {
+
+    /**
+     * Store that makes sure that identical picture data is only kept in memory once.
+     *
+     * Songs of the same album usually embed the same cover, so pictures are identified
+     * by a hash of their content and every picture with the same content shares a single buffer.
+     * The store only keeps weak references, a buffer is freed as soon as the last picture
+     * that uses it releases it (reference counted through std::shared_ptr).
+     *
+     * The store is shared by all threads (see instance()) and is thread safe.
+     *
+     * Member variables:
+     *  m_mutex:  Mutex protecting the buffers
+     *  m_images: The buffers by content hash
+     */
+    class ArtStore
+    {
+    public:
+
+        // buffers are swept for expired entries every time the map grew by this amount
+        static constexpr std::size_t SWEEP_INTERVAL = 256;
+
+
+        /**
+         * @return a reference to the store that is shared by the whole program
+         */
+        static ArtStore& instance();
+
+
+        /**
+         * Hashes picture data, processing 8 bytes at a time.
+         *
+         * @param t_data A view of the picture data
+         * @return the 64 bit hash of the data, never 0 (which is used for 'no hash')
+         */
+        static std::uint64_t hash(std::span<const char> t_data) noexcept;
+
+
+        /**
+         * Returns the shared buffer for picture data.
+         *
+         * If a buffer with the same content is alive it is returned, otherwise
+         * the data is copied into a new buffer that is shared from then on.
+         *
+         * @param t_hash The hash of the data (see hash())
+         * @param t_data A view of the picture data
+         *
+         * @return a shared pointer to a buffer that contains the data
+         */
+        std::shared_ptr<std::vector<char>> intern(std::uint64_t t_hash, std::span<const char> t_data);
+
+
+        /**
+         * Looks up a buffer without adding anything to the store.
+         *
+         * @param t_hash The hash of the data
+         * @param t_size The size of the data in bytes
+         *
+         * @return a shared pointer to the buffer, or nullptr if there is no buffer with that hash and size alive
+         */
+        std::shared_ptr<std::vector<char>> find(std::uint64_t t_hash, std::size_t t_size);
+
+
+        /**
+         * @return the number of buffers that are alive
+         */
+        std::size_t size();
+
+
+    private:
+
+        ArtStore() = default;
+
+
+        /**
+         * Removes the entries of buffers that have been freed, m_mutex has to be locked.
+         */
+        void sweep();
+
+
+        std::mutex m_mutex;
+        std::unordered_map<std::uint64_t, std::weak_ptr<std::vector<char>>> m_images;
+        std::size_t m_sweep_at = SWEEP_INTERVAL;
+    };
+}
+
+#endif /* ifndef ARTSTORE_HPP */
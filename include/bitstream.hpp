@@ -0,0 +1,180 @@
+/******************************************************************************
+* File:             bitstream.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Reader for bit oriented data
+*****************************************************************************/
+
+
+#ifndef BITSTREAM_HPP
+#define BITSTREAM_HPP
+
+#include <cstdint>
+#include <span>
+
+
+/**
+ * Reads a buffer bit by bit, most significant bit first.
+ *
+ * The bits are read through a 64 bit cache, which is refilled with 8 bytes at once whenever
+ * it holds fewer than 32 bits, so reads of up to 32 bits never touch the buffer byte by byte.
+ *
+ * Reading past the end of the buffer yields zeros, the position still advances, so that
+ * callers can check for overruns once after reading a block of fields (see position()).
+ *
+ * Member variables:
+ *  m_data:  View of the buffer
+ *  m_cache: The next bits, left aligned
+ *  m_bits:  The number of valid bits in m_cache
+ *  m_next:  The byte of the buffer that is loaded into the cache next
+ */
+class BitReader
+{
+public:
+
+    /**
+     * Class constructor.
+     *
+     * @param t_data     A view of the buffer
+     * @param t_position The position to start reading at in bits
+     */
+    explicit BitReader(std::span<const char> t_data, std::size_t t_position = 0) noexcept : m_data(t_data) {
+        seek(t_position);
+    }
+
+
+    /**
+     * Returns the next bits without consuming them.
+     *
+     * @param t_bits The number of bits, between 1 and 32
+     * @return the bits as an unsigned integer
+     */
+    inline std::uint32_t peek(std::size_t t_bits) noexcept {
+
+        if (m_bits < t_bits)
+            refill();
+
+        return static_cast<std::uint32_t>(m_cache >> (64 - t_bits));
+    }
+
+
+    /**
+     * Consumes bits, has to be preceded by a peek of at least as many bits.
+     *
+     * @param t_bits The number of bits
+     */
+    inline void skip(std::size_t t_bits) noexcept {
+        m_cache <<= t_bits;
+        m_bits -= t_bits;
+    }
+
+
+    /**
+     * Reads a number of bits.
+     *
+     * @param t_bits The number of bits, at most 32
+     * @return the bits as an unsigned integer
+     */
+    inline std::uint32_t read(std::size_t t_bits) noexcept {
+
+        if (t_bits == 0)
+            return 0;
+
+        std::uint32_t value = peek(t_bits);
+
+        skip(t_bits);
+
+        return value;
+    }
+
+
+    /**
+     * Reads a single bit.
+     *
+     * @return the bit
+     */
+    inline std::uint32_t bit() noexcept {
+        return read(1);
+    }
+
+
+    /**
+     * @return the current position in bits
+     */
+    inline std::size_t position() const noexcept {
+        return m_next * 8 - m_bits;
+    }
+
+
+    /**
+     * Moves to a position.
+     *
+     * @param t_position The position in bits
+     */
+    inline void seek(std::size_t t_position) noexcept {
+
+        m_cache = 0;
+        m_bits = 0;
+        m_next = t_position >> 3;
+
+        if (t_position & 0x07) {
+            refill();
+            skip(t_position & 0x07);
+        }
+    }
+
+
+    /**
+     * @return the size of the buffer in bits
+     */
+    inline std::size_t size() const noexcept {
+        return m_data.size() * 8;
+    }
+
+
+private:
+    std::span<const char> m_data;
+    std::uint64_t m_cache;
+    std::size_t m_bits;
+    std::size_t m_next;
+
+
+    /**
+     * Loads whole bytes into the cache until it holds at least 57 bits.
+     */
+    inline void refill() noexcept {
+
+        // fast path, 8 bytes are loaded at once and as many whole bytes as fit are kept
+        if (m_next + 8 <= m_data.size()) {
+
+            std::uint64_t value = 0;
+
+            for (std::size_t i = 0; i < 8; ++i)
+                value = (value << 8) | static_cast<std::uint8_t>(m_data[m_next + i]);
+
+            std::size_t bytes = (63 - m_bits) >> 3;
+
+            m_cache |= value >> m_bits;
+            m_next += bytes;
+            m_bits += bytes * 8;
+
+            // the bits after the last whole byte are loaded again with the next refill
+            m_cache &= ~std::uint64_t{0} << (64 - m_bits);
+
+            return;
+        }
+
+        // near the end of the buffer, missing bytes are zeros
+        while (m_bits <= 56) {
+
+            std::uint64_t value = m_next < m_data.size() ? static_cast<std::uint8_t>(m_data[m_next]) : 0;
+
+            m_cache |= value << (56 - m_bits);
+            m_next += 1;
+            m_bits += 8;
+        }
+    }
+};
+
+#endif /* ifndef BITSTREAM_HPP */
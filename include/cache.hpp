@@ -0,0 +1,182 @@
+/******************************************************************************
+* File:             cache.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Persistent cache for the metadata of songs
+*****************************************************************************/
+
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <song.hpp>
+
+
+/**
+ * Size and modification time of a file, used to tell whether
+ * the cached metadata of a file is still up to date.
+ *
+ * size:  The size of the file in bytes
+ * mtime: The time of the last modification (in the clock ticks of std::filesystem::file_time_type)
+ */
+struct FileStamp {
+    std::uint64_t size;
+    std::int64_t mtime;
+
+    bool operator==(const FileStamp&) const = default;
+};
+
+
+/**
+ * On-disk cache for the parsed metadata of songs, keyed by path, size and modification time.
+ *
+ * The cache is stored in a compact binary format that is read through a memory mapping:
+ *
+ *  header:  4 bytes magic ("MP3C"), 4 bytes format version, 4 bytes number of entries
+ *  entry:   8 bytes file size, 8 bytes mtime,
+ *           4 bytes audio start, 4 bytes play counter offset,
+ *           8 bytes duration, 8 bytes delay, 8 bytes play counter,
+ *           path, title, album, artist, genre, release, track number as strings,
+ *           1 byte number of pictures, followed by the pictures
+ *  picture: 4 bytes offset, 4 bytes size, 8 bytes content hash, 1 byte picture type, MIME type as string
+ *  string:  2 bytes length followed by the characters (not null terminated)
+ *
+ * All integers are stored in the byte order of the device, the cache is not meant to be portable.
+ * Pictures are only stored as offset and size, their data is not part of the cache.
+ * Pictures of altered frames (unsynchronised, compressed) have an offset of 0, they are loaded
+ * by parsing the tag again (see ID3::Picture::data()).
+ *
+ * Member variables:
+ *  m_filename: The path of the cache file
+ *  m_entries:  The cached songs, with their file stamps, by path
+ *  m_dirty:    true if entries have been added since the cache has been loaded
+ */
+class MetadataCache
+{
+public:
+
+    static constexpr char MAGIC[4] = {'M', 'P', '3', 'C'};
+    static constexpr std::uint32_t FORMAT_VERSION = 2;
+
+
+    /**
+     * Class constructor, loads the cache file if it exists.
+     *
+     * A cache file that can't be read (wrong magic, wrong version, truncated) is ignored.
+     *
+     * @param t_filename The path of the cache file
+     */
+    explicit MetadataCache(std::string t_filename);
+
+    MetadataCache() = delete;
+
+
+    /**
+     * Retrieves size and modification time of a file.
+     *
+     * @param t_path  The path to the file
+     * @return the stamp of the file, or an empty optional if the file can't be accessed
+     */
+    static std::optional<FileStamp> stamp(const std::string& t_path) noexcept;
+
+
+    /**
+     * Returns the directory for the caches of the player, which is $XDG_CACHE_HOME/mp3-player
+     * or ~/.cache/mp3-player if XDG_CACHE_HOME is not set.
+     *
+     * @return the path of the cache directory
+     */
+    static std::filesystem::path cacheDirectory();
+
+
+    /**
+     * Returns the location of the cache file, which is library.cache in the cache directory.
+     *
+     * @return the path of the cache file
+     */
+    static std::string defaultPath();
+
+
+    /**
+     * Looks up the metadata of a song.
+     *
+     * @param t_path  The path to the mp3 file
+     * @param t_stamp The current stamp of the file
+     *
+     * @return a copy of the cached song if there is an entry with the same stamp, an empty optional otherwise
+     */
+    std::optional<Song> lookup(const std::string& t_path, const FileStamp& t_stamp) const;
+
+
+    /**
+     * Adds (or replaces) the metadata of a song.
+     *
+     * @param t_song  The song with parsed metadata
+     * @param t_stamp The stamp of the file when it was parsed
+     */
+    void store(const Song& t_song, const FileStamp& t_stamp);
+
+
+    /**
+     * Writes the cache to disk if there have been changes. Entries of files that do not
+     * exist anymore are dropped. The file is written to a temporary file first, which
+     * then replaces the old cache file.
+     *
+     * @return true if the cache has been written (or there was nothing to write), false otherwise
+     */
+    bool save();
+
+
+    /**
+     * @return the number of entries in the cache
+     */
+    inline std::size_t size() const noexcept {
+        return m_entries.size();
+    }
+
+
+    /**
+     * Serializes a song and its stamp as a cache entry and appends it to a buffer.
+     *
+     * @param t_song   The song that should be serialized
+     * @param t_stamp  The stamp of the file
+     * @param t_buffer The buffer the entry is appended to
+     */
+    static void serialize(const Song& t_song, const FileStamp& t_stamp, std::vector<char>& t_buffer);
+
+
+    /**
+     * Deserializes a cache entry.
+     *
+     * @param t_data     A view of the cache data
+     * @param t_position The position of the entry, set to the first byte after the entry
+     *
+     * @return the song and its stamp, or an empty optional if the entry is truncated
+     */
+    static std::optional<std::pair<Song, FileStamp>> deserialize(std::span<const char> t_data, std::size_t& t_position);
+
+
+private:
+
+    struct Entry {
+        FileStamp stamp;
+        Song song;
+    };
+
+
+    /**
+     * Reads all entries of the cache file.
+     */
+    void load();
+
+
+    std::string m_filename;
+    std::unordered_map<std::string, Entry> m_entries;
+    bool m_dirty = false;
+};
+
+#endif /* ifndef CACHE_HPP */
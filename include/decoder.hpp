@@ -0,0 +1,179 @@
+/******************************************************************************
+* File:             decoder.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Fixed-point decoder for MPEG audio layer 3
+*****************************************************************************/
+
+
+#ifndef DECODER_HPP
+#define DECODER_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <bitstream.hpp>
+#include <dsp.hpp>
+#include <mp3.hpp>
+
+
+namespace MP3 {
+
+    /**
+     * Decoder for MPEG 1, 2 and 2.5 layer 3 frames.
+     *
+     * All of the decoding is done with fixed-point arithmetic (see DSP), floating point is only
+     * used once to build the coefficient tables. Frames have to be passed in the order they are
+     * stored in, since the data of a frame can start in previous frames (bit reservoir) and the
+     * filterbanks overlap consecutive frames.
+     *
+     * Member variables:
+     *  m_reservoir:      Main data of the previous frames followed by the main data of the current frame
+     *  m_reservoir_size: The number of bytes in m_reservoir
+     *  m_scalefactors:   Scalefactors by channel, kept between granules for scalefactor selection information
+     *  m_lines:          Spectral lines of the current granule by channel
+     *  m_nonzero:        The number of lines of the current granule that might not be zero by channel
+     *  m_overlap:        Second halves of the IMDCT blocks of the previous granule by channel
+     *  m_synthesis:      State of the synthesis filterbank by channel
+     *  m_channels:       The number of channels of the last frame
+     *  m_sample_rate:    The sample rate of the last frame
+     */
+    class Decoder
+    {
+    public:
+
+        // the largest number of samples per channel in a frame
+        static constexpr std::size_t MAX_SAMPLES = 1152;
+
+        // the largest number of bytes of main data a frame can take from previous frames (bit reservoir)
+        static constexpr std::size_t MAX_MAIN_DATA_BEGIN = 511;
+
+
+        Decoder() = default;
+
+
+        /**
+         * Decodes a frame.
+         *
+         * If the frame refers to main data of previous frames that have not been passed (e.g.
+         * the first frames after a seek), silence is returned, but the main data of the frame
+         * is kept for the following frames.
+         *
+         * @param t_frame A view of the data that starts with the frame, has to contain the whole frame
+         * @param t_pcm   Output for the interleaved 16 bit samples, has to hold MAX_SAMPLES samples per channel
+         *
+         * @return the number of samples per channel that have been written, 0 if the frame is not a layer 3 frame
+         */
+        std::size_t decode(std::span<const char> t_frame, std::span<std::int16_t> t_pcm) noexcept;
+
+
+        /**
+         * Resets the decoder to the state before the first frame, has to be called before
+         * frames that don't follow the last frame are passed (e.g. after seeking).
+         */
+        void reset() noexcept;
+
+
+        /**
+         * @return the number of channels of the last frame
+         */
+        inline byte channels() const noexcept {
+            return m_channels;
+        }
+
+
+        /**
+         * @return the sample rate of the last frame in Hz
+         */
+        inline std::uint32_t sampleRate() const noexcept {
+            return m_sample_rate;
+        }
+
+
+    private:
+
+        // main data can start at most 511 bytes before a frame, a frame contains at most 1441 bytes
+        static constexpr std::size_t RESERVOIR_SIZE = 2048;
+
+        static constexpr std::size_t LINES = 576;
+
+
+        /**
+         * Side information of a granule of a channel.
+         */
+        struct Granule {
+            std::uint32_t part2_3_length;
+            std::uint32_t big_values;
+            std::uint32_t global_gain;
+            std::uint32_t scalefac_compress;
+            bool window_switching;
+            byte block_type;
+            bool mixed_block;
+            std::array<byte, 3> table_select;
+            std::array<byte, 3> subblock_gain;
+            std::uint32_t region1_start;
+            std::uint32_t region2_start;
+            bool preflag;
+            bool scalefac_scale;
+            byte count1table_select;
+
+            inline bool shortBlocks() const noexcept {
+                return window_switching && block_type == 2;
+            }
+        };
+
+
+        /**
+         * Side information of a frame.
+         */
+        struct SideInformation {
+            std::uint32_t main_data_begin;
+            std::array<std::array<bool, 4>, 2> scfsi;
+            std::array<std::array<Granule, 2>, 2> granules;
+        };
+
+
+        /**
+         * Scalefactors of a channel, along with the intensity stereo positions that are illegal
+         * (which is the largest value that can be coded with the number of bits of the scalefactor).
+         */
+        struct Scalefactors {
+            std::array<byte, 22> l;
+            std::array<std::array<byte, 3>, 13> s;
+            std::array<byte, 22> illegal_l;
+            std::array<byte, 13> illegal_s;
+        };
+
+
+        void readSideInformation(BitReader& t_reader, const FrameHeader& t_header, SideInformation& t_info) const noexcept;
+
+        void readScalefactors(BitReader& t_reader, const FrameHeader& t_header, const SideInformation& t_info,
+                              Granule& t_granule, std::size_t t_granule_index, std::size_t t_channel) noexcept;
+
+        void readScalefactorsLSF(BitReader& t_reader, const FrameHeader& t_header, Granule& t_granule, std::size_t t_channel) noexcept;
+
+        void readLines(BitReader& t_reader, const Granule& t_granule, std::size_t t_end, std::size_t t_channel) noexcept;
+
+        void requantize(const FrameHeader& t_header, const Granule& t_granule, std::size_t t_channel) noexcept;
+
+        void stereo(const FrameHeader& t_header, const Granule& t_granule) noexcept;
+
+        void reconstruct(const FrameHeader& t_header, const Granule& t_granule, std::size_t t_channel, std::int16_t* t_pcm) noexcept;
+
+
+        std::array<char, RESERVOIR_SIZE> m_reservoir{};
+        std::size_t m_reservoir_size = 0;
+
+        std::array<Scalefactors, 2> m_scalefactors{};
+        std::array<std::array<DSP::sample, LINES>, 2> m_lines{};
+        std::array<std::size_t, 2> m_nonzero{};
+        std::array<std::array<DSP::sample, LINES>, 2> m_overlap{};
+        std::array<DSP::Synthesis, 2> m_synthesis{};
+
+        byte m_channels = 0;
+        std::uint32_t m_sample_rate = 0;
+    };
+}
+
+#endif /* ifndef DECODER_HPP */
@@ -0,0 +1,115 @@
+/******************************************************************************
+* File:             dsp.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Fixed-point filterbanks of MPEG audio layer 3
+*****************************************************************************/
+
+
+#ifndef DSP_HPP
+#define DSP_HPP
+
+#include <array>
+#include <cstdint>
+
+
+namespace MP3::DSP {
+
+    using byte = std::uint8_t;
+
+    // samples are signed fixed-point numbers with 24 fractional bits (1.0 is full scale)
+    using sample = std::int32_t;
+
+    constexpr int FRACTION_BITS = 24;
+
+    // coefficients (cosine tables, windows) are signed fixed-point numbers with 30 fractional bits
+    constexpr int COEFFICIENT_BITS = 30;
+
+
+    /**
+     * Multiplies a sample with a coefficient.
+     *
+     * @param t_sample      The sample
+     * @param t_coefficient The coefficient
+     *
+     * @return the product as a sample
+     */
+    inline sample multiply(sample t_sample, std::int32_t t_coefficient) noexcept {
+        return static_cast<sample>((std::int64_t{t_sample} * t_coefficient) >> COEFFICIENT_BITS);
+    }
+
+
+    /**
+     * Converts a sample to a 16 bit PCM sample, with rounding and clipping.
+     *
+     * @param t_sample The sample
+     * @return the PCM sample
+     */
+    inline std::int16_t toPCM(sample t_sample) noexcept {
+
+        constexpr int SHIFT = FRACTION_BITS - 15;
+
+        std::int32_t value = (t_sample + (1 << (SHIFT - 1))) >> SHIFT;
+
+        return static_cast<std::int16_t>(value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : value);
+    }
+
+
+    // instruction sets of the vectorized filterbanks (see kernels.hpp)
+    typedef enum {SCALAR, SSE2, AVX2, NEON} Kernel;
+
+
+    /**
+     * @return the instruction set the filterbanks currently use, the best one supported by the CPU unless selected with useKernel
+     */
+    Kernel kernel() noexcept;
+
+
+    /**
+     * Selects the instruction set of the filterbanks for all decoders.
+     *
+     * @param t_kernel The instruction set
+     * @return false if the instruction set is not supported by this build or CPU, the selection is unchanged then
+     */
+    bool useKernel(Kernel t_kernel) noexcept;
+
+
+    /**
+     * State of the polyphase synthesis filterbank of one channel.
+     *
+     * v:      The last 16 vectors of the matrixing (ISO/IEC 11172-3 V vector), as a ring buffer
+     * offset: The position of the newest vector in v
+     */
+    struct Synthesis {
+        std::array<sample, 1024> v{};
+        std::size_t offset = 0;
+    };
+
+
+    /**
+     * Transforms the 18 spectral lines of a subband into 18 time samples (IMDCT, windowing and overlap-add).
+     *
+     * For short blocks (block type 2), the lines are expected to be reordered so that the
+     * three windows are interleaved (line 3 * i + window).
+     *
+     * @param t_lines      The spectral lines
+     * @param t_overlap    The second half of the previous block of the subband, replaced with the second half of this block
+     * @param t_samples    Output for the time samples
+     * @param t_block_type The block type (0 normal, 1 start, 2 short, 3 stop)
+     */
+    void inverseMDCT(const sample t_lines[18], sample t_overlap[18], sample t_samples[18], byte t_block_type) noexcept;
+
+
+    /**
+     * Synthesizes 32 PCM samples from one sample of each of the 32 subbands.
+     *
+     * @param t_state    The state of the filterbank of the channel
+     * @param t_subbands One sample of each subband
+     * @param t_pcm      Output for the PCM samples
+     * @param t_stride   The distance between two PCM samples in the output (the number of channels)
+     */
+    void synthesize(Synthesis& t_state, const sample t_subbands[32], std::int16_t* t_pcm, std::size_t t_stride) noexcept;
+}
+
+#endif /* ifndef DSP_HPP */
@@ -17,6 +17,7 @@
 #include <memory>
 #include <vector>
 #include <filesystem>
+#include <span>
 
 class Filehandler {
 
@@ -26,14 +27,19 @@ class Filehandler {
          * Class constructor, initializes filename and opens a read only stream
          * for the file.
          *
+         * If t_map is true the file is memory mapped instead of opening a stream,
+         * so that its content can be addressed directly (see bytes()).
+         * If the file can not be mapped (e.g. because it is empty) a stream is opened instead.
+         *
          * @param t_filename name of the file
+         * @param t_map      whether the file should be memory mapped
          */
-        Filehandler(std::string  t_filename) noexcept;
+        Filehandler(std::string  t_filename, bool t_map = false) noexcept;
 
         Filehandler() = delete;
 
-        // Enabling move operations
-        Filehandler(Filehandler &&) = default;
+        // Enabling move operations, the mapping has to be handed over explicitly
+        Filehandler(Filehandler && t_other) noexcept;
 
         /**
          * Checks whether a file exists or not.
@@ -48,6 +54,28 @@ class Filehandler {
         }
 
 
+        /**
+         * Checks whether the file is memory mapped or read through a stream.
+         *
+         * @return true if the file is memory mapped, false otherwise
+         */
+        inline bool isMapped() const noexcept {
+            return m_mapping != nullptr;
+        }
+
+
+        /**
+         * Returns the content of a memory mapped file as a contiguous, read only range of bytes.
+         *
+         * The view is only valid as long as this object exists.
+         *
+         * @return a view of the whole file, or an empty view if the file is not memory mapped
+         */
+        inline std::span<const char> bytes() const noexcept {
+            return {m_mapping, m_mapping_size};
+        }
+
+
         /**
          * Reads "bytes" bytes from a stream, starting at byte "position".
          *
@@ -89,6 +117,8 @@ class Filehandler {
          * After successfully copying everything over, the old file is then deleted, and
          * the temporary file is renamed to the name of the original file.
          *
+         * A memory mapped file is unmapped first and read through a stream from then on.
+         *
          * @param t_position  The relative offset to the start of the file of the first byte
          * @param t_bytes     The amount of bytes that should be deleted
          */
@@ -130,9 +160,40 @@ class Filehandler {
 
 
     private:
+
+        /**
+         * Maps the whole file into memory (read only).
+         *
+         * @return true if the file has been mapped, false otherwise
+         */
+        bool map() noexcept;
+
+
+        /**
+         * Removes the memory mapping of the file if there is one.
+         */
+        void unmap() const noexcept;
+
+
+        /**
+         * Copies bytes out of the memory mapping, the bytes past the end of the file are not touched.
+         *
+         * @param t_buffer    A char array, that the bytes will be written into
+         * @param t_position  The offset of the first byte relative to t_way
+         * @param t_way       The point of the file that the position is relative  to (eg. start, or end)
+         * @param t_bytes     The number of bytes that should be copied
+         */
+        void copyBytes(char t_buffer[], const std::uint32_t t_position, std::_Ios_Seekdir t_way, const std::uint32_t t_bytes) const noexcept;
+
+
         std::string m_filename;
         mutable std::ifstream m_stream;
 
+        // start and size of the memory mapping, nullptr if the file is not mapped
+        // (mutable for the same reason the stream is, deleteBytes has to drop the mapping)
+        mutable const char* m_mapping = nullptr;
+        mutable std::size_t m_mapping_size = 0;
+
 
 };
 
@@ -10,10 +10,17 @@
 #ifndef ID3_HPP
 #define ID3_HPP
 
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string_view>
 #include <bits/c++config.h>
 #include <filehandler.hpp>
 #include <song.hpp>
+#include <unicode.hpp>
 #include <iostream>
 #include <log.hpp>
 #include <fmt/format.h>
@@ -76,6 +83,134 @@ namespace ID3 {
     };
 
 
+    /**
+     * Options for parsing a tag.
+     *
+     * lazy_art: If true, pictures only record where their data is stored in the file and the data
+     *           is loaded once it is needed (see Picture::data()), otherwise the data is copied right away.
+     *           Pictures whose data had to be altered (e.g. synchronized) are always copied.
+     * in_file:  True if the tag buffer holds the tag the way it is stored in the file, false if it has
+     *           been altered as a whole (tag level unsynchronisation), positions in it are no offsets in the file then.
+     */
+    struct ParseOptions {
+        bool lazy_art = true;
+        bool in_file = true;
+    };
+
+
+    /**
+     * Container for the data of a frame.
+     *
+     * As long as the data of a frame can be parsed the way it is stored in the tag,
+     * this only holds a view into the tag buffer and nothing is copied.
+     * If the data has to be altered before it can be parsed (synchronization, decompression),
+     * it is written into a scratch buffer first (see buffer()). The scratch buffer is shared by
+     * all frames of a tag (see ParseContext), so that it only grows to the size of the largest
+     * altered frame and isn't allocated for every frame, which means that the data of a frame
+     * is only valid until the next frame is prepared.
+     *
+     * m_view:    View of the frame data in the tag buffer
+     * m_scratch: The scratch buffer
+     * m_owned:   True once the data has been written into the scratch buffer
+     */
+    class FrameData
+    {
+    public:
+        FrameData(std::span<const char> t_view, std::pmr::vector<char>& t_scratch) noexcept : m_view(t_view), m_scratch(&t_scratch) {}
+
+        /**
+         * @return a view of the frame data, which points into the scratch buffer
+         *         if the data has been altered and into the tag buffer otherwise
+         */
+        inline std::span<const char> data() const noexcept {
+            return m_owned ? std::span<const char>(*m_scratch) : m_view;
+        }
+
+        /**
+         * @return the view of the frame data in the tag buffer, without alterations
+         */
+        inline std::span<const char> view() const noexcept {
+            return m_view;
+        }
+
+        /**
+         * Hands out the scratch buffer to write the altered data into, data() returns
+         * the contents of the scratch buffer from then on.
+         *
+         * @return a reference to the scratch buffer
+         */
+        inline std::pmr::vector<char>& buffer() noexcept {
+
+            m_owned = true;
+
+            return *m_scratch;
+        }
+
+        /**
+         * @return true if the frame data had to be altered, false if it is a view into the tag
+         */
+        inline bool owned() const noexcept {
+            return m_owned;
+        }
+
+    private:
+        std::span<const char> m_view;
+        std::pmr::vector<char>* m_scratch;
+        bool m_owned = false;
+    };
+
+
+    /**
+     * State that is shared by everything that is parsed while reading a tag.
+     *
+     * Strings that are decoded while parsing and the tag buffer are allocated from a monotonic arena,
+     * which hands out memory from a buffer inside of the context first and only falls back to the heap
+     * once that is used up. Nothing is freed before the context is destroyed, the song gets right-sized
+     * copies of the strings.
+     * The scratch buffer of FrameData grows frame by frame, so it is allocated from the heap instead,
+     * where the memory of a reallocation is freed right away rather than left in the arena.
+     *
+     * Member variables:
+     *  m_initial: The memory that is used by the arena first
+     *  m_arena:   The arena
+     *  m_scratch: The scratch buffer for frames that have to be altered (see FrameData)
+     */
+    class ParseContext
+    {
+    public:
+
+        // most tags without pictures fit into this
+        static constexpr std::size_t INITIAL_SIZE = 4096;
+
+
+        ParseContext() noexcept : m_arena(m_initial.data(), m_initial.size()), m_scratch(std::pmr::new_delete_resource()) {}
+
+        ParseContext(const ParseContext&) = delete;
+        ParseContext& operator=(const ParseContext&) = delete;
+
+
+        /**
+         * @return the arena that strings and buffers of the parse are allocated from
+         */
+        inline std::pmr::memory_resource* arena() noexcept {
+            return &m_arena;
+        }
+
+
+        /**
+         * @return the scratch buffer for frames that have to be altered
+         */
+        inline std::pmr::vector<char>& scratch() noexcept {
+            return m_scratch;
+        }
+
+    private:
+        alignas(std::max_align_t) std::array<std::byte, INITIAL_SIZE> m_initial;
+        std::pmr::monotonic_buffer_resource m_arena;
+        std::pmr::vector<char> m_scratch;
+    };
+
+
     /**
      * Container for text read from a buffer, the current position in
      * the buffer (position of the end of the text) and an error flag.
@@ -89,7 +224,7 @@ namespace ID3 {
      */
     struct TextAndPositionContainer {
 
-        std::string text;
+        std::pmr::string text;
         std::uint32_t position;
         bool error;
     };
@@ -98,39 +233,40 @@ namespace ID3 {
     /**
      * Checks whether ID3 metadata prepended to the file.
      *
-     * @param t_handler A reference to a Filehandler object to read from the file
+     * @param t_header A char array containing the first 10 bytes of the file
      * @return true if an ID3 tag is prepended to the file, false otherwise
      */
-    bool detectID3(Filehandler& t_handler) noexcept;
+    bool detectID3(const char t_header[]) noexcept;
 
 
     /**
-     * Reads the byte that contains the version of the ID3 Tag
+     * Extracts the byte that contains the version of the ID3 Tag
      *
-     * @param t_handler A reference to a Filehandler object to read from the file
+     * @param t_header A char array containing the 10 bytes of the tag header
      * @return a byte that contains the ID3 major version
      */
-    std::uint8_t getVersion(Filehandler& t_handler) noexcept;
+    std::uint8_t getVersion(const char t_header[]) noexcept;
 
 
     /**
-     * Reads the byte that contains the flags in the ID3 header, and returns it
+     * Extracts the byte that contains the flags in the ID3 header, and returns it
      *
-     * @param t_handler A reference to a Filehandler object to read from the file
+     * @param t_header A char array containing the 10 bytes of the tag header
      * @return a byte that contains the flags of the ID3 header
      */
-    std::uint8_t getFlags(Filehandler& t_handler) noexcept;
+    std::uint8_t getFlags(const char t_header[]) noexcept;
 
 
     /**
-     * Reads the 4 bytes that contain the size of the ID3 tag (without the header and the footer) or the extended header.
+     * Converts the 4 bytes that contain the size of the ID3 tag (without the header and the footer) or the extended header.
      *
-     * @param t_handler  A reference to a Filehandler object to read from the file
-     * @param t_extended A boolean indicating whether I'm looking for the size of a standard or extended header
+     * @param t_buffer   A char array that starts with the 4 size bytes
+     * @param t_syncsafe Whether the size is stored as a syncsafe integer (always true for the tag header,
+     *                   only true for the extended header if the tag is an ID3v2.4 tag)
      *
-     * @return 4 bytes that contain the size of the ID3 tag or the extended header
+     * @return the size of the ID3 tag or the extended header
      */
-    std::uint32_t getSize(Filehandler& t_handler, const bool t_extended) noexcept;
+    std::uint32_t getSize(const char t_buffer[], const bool t_syncsafe) noexcept;
 
 
     /**
@@ -198,13 +334,14 @@ namespace ID3 {
      *
      * 0x01:
      *  The text contains UTF-16 encoded Unicode with BOM.
-     *  If the BOM bytes are ff ff, the byte order is big endian.
+     *  If the BOM bytes are fe ff, the byte order is big endian.
      *  If the BOM bytes are ff fe, the byte order is little endian.
+     *  The text is transcoded to UTF-8 (see Unicode::utf16ToUTF8).
      *
      *  The string is null terminated by 00 00 bytes.
      *
      * 0x02:
-     *  The text contains UTF-16B encoded Unicode without BOM and
+     *  The text contains UTF-16BE encoded Unicode without BOM and
      *  the string is null terminated by 00 00 bytes.
      *
      * 0x03:
@@ -217,151 +354,114 @@ namespace ID3 {
      * message instead of the decoded text and a position of 0.
      *
      * @param t_text_encoding The method that is used to encode the text
-     * @param t_data          A const l-value reference to a std::vector containing the bytes of the text
+     * @param t_data          A view of the bytes of the text
      * @param t_position      An unsigned 32 bit integer indicating the start of the string
+     * @param t_resource      The memory resource the text is allocated from (see ParseContext)
      *
      * @return a container struct that contains the decoded text and the updated value of
      *         the position argument as well as an error flag that should be false.
      */
     inline ID3::TextAndPositionContainer decode_text_retain_position(std::int8_t t_text_encoding,
-                                                                     std::vector<char> const& t_data,
-                                                                     std::uint32_t t_position) noexcept {
-
-        char c = t_data.at(t_position++);
+                                                                     std::span<const char> t_data,
+                                                                     std::uint32_t t_position,
+                                                                     std::pmr::memory_resource* t_resource = std::pmr::get_default_resource()) noexcept {
 
-        std::string text;
+        if (t_position >= t_data.size()) {
 
-        // Text is encoded using ISO-8859-1 standard
-        // and using null terminated by 0x00,
-        // (1 'zero' byte).
-        if (t_text_encoding == 0x00) {
+            std::string message = fmt::format("Position {} is out of bounds for text with {} bytes", t_position, t_data.size());
 
-            log::debug("Decoding ISO-8859-1 encoded text");
+            log::error(message);
 
-            while (c != 0x00 && t_position != t_data.size()) {
-                text += c;
-                c = t_data.at(t_position++);
-            }
+            return {std::pmr::string(message, t_resource), 0, true};
+        }
 
-            // string is not null terminated
-            if (c != 0x00) {
+        char c = t_data[t_position++];
 
-                log::warn("String is not null terminated");
+        std::pmr::string text(t_resource);
 
-                text += c;
+        // Text is encoded using ISO-8859-1 standard (0x00) or
+        // UTF-8 encoded Unicode (0x03) and null terminated
+        // by 0x00 (1 'zero' byte).
+        if (t_text_encoding == 0x00 || t_text_encoding == 0x03) {
 
-            }
-        }
+            log::debug(t_text_encoding == 0x00 ? "Decoding ISO-8859-1 encoded text" : "Decoding UTF-8 encoded Unicode");
 
-        // Text is UTF-16 encoded Unicode with BOM.
-        // The first text byte is 0xff followed by either
-        // another 0xff byte or one 0xfe byte.
-        //
-        // If the second byte is 0xff the byte order is
-        // big endian.
-        // If the second byte is 0xfe the byte order is
-        // little endian.
-        //
-        // The text is null terminated by 0x0000
-        // (2 'zero' bytes).
-        else if (t_text_encoding == 0x01) {
+            // the first byte has been read already
+            const char* start = t_data.data() + t_position - 1;
+            std::size_t bytes = t_data.size() - t_position + 1;
 
-            log::debug("Decoding UTF-16 encoded Unicode");
-            log::error("UTF-16 has not been implemented yet");
+            const void* terminator = std::memchr(start, 0x00, bytes);
 
-            char terminated = 0;
+            // string is not null terminated
+            if (terminator == nullptr) {
 
-            if (static_cast<std::uint8_t>(c) != 0xff) {
-                log::error(fmt::format("Text data is supposed to be UTF-16 encoded Unicode with BOM, but BOM does not appear to be present.\n Expected 0xff, found {:#04x}", c));
+                log::warn("String is not null terminated");
 
-                return {"BOM missing in UTF-16 encoded Unicode", 0, true};
+                text.assign(start, bytes);
+                t_position = static_cast<std::uint32_t>(t_data.size());
             }
 
             else {
 
-                c = t_data.at(t_position++);
-
-                // big endian
-                if (static_cast<std::uint8_t>(c) == 0xff) {
-
-                    log::info("Byte order is big endian");
+                auto length = static_cast<std::size_t>(static_cast<const char*>(terminator) - start);
 
-                }
-
-                    // little endian
-                else if (static_cast<std::uint8_t>(c) == 0xfe) {
+                text.assign(start, length);
+                t_position += static_cast<std::uint32_t>(length);
+            }
+        }
 
-                    log::info("Byte order is big endian");
-                }
+        // Text is UTF-16 encoded Unicode with BOM (0x01) or
+        // UTF-16BE encoded Unicode without BOM (0x02).
+        //
+        // The BOM bytes are 0xff 0xfe if the byte order is
+        // little endian and 0xfe 0xff if it is big endian.
+        //
+        // The text is null terminated by 0x0000
+        // (2 'zero' bytes).
+        else if (t_text_encoding == 0x01 || t_text_encoding == 0x02) {
 
-                else {
+            bool big_endian = true;
 
-                    log::error("Text data is supposed to be UTF-16 encoded Unicode with BOM, but BOM does not appear to be present.");
-                    log::error(fmt::format("First byte was 0xff, but expected 0xff or 0xfe for the second byte, found {:#04x}", c));
+            // the first byte is part of the BOM or the first code unit
+            --t_position;
 
-                    return {"Second byte of BOM missing in UTF-16 encoded Unicode", 0, true};
+            if (t_text_encoding == 0x01) {
 
-                }
+                log::debug("Decoding UTF-16 encoded Unicode");
 
-                text = "UTF-16 has not been implemented yet";
+                auto first = static_cast<std::uint8_t>(c);
+                auto second = t_position + 1 < t_data.size() ? static_cast<std::uint8_t>(t_data[t_position + 1]) : 0;
 
-                // iterating until 2 consecutive 0x00 bytes are found
-                while (terminated < 2 and t_position < t_data.size()) {
-                    terminated = (c == 0x00 ? terminated + 1 : 0);
-                    c =  t_data.at(t_position);
-                    // log::info(fmt::format("Read byte {:#04x} at position {}/{}", c, t_position, t_data.size()));
-                    t_position++;
+                if (first == 0xff && second == 0xfe) {
+                    big_endian = false;
                 }
 
-                if (terminated < 2)
-                    log::warn("UTF-16 byte string is not 00 00 terminated");
-
-            }
-
-        }
-
-        // The text UTF-16B encoded Unicode without BOM.
-        // It is null terminated by 0x0000 (2 'zero' bytes)
-        else if (t_text_encoding == 0x02) {
+                else if (first != 0xfe || second != 0xff) {
 
-            log::debug("Decoding UTF-16B encoded Unicode");
-            log::error("UTF-16B has not been implemented yet");
+                    log::error(fmt::format("Text data is supposed to be UTF-16 encoded Unicode with BOM, but BOM does not appear to be present.\n"
+                                           "Expected 0xff 0xfe or 0xfe 0xff, found {:#04x} {:#04x}", first, second));
 
-            char terminated = 0;
+                    return {std::pmr::string("BOM missing in UTF-16 encoded Unicode", t_resource), 0, true};
+                }
 
-            // iterating until 2 consecutive 0x00 bytes are found
-            while (terminated < 2 and t_position < t_data.size()) {
-                terminated = (c == 0x00 ? terminated + 1 : 0);
-                c =  t_data.at(t_position);
-                // log::info(fmt::format("Read byte {:#04x} at position {}/{}", c, t_position, t_data.size()));
-                t_position++;
+                t_position += 2;
             }
 
-            if (terminated < 2)
-                log::warn("UTF-16 byte string is not 00 00 terminated");
-
-            text = "UTF-16B has not been implemented yet";
-        }
-
-        // The text is UTF-8 encoded Unicode.
-        // It is terminated by 0x00 (1 'zero' byte)
-        else if (t_text_encoding == 0x03) {
-
-            log::debug("Decoding UTF-8 encoded Unicode");
-
-            while (c != 0x00 && t_position != t_data.size()) {
-                text += c;
-                c = t_data.at(t_position++);
+            else {
+                log::debug("Decoding UTF-16BE encoded Unicode");
             }
 
-            // string is not null terminated
-            if (c != 0x00) {
+            auto data = t_data.subspan(t_position);
+            std::size_t length = Unicode::findTerminator(data);
 
-                log::warn("String is not null terminated");
+            if (length + 2 > data.size())
+                log::warn("UTF-16 byte string is not 00 00 terminated");
 
-                text += c;
+            text.resize(Unicode::maxUTF8Size(length));
+            text.resize(Unicode::utf16ToUTF8(data.first(length), big_endian, text.data()));
 
-            }
+            // the position after the terminator
+            t_position += static_cast<std::uint32_t>(std::min(length + 2, data.size()));
         }
 
         // Value of text_encoding is not valid
@@ -371,10 +471,10 @@ namespace ID3 {
 
             log::error(message);
 
-            return {message, 0, true};
+            return {std::pmr::string(message, t_resource), 0, true};
         }
 
-        return {text, t_position, false};
+        return {std::move(text), t_position, false};
 
     }
 
@@ -385,23 +485,25 @@ namespace ID3 {
      *
      *
      * @param t_text_encoding The method that is used to encode the text
-     * @param t_data          A const l-value reference to a std::vector containing the bytes of the text
+     * @param t_data          A view of the bytes of the text
      * @param t_position      An unsigned 32 bit integer indicating the start of the string
+     * @param t_resource      The memory resource the text is allocated from (see ParseContext)
      *
-     * @return a std::string containing the text, nullptr if there is an error (for now) TODO pls fix
+     * @return a string containing the text, an empty string if there is an error
      */
-    inline std::string decode_text(std::int8_t t_text_encoding, std::vector<char> const& t_data, std::uint32_t t_position) noexcept {
+    inline std::pmr::string decode_text(std::int8_t t_text_encoding, std::span<const char> t_data, std::uint32_t t_position,
+                                        std::pmr::memory_resource* t_resource = std::pmr::get_default_resource()) noexcept {
 
-        auto result = ID3::decode_text_retain_position(t_text_encoding, t_data, t_position);
+        auto result = ID3::decode_text_retain_position(t_text_encoding, t_data, t_position, t_resource);
 
         if (!result.error)
-            return result.text;
+            return std::move(result.text);
 
         // TODO deal with error
         else {
             log::error("Got an error in decode_text");
 
-            return nullptr;
+            return std::pmr::string(t_resource);
         }
     }
 
@@ -410,45 +512,99 @@ namespace ID3 {
      * Reads the content of a frame header, converts the 4 byte ID to a null-terminated string and puts the 4 size bytes
      * into an unsigned 32 bit integer and saves that, along with the flags into a FrameHeader struct.
      *
-     * @param t_handler    A reference to the file handler object for this file to read the frame header
-     * @param t_position   A reference to the position of the file pointer so that it knows where to start reading the 10 bytes
+     * @param t_tag        A view of the whole tag (without the tag header)
+     * @param t_position   A reference to the position in the tag buffer where the 10 bytes of the frame header start
      * @param t_syncsafe   True if the size is syncsafe (so if the frame is an ID3v2.4 frame), false otherwise
      *
      * @return A FrameHeader struct containing the frame ID, the size, the status- and format flags of the current frame
      */
-    FrameHeader readFrameHeader(Filehandler& t_handler, std::uint32_t& t_position, const bool t_syncsafe) noexcept;
+    FrameHeader readFrameHeader(std::span<const char> t_tag, std::uint32_t& t_position, const bool t_syncsafe) noexcept;
 
 
     /**
      * The readFrame function is called to read the contents of a frame.
      *
-     * After that that data is prepared to be parsed. This includes synchronizing it if has been desynchronized,
-     * decompressing it if it has been compressed and decrypting it if it has been encrypted.
+     * After that that data is prepared to be parsed. This includes skipping the bytes that are added
+     * to the frame header by the format flags (group identifier, encryption method and data length indicator),
+     * synchronizing it if has been desynchronized and decompressing it if it has been compressed with zlib.
+     * Compressed frames are decompressed into a buffer of exactly the size of the data length indicator.
      *
-     * TODO decompression has not yet been implemented
      * TODO decryption has not yet been implemented
      *
      *
-     * @param t_handler        A reference to the file handler object for this file to pass it on to the readFrame function
+     * @param t_tag            A view of the tag buffer to pass it on to the readFrame function
      * @param t_frame_header   A reference to the frame header struct for this frame
-     * @param t_position       A reference to the position of the file pointer to pass it on the readFrame function
+     * @param t_position       A reference to the position in the tag buffer to pass it on the readFrame function
+     * @param t_context        The context of the parse, which holds the scratch buffer for frames that have to be altered
      *
-     * @return A std::unique_ptr of a std::vector<char> containing the 'prepared' data
+     * @return A FrameData object that is a view into the tag if the data did not have to be altered,
+     *         or a view of the 'prepared' data in the scratch buffer otherwise. The data is empty if the
+     *         frame could not be decompressed, so that it is skipped.
      */
-    std::unique_ptr<std::vector<char>> prepareFrameData(Filehandler& t_handler, FrameHeader& t_frame_header, std::uint32_t& t_position) noexcept;
+    FrameData prepareFrameData(std::span<const char> t_tag, FrameHeader& t_frame_header, std::uint32_t& t_position, ParseContext& t_context) noexcept;
 
 
     /**
-     * Reads the content of a frame and returns the data (the whole frame minus the header),
-     * as a unique pointer to a vector that contains the raw bytes,so that it can be parsed by another function.
+     * Returns a view of the content of a frame (the whole frame minus the header) in the tag buffer,
+     * so that it can be parsed by another function without copying it.
      *
-     * @param t_handler          A reference to a Filehandler object to read from the file
-     * @param t_position         The starting position of the frame in the file
+     * @param t_tag              A view of the tag buffer that contains the frame
+     * @param t_position         The starting position of the frame in the tag buffer
      * @param t_bytes            The amount of bytes that should be read
      *
-     * @return a unique pointer to a vector that contains the data of the frame or a nullptr
+     * @return a view of the data of the frame
      */
-    std::unique_ptr<std::vector<char>> readFrame(Filehandler& t_handler, std::uint32_t& t_position, const std::uint32_t t_bytes) noexcept;
+    std::span<const char> readFrame(std::span<const char> t_tag, std::uint32_t& t_position, const std::uint32_t t_bytes) noexcept;
+
+
+    /**
+     * Packs a frame ID into a 32 bit integer (FourCC), with the first character in the most significant byte.
+     *
+     * @param t_id The frame ID
+     * @return the packed frame ID, or 0 if the ID is shorter than four characters
+     */
+    constexpr std::uint32_t fourCC(std::string_view t_id) noexcept {
+
+        if (t_id.size() < 4)
+            return 0;
+
+        return static_cast<std::uint32_t>(static_cast<std::uint8_t>(t_id[0])) << 24 |
+               static_cast<std::uint32_t>(static_cast<std::uint8_t>(t_id[1])) << 16 |
+               static_cast<std::uint32_t>(static_cast<std::uint8_t>(t_id[2])) << 8 |
+               static_cast<std::uint32_t>(static_cast<std::uint8_t>(t_id[3]));
+    }
+
+
+    /**
+     * A function that parses the prepared data of a frame and sets the respective member variables of the song.
+     *
+     * The parameters are the prepared frame data, a view of the tag buffer (to locate the frame data in the file),
+     * the song, the options for parsing the tag and the context of the parse.
+     */
+    using FrameHandler = void (*)(const FrameData& t_frame, std::span<const char> t_tag, Song& t_song,
+                                  const ParseOptions& t_options, ParseContext& t_context) noexcept;
+
+
+    /**
+     * Registers the handler that parses the frames with the given ID, replacing the handler
+     * that has been registered for it before (including the built in ones).
+     *
+     * Handlers are looked up in a hash table that is built at compile time for the supported frames.
+     * Registering is not synchronized, handlers have to be registered before any tag is parsed.
+     *
+     * @param t_id      The packed frame ID (see fourCC)
+     * @param t_handler The handler, or nullptr to skip the frames with that ID
+     *
+     * @return true if the handler has been registered, false if the ID is invalid or the table is full
+     */
+    bool registerFrameHandler(std::uint32_t t_id, FrameHandler t_handler) noexcept;
+
+
+    /**
+     * @param t_id The packed frame ID (see fourCC)
+     * @return the handler that parses the frames with the given ID, or nullptr if they are not supported
+     */
+    FrameHandler frameHandler(std::uint32_t t_id) noexcept;
 
 
     /**
@@ -457,20 +613,23 @@ namespace ID3 {
      * If it is valid, it proceeds by calling the prepareFrameData function, which calls the the readFrame function,
      * reads the frame data, and edits the data buffer so that it can be parsed (synchronization and decompression are
      * examples of things that need to be done before the data can be read.
-     * After that the data is parsed and saved in the respective member variable in the Song object.
+     * After that the data is parsed by the handler registered for the frame ID (see registerFrameHandler),
+     * which saves it in the respective member variable in the Song object. Frames without a handler are skipped.
      *
      * If it is not, there has either been a mistake, or there is only padding left.
      *
      * See: {@link https://id3.org/id3v2.4.0-frames} for all frames
      *
-     * @param t_handler        A reference to the file handler object for this file to pass it on to the readFrame function
+     * @param t_tag            A view of the tag buffer to pass it on to the readFrame function
      * @param t_frame_header   A reference to the frame header struct for this frame
-     * @param t_position       A reference to the position of the file pointer to pass it on the readFrame function
+     * @param t_position       A reference to the position in the tag buffer to pass it on the readFrame function
      * @param t_song           A reference to the current song object to set the song data
+     * @param t_options        The options for parsing the tag
+     * @param t_context        The context of the parse, shared by all frames of the tag
      *
      * @return true if the frame is not padding frame, false if it is
      */
-    bool parseFrame(Filehandler& t_handler, FrameHeader& t_frame_header, std::uint32_t& t_position, Song& t_song) noexcept;
+    bool parseFrame(std::span<const char> t_tag, FrameHeader& t_frame_header, std::uint32_t& t_position, Song& t_song, const ParseOptions& t_options, ParseContext& t_context) noexcept;
 
 
     /**
@@ -480,20 +639,65 @@ namespace ID3 {
      * This function reverses that scheme, so if there is a 0x00 byte after a 0xff,
      * it is removed.
      *
+     * The data is synchronized in a single pass, the 0xff bytes are searched with memchr (which
+     * is vectorized) and the runs of bytes in between are moved as a whole.
      *
      * See https://id3.org/id3v2.4.0-structure section 6.1 for more information.
      *
-     * @param  t_data A reference to a std::unique_ptr of an std::vector<char> with data that is supposed to be synchronized
+     * @param t_data   The unsynchronized data
+     * @param t_output Output for the synchronized data, which is at most as large as the input.
+     *                 It may be the same buffer as the input, the data is synchronized in place then.
+     *
+     * @return the number of bytes written to the output
+     */
+    std::size_t synchronize(std::span<const char> t_data, char t_output[]) noexcept;
+
+
+    /**
+     * Synchronizes unsynchronized data in place (see above).
+     *
+     * @param  t_data A reference to a vector with data that is supposed to be synchronized, it is shrunk to the synchronized size
      */
     void synchronize(std::vector<char>& t_data) noexcept;
 
 
+    /**
+     * Walks over all frames of a tag that has already been read into memory and
+     * parses them into the song object.
+     *
+     * The buffer is expected to contain everything that follows the 10 byte tag header
+     * (so the extended header, the frames and the padding), which means that positions
+     * in the buffer are offset by SIZE_OF_HEADER relative to the start of the file.
+     *
+     * If the tag is unsynchronised (bit 7 of the flags), an ID3v2.3 tag is synchronized as a whole
+     * before its frames are read, in an ID3v2.4 tag every frame is synchronized on its own.
+     *
+     * @param t_tag     A view of the tag buffer
+     * @param t_version The major version of the tag
+     * @param t_flags   The flags of the tag header
+     * @param t_song    A reference to the current song object to set the song data
+     * @param t_context The context of the parse
+     * @param t_options The options for parsing the tag
+     */
+    void parseTag(std::span<const char> t_tag, const std::uint8_t t_version, const std::uint8_t t_flags, Song& t_song, ParseContext& t_context, const ParseOptions& t_options = {}) noexcept;
+
+
+    /**
+     * Parses a tag with a context of its own (see above).
+     */
+    void parseTag(std::span<const char> t_tag, const std::uint8_t t_version, const std::uint8_t t_flags, Song& t_song, const ParseOptions& t_options = {}) noexcept;
+
+
     /**
      * Function to extract ID3 encapsulated metadata from an mp3 file.
      *
-     * @param t_song is a reference to a song object that represents the mp3 file.
+     * The tag header is read first, after that the whole tag is read into a single
+     * buffer with one read, and the frames are parsed from memory.
+     *
+     * @param t_song    is a reference to a song object that represents the mp3 file.
+     * @param t_options are the options for parsing the tag
      */
-    void readID3(Song& t_song) noexcept;
+    void readID3(Song& t_song, const ParseOptions& t_options = {}) noexcept;
 }
 
 
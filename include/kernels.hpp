@@ -0,0 +1,44 @@
+/******************************************************************************
+* File:             kernels.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Vectorized inner loops of the filterbanks of MPEG audio layer 3
+*****************************************************************************/
+
+
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <dsp.hpp>
+
+
+namespace MP3::DSP {
+
+    /**
+     * Implementations of the inner loops of the filterbanks for one instruction set.
+     *
+     * All products are accumulated with 64 bits, so every implementation returns exactly the
+     * same results as the scalar one.
+     *
+     * transform: Multiplies a matrix (t_rows x t_columns, row major) with a vector and shifts the
+     *            results by COEFFICIENT_BITS (IMDCT and matrixing of the synthesis)
+     * window:    Windows the V vector of the synthesis (see Synthesis) into 32 samples, t_offset has
+     *            to be a multiple of 64
+     */
+    struct Kernels {
+        void (*transform)(const std::int32_t* t_matrix, const sample* t_input, std::size_t t_rows, std::size_t t_columns, sample* t_output) noexcept;
+        void (*window)(const sample* t_v, std::size_t t_offset, const std::int32_t* t_window, sample* t_output) noexcept;
+    };
+
+
+    /**
+     * @param t_kernel The instruction set
+     * @return the implementations for the instruction set, nullptr if it is not supported by this build or CPU
+     */
+    const Kernels* kernels(Kernel t_kernel) noexcept;
+}
+
+#endif /* ifndef KERNELS_HPP */
@@ -0,0 +1,57 @@
+/******************************************************************************
+* File:             library.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      File that contains code to scan a music library
+*****************************************************************************/
+
+#ifndef LIBRARY_HPP
+#define LIBRARY_HPP
+
+#include <filesystem>
+#include <cache.hpp>
+#include <song.hpp>
+
+namespace Library {
+
+    // number of files that are parsed by one task of the thread pool
+    constexpr std::size_t FILES_PER_TASK = 16;
+
+
+    /**
+     * Checks whether a file is an mp3 file, based on the extension (case insensitive).
+     *
+     * @param t_path The path to the file
+     * @return true if the file has an .mp3 extension, false otherwise
+     */
+    bool isMP3(const std::filesystem::path& t_path) noexcept;
+
+
+    /**
+     * Recursively collects the paths of all mp3 files in a directory.
+     * Directories that can't be read are skipped.
+     *
+     * @param t_root The directory that should be searched
+     * @return the sorted paths of all mp3 files in the directory
+     */
+    std::vector<std::string> findFiles(const std::string& t_root) noexcept;
+
+
+    /**
+     * Creates a song for every mp3 file in a directory (and its subdirectories) and
+     * reads the ID3 tags of all of them, spread across all cores.
+     *
+     * If a cache is passed, songs whose files have not changed since they have been cached
+     * are taken from the cache, only the other files are parsed (and added to the cache afterwards).
+     *
+     * @param t_root    The directory that should be scanned
+     * @param t_threads The number of threads that should be used, one per core if this is 0
+     * @param t_cache   A pointer to the metadata cache, or nullptr if every file should be parsed
+     *
+     * @return a std::vector that contains the songs, sorted by path
+     */
+    std::vector<Song> scan(const std::string& t_root, std::size_t t_threads = 0, MetadataCache* t_cache = nullptr);
+}
+
+#endif /* ifndef LIBRARY_HPP */
@@ -0,0 +1,344 @@
+/******************************************************************************
+* File:             mp3.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      File responsible for dealing with MPEG audio frames.
+*****************************************************************************/
+
+
+#ifndef MP3_HPP
+#define MP3_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include <song.hpp>
+
+
+namespace MP3 {
+
+    using byte = std::uint8_t;
+
+
+    // constants
+    constexpr byte SIZE_OF_HEADER = 4;
+
+
+    // list of MPEG versions, the value is the version id stored in the frame header
+    typedef enum {
+
+        MPEG_25 = 0x00,
+        MPEG_2  = 0x02,
+        MPEG_1  = 0x03
+
+    } Version;
+
+
+    // list of channel modes, the value is the channel mode stored in the frame header
+    typedef enum {
+
+        STEREO       = 0x00,
+        JOINT_STEREO = 0x01,
+        DUAL_CHANNEL = 0x02,
+        MONO         = 0x03
+
+    } ChannelMode;
+
+
+    /**
+     * Struct containing the data of an MPEG audio frame header.
+     *
+     * version:         The MPEG version (see Version)
+     * layer:           The layer (1, 2 or 3)
+     * crc:             true if the header is followed by a 16 bit CRC
+     * bitrate:         The bitrate in kbit/s
+     * sample_rate:     The sample rate in Hz
+     * padding:         true if the frame is padded with one slot
+     * channel_mode:    The channel mode (see ChannelMode)
+     * mode_extension:  The mode extension (joint stereo only)
+     * size:            The size of the frame in bytes, including the header
+     * samples:         The number of samples per channel in the frame
+     */
+    struct FrameHeader {
+        Version version;
+        byte layer;
+        bool crc;
+        std::uint16_t bitrate;
+        std::uint32_t sample_rate;
+        bool padding;
+        ChannelMode channel_mode;
+        byte mode_extension;
+        std::uint16_t size;
+        std::uint16_t samples;
+
+        /**
+         * @return the number of channels
+         */
+        inline byte channels() const noexcept {
+            return channel_mode == MONO ? 1 : 2;
+        }
+    };
+
+
+    /**
+     * Parses the 4 bytes of an MPEG audio frame header.
+     *
+     * Headers with reserved values and free format headers (bitrate index 0) are rejected,
+     * since the size of the frame can't be determined from the header alone.
+     *
+     * @param t_data A view of the data that starts with the frame header
+     * @return the parsed frame header, or an empty optional if the data doesn't start with a valid header
+     */
+    std::optional<FrameHeader> parseHeader(std::span<const char> t_data) noexcept;
+
+
+    /**
+     * @param t_header The header of a layer 3 frame
+     * @return the size of the side information of the frame in bytes
+     */
+    std::size_t sideInformationSize(const FrameHeader& t_header) noexcept;
+
+
+    /**
+     * Searches for the next frame.
+     *
+     * A single valid header is not enough to be sure to have found a frame, since the sync word
+     * can appear anywhere in audio data or a picture, so a candidate is only accepted if it is
+     * followed by another header of the same stream or the end of the data.
+     *
+     * @param t_data     A view of the audio data
+     * @param t_position The position in the data where the search starts
+     *
+     * @return the position of the next frame, or the size of the data if there is none
+     */
+    std::size_t findFrame(std::span<const char> t_data, std::size_t t_position) noexcept;
+
+
+    /**
+     * Struct containing the data of a VBR header (Xing, Info or VBRI) stored in the first frame of a stream
+     * in place of audio data, along with the encoder delay and padding of a LAME extension.
+     *
+     * frames:            The number of audio frames, not including the frame that contains the header
+     * bytes:             The number of bytes of the stream, including the frame that contains the header (0 if unknown)
+     * toc:               Seek table, entry i is the position of i% of the duration in 1/256 of bytes
+     * has_toc:           true if the header contains a seek table
+     * delay:             The number of samples the encoder put in front of the audio
+     * padding:           The number of samples the encoder appended to the audio
+     * sample_rate:       The sample rate in Hz
+     * samples_per_frame: The number of samples per channel in each frame
+     * header_size:       The size of the frame that contains the header, which is not an audio frame
+     */
+    struct VBRHeader {
+        std::uint32_t frames = 0;
+        std::uint32_t bytes = 0;
+        std::array<byte, 100> toc{};
+        bool has_toc = false;
+        std::uint16_t delay = 0;
+        std::uint16_t padding = 0;
+        std::uint32_t sample_rate = 0;
+        std::uint16_t samples_per_frame = 0;
+        std::uint16_t header_size = 0;
+
+        /**
+         * @return the number of samples per channel, without encoder delay and padding
+         */
+        std::uint64_t samples() const noexcept;
+
+        /**
+         * @return the duration of the stream in milliseconds, without encoder delay and padding
+         */
+        std::uint64_t duration() const noexcept;
+
+        /**
+         * Approximates the position of a point in time using the seek table,
+         * or assuming a constant bitrate if there is none.
+         *
+         * @param t_ms The point in time in milliseconds
+         * @return the position relative to the start of the frame that contains the header
+         */
+        std::uint64_t seek(std::uint64_t t_ms) const noexcept;
+    };
+
+
+    /**
+     * Parses the VBR header (Xing, Info or VBRI) of a frame, and the LAME extension if there is one.
+     *
+     * @param t_frame A view of the data that starts with the frame header
+     * @return the parsed VBR header, or an empty optional if the frame does not contain one
+     */
+    std::optional<VBRHeader> parseVBRHeader(std::span<const char> t_frame) noexcept;
+
+
+    /**
+     * Calculates the duration of a stream without walking all frames, using the VBR header
+     * of the first frame, or the bitrate of the first frame if there is no VBR header
+     * (which is exact for files with a constant bitrate).
+     *
+     * @param t_data A view of the audio data
+     * @return the duration in milliseconds, or 0 if there is no frame
+     */
+    std::uint64_t estimateDuration(std::span<const char> t_data) noexcept;
+
+
+    /**
+     * Index of the positions of all frames in the audio data of a file.
+     *
+     * The index is built by walking the frame headers, without decoding anything, and allows to
+     * get the exact duration and the position of the frame that contains a point in time.
+     * To keep the index small, only the size of each frame (2 bytes) is stored, along with the
+     * absolute offset of every CHECKPOINT_INTERVALth frame and of every frame that follows garbage.
+     *
+     * Member variables:
+     *  m_checkpoints:       Frames whose offset is stored, sorted by the number of the frame
+     *  m_sizes:             Size of every frame in bytes
+     *  m_sample_rate:       The sample rate of the stream in Hz
+     *  m_samples_per_frame: The number of samples per channel in each frame
+     */
+    class FrameIndex
+    {
+    public:
+
+        static constexpr std::size_t CHECKPOINT_INTERVAL = 64;
+
+
+        FrameIndex() = default;
+
+
+        /**
+         * Builds the index of the frames in a view of the audio data.
+         *
+         * Garbage between frames is skipped, frames that don't belong to the stream of the
+         * first frame (different version, layer or sample rate) are treated as garbage.
+         * If the first frame holds a VBR header (Xing, Info, VBRI), it is not part of the index,
+         * as it does not contain any audio.
+         * The search stops at the end of the data or at the first point no frame follows,
+         * which is usually a trailing tag (ID3v1, APE).
+         *
+         * @param t_data   A view of the audio data
+         * @param t_offset The offset of the view relative to the start of the file
+         *
+         * @return the index
+         */
+        static FrameIndex scan(std::span<const char> t_data, std::uint64_t t_offset = 0) noexcept;
+
+
+        /**
+         * Builds the index of the frames of a song, starting at the audio data of the song (see Song::m_audio_start).
+         *
+         * @param t_song The song
+         * @return the index, which is empty if the file can't be read or does not contain any frames
+         */
+        static FrameIndex build(const Song& t_song) noexcept;
+
+
+        /**
+         * Appends the first frames of an index that has been scanned right after this one,
+         * used to build the index of a file window by window.
+         *
+         * @param t_other  The index, its offsets have to be relative to the start of the file as well
+         * @param t_frames The number of frames to append, at most t_other.frames()
+         */
+        void append(const FrameIndex& t_other, std::size_t t_frames) noexcept;
+
+
+        /**
+         * @return the offset of the first byte after the last frame, 0 if the index is empty
+         */
+        std::uint64_t end() const noexcept;
+
+
+        /**
+         * @return the number of frames
+         */
+        inline std::size_t frames() const noexcept {
+            return m_sizes.size();
+        }
+
+
+        /**
+         * @return true if there are no frames in the index, false otherwise
+         */
+        inline bool empty() const noexcept {
+            return m_sizes.empty();
+        }
+
+
+        /**
+         * @param t_frame The number of the frame, has to be less than frames()
+         * @return the offset of the frame relative to the start of the file
+         */
+        std::uint64_t offset(std::size_t t_frame) const noexcept;
+
+
+        /**
+         * @param t_frame The number of the frame, has to be less than frames()
+         * @return the size of the frame in bytes
+         */
+        inline std::uint16_t size(std::size_t t_frame) const noexcept {
+            return m_sizes[t_frame];
+        }
+
+
+        /**
+         * @return the sample rate of the stream in Hz
+         */
+        inline std::uint32_t sampleRate() const noexcept {
+            return m_sample_rate;
+        }
+
+
+        /**
+         * @return the number of samples per channel in each frame
+         */
+        inline std::uint16_t samplesPerFrame() const noexcept {
+            return m_samples_per_frame;
+        }
+
+
+        /**
+         * @return the total number of samples per channel
+         */
+        inline std::uint64_t samples() const noexcept {
+            return m_sizes.size() * m_samples_per_frame;
+        }
+
+
+        /**
+         * @return the duration of the stream in milliseconds
+         */
+        std::uint64_t duration() const noexcept;
+
+
+        /**
+         * Finds the frame that contains a point in time.
+         *
+         * @param t_ms The point in time in milliseconds
+         * @return the number of the frame, or frames() if the point in time is after the end of the stream
+         */
+        std::size_t frameAt(std::uint64_t t_ms) const noexcept;
+
+
+    private:
+
+        /**
+         * Frame whose offset is stored in the index.
+         *
+         * frame:  The number of the frame
+         * offset: The offset of the frame relative to the start of the file
+         */
+        struct Checkpoint {
+            std::size_t frame;
+            std::uint64_t offset;
+        };
+
+        std::vector<Checkpoint> m_checkpoints;
+        std::vector<std::uint16_t> m_sizes;
+        std::uint32_t m_sample_rate = 0;
+        std::uint16_t m_samples_per_frame = 0;
+    };
+}
+
+#endif /* ifndef MP3_HPP */
@@ -35,19 +35,67 @@ namespace ID3 {
 
     } PictureType;
 
+    /**
+     * Picture embedded in an APIC frame.
+     *
+     * The picture data is either loaded right away (m_data is set), or only the location
+     * of the data in the file is recorded and the data is loaded the first time it is
+     * needed (see data()), which keeps pictures out of memory while scanning a library.
+     */
     class Picture
     {
     public:
         Picture(std::shared_ptr<std::vector<char>> t_data, std::string t_mime_type, ID3::PictureType t_pic_type) noexcept;
 
+        /**
+         * Creates a picture that only records where its data is stored.
+         *
+         * @param t_path      The path to the file that contains the picture
+         * @param t_offset    The offset of the picture data relative to the start of the file
+         * @param t_size      The size of the picture data in bytes
+         * @param t_mime_type The MIME type of the picture
+         * @param t_pic_type  The type of picture (see PictureType)
+         */
+        Picture(std::string t_path, std::uint32_t t_offset, std::uint32_t t_size, std::string t_mime_type, ID3::PictureType t_pic_type) noexcept;
+
         Picture(const Picture&) = default;
         Picture& operator=(const Picture&) = default;
         Picture(Picture &&) = default;
         Picture& operator=(Picture &&) = default;
 
 
-        // picture data
-        std::shared_ptr<std::vector<char>> m_data;
+        /**
+         * Returns the picture data, loading it from the file (through a memory mapping)
+         * if that has not happened yet.
+         *
+         * If the hash of the picture is known, the data is shared with every
+         * other picture with the same content (see ArtStore).
+         * Pictures whose data is not stored in the file as is (m_offset is 0, but m_path is set, e.g.
+         * when they come from the metadata cache) are loaded by parsing the tag of the file again
+         * and taking the picture with the same hash.
+         *
+         * @return a shared pointer to the picture data, or nullptr if the data
+         *         is not loaded and can't be loaded from the file
+         */
+        std::shared_ptr<std::vector<char>> data() const;
+
+
+        /**
+         * Releases the picture data if it can be loaded from the file again.
+         */
+        void unload() noexcept;
+
+
+        /**
+         * @return true if the picture data is in memory, false otherwise
+         */
+        inline bool isLoaded() const noexcept {
+            return m_data != nullptr;
+        }
+
+
+        // picture data, nullptr until the data is loaded if the picture is loaded lazily
+        mutable std::shared_ptr<std::vector<char>> m_data;
 
         // MIME type
         std::string m_mime_type;
@@ -55,6 +103,20 @@ namespace ID3 {
         // type of picture (see PictureType)
         ID3::PictureType m_pic_type;
 
+        // path to the file that contains the picture, empty if the picture can't be loaded from a file
+        std::string m_path;
+
+        // offset of the picture data relative to the start of the file,
+        // 0 if the data is not stored in the file as is (e.g. unsynchronised frames),
+        // the tag is parsed again to load the data then
+        std::uint32_t m_offset = 0;
+
+        // size of the picture data in bytes
+        std::uint32_t m_size = 0;
+
+        // hash of the picture data (see ArtStore::hash()), 0 if unknown
+        std::uint64_t m_hash = 0;
+
     };
 }
 
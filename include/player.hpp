@@ -0,0 +1,120 @@
+/******************************************************************************
+* File:             player.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Playback of a playlist into an audio sink
+*****************************************************************************/
+
+
+#ifndef PLAYER_HPP
+#define PLAYER_HPP
+
+#include <future>
+#include <memory>
+#include <vector>
+#include <sink.hpp>
+#include <song.hpp>
+#include <stream.hpp>
+
+
+/**
+ * Plays the songs of a playlist one after another without gaps.
+ *
+ * The decoded frames are passed to the sink in blocks of BLOCK_FRAMES frames, through a BufferedSink,
+ * so the sink is written on an output thread and a slow sink does not stall decoding. When a song
+ * ends within a block, the next song is opened and decoded right away and its first frames
+ * fill the rest of the block, so the songs are spliced sample by sample (see MP3::Stream for
+ * the removal of encoder delay and padding). The sink is only reopened between songs with
+ * different formats.
+ *
+ * Opening a song, parsing its tag and decoding the first frames can take long enough on
+ * slow storage to be audible, so this is done on a separate thread a number of seconds
+ * before the current song ends (read-ahead). PREFETCH_MS of the next song are decoded
+ * ahead of time, the rest is decoded when it is played.
+ *
+ * Member variables:
+ *  m_playlist:   The songs
+ *  m_output:     The output thread that passes the audio on to the sink
+ *  m_read_ahead: The number of seconds before the end of a song the next song is opened
+ *  m_current:    The index of the song that is playing
+ */
+class Player
+{
+public:
+
+    // the number of frames passed to the sink at once
+    static constexpr std::size_t BLOCK_FRAMES = BufferedSink::BLOCK_FRAMES;
+
+    // the number of seconds before the end of a song the next song is opened by default
+    static constexpr std::uint32_t READ_AHEAD = 5;
+
+    // the duration of the audio of the next song that is decoded ahead of time
+    static constexpr std::uint32_t PREFETCH_MS = 1000;
+
+
+    /**
+     * Class constructor.
+     *
+     * @param t_playlist   The songs, their tags are parsed when they are opened
+     * @param t_sink       The output, has to outlive the player
+     * @param t_read_ahead The number of seconds before the end of a song the next song is opened
+     */
+    Player(std::vector<Song> t_playlist, AudioSink& t_sink, std::uint32_t t_read_ahead = READ_AHEAD) noexcept;
+
+
+    /**
+     * Plays the playlist from the current song to the end, songs without audio are skipped.
+     */
+    void play() noexcept;
+
+
+    /**
+     * @return the index of the song that is playing, or the size of the playlist at the end
+     */
+    inline std::size_t current() const noexcept {
+        return m_current;
+    }
+
+
+    /**
+     * @return the songs
+     */
+    inline const std::vector<Song>& playlist() const noexcept {
+        return m_playlist;
+    }
+
+
+private:
+
+    /**
+     * An opened song.
+     *
+     * index:  The index of the song in the playlist, the size of the playlist if there is no song left
+     * stream: The stream of the song, nullptr if there is no song left
+     */
+    struct Track {
+        std::size_t index;
+        std::unique_ptr<MP3::Stream> stream;
+    };
+
+
+    /**
+     * Opens the first song with audio, starting at a song. Only touches the songs
+     * it opens, so it can run on another thread than the playback.
+     *
+     * @param t_index    The index of the song
+     * @param t_prefetch Whether the first PREFETCH_MS of the song should be decoded
+     *
+     * @return the opened song
+     */
+    Track open(std::size_t t_index, bool t_prefetch) noexcept;
+
+
+    std::vector<Song> m_playlist;
+    BufferedSink m_output;
+    std::uint32_t m_read_ahead;
+    std::size_t m_current = 0;
+};
+
+#endif /* ifndef PLAYER_HPP */
@@ -0,0 +1,149 @@
+/******************************************************************************
+* File:             ringbuffer.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Lock-free ring buffer of PCM frames
+*****************************************************************************/
+
+
+#ifndef RINGBUFFER_HPP
+#define RINGBUFFER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+
+/**
+ * Single-producer/single-consumer ring buffer of interleaved 16 bit PCM frames, passes
+ * decoded audio from a decoder thread to an output thread.
+ *
+ * Reading and writing never lock or allocate, the storage is allocated once by the
+ * constructor. Only whole frames are written and read, so the channels of the samples
+ * can't get out of step. The indices count frames and only grow, they are masked with
+ * the capacity (a power of two) to get the position in the storage.
+ *
+ * The indices of the producer and the consumer live on separate cache lines, together
+ * with the copy of the other index that the side has seen last. That way the two threads
+ * only touch each other's cache line when the buffer seems to be full or empty. The
+ * alignment of the class pads its size to whole cache lines, so nothing else shares the
+ * line of the consumer either.
+ *
+ * Member variables:
+ *  m_samples:     The storage, capacity * channels samples
+ *  m_capacity:    The number of frames the buffer can hold
+ *  m_channels:    The number of samples per frame
+ *  m_write:       The number of frames written so far, only changed by the producer
+ *  m_read_cache:  The last value of m_read the producer has seen
+ *  m_read:        The number of frames read so far, only changed by the consumer
+ *  m_write_cache: The last value of m_write the consumer has seen
+ */
+class RingBuffer
+{
+public:
+
+    // size of a cache line on the supported architectures
+    static constexpr std::size_t CACHE_LINE = 64;
+
+
+    /**
+     * Class constructor.
+     *
+     * @param t_frames   The minimum number of frames, rounded up to a power of two
+     * @param t_channels The number of samples per frame
+     */
+    RingBuffer(std::size_t t_frames, std::size_t t_channels);
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+
+    /**
+     * Writes as many whole frames as fit into the buffer, may only be called by the producer.
+     *
+     * @param t_samples The interleaved samples, a trailing partial frame is ignored
+     * @return the number of frames that have been written
+     */
+    std::size_t write(std::span<const std::int16_t> t_samples) noexcept;
+
+
+    /**
+     * Reads as many whole frames as are available and fit into the output, may only be called by the consumer.
+     *
+     * @param t_samples Output for the interleaved samples
+     * @return the number of frames that have been read
+     */
+    std::size_t read(std::span<std::int16_t> t_samples) noexcept;
+
+
+    /**
+     * @return the number of frames that can be read, a lower bound for the consumer (the producer may write
+     *         more frames in the meantime) and an upper bound for the producer (the consumer may read frames)
+     */
+    inline std::size_t available() const noexcept {
+        return m_write.load(std::memory_order_acquire) - m_read.load(std::memory_order_acquire);
+    }
+
+
+    /**
+     * @return the number of frames that can be written, a lower bound for the producer (the consumer may read
+     *         more frames in the meantime) and an upper bound for the consumer (the producer may write frames)
+     */
+    inline std::size_t space() const noexcept {
+        return m_capacity - available();
+    }
+
+
+    /**
+     * @return the number of frames the buffer can hold
+     */
+    inline std::size_t capacity() const noexcept {
+        return m_capacity;
+    }
+
+
+    /**
+     * @return the number of samples per frame
+     */
+    inline std::size_t channels() const noexcept {
+        return m_channels;
+    }
+
+
+private:
+
+    /**
+     * Copies frames into the storage, in two parts if the range wraps around.
+     *
+     * @param t_index   The index of the first frame
+     * @param t_frames  The number of frames
+     * @param t_samples The interleaved samples of the frames
+     */
+    void store(std::size_t t_index, std::size_t t_frames, const std::int16_t* t_samples) noexcept;
+
+
+    /**
+     * Copies frames out of the storage, in two parts if the range wraps around.
+     *
+     * @param t_index   The index of the first frame
+     * @param t_frames  The number of frames
+     * @param t_samples Output for the interleaved samples of the frames
+     */
+    void load(std::size_t t_index, std::size_t t_frames, std::int16_t* t_samples) const noexcept;
+
+
+    std::unique_ptr<std::int16_t[]> m_samples;
+    std::size_t m_capacity;
+    std::size_t m_channels;
+
+    alignas(CACHE_LINE) std::atomic<std::size_t> m_write{0};
+    std::size_t m_read_cache = 0;
+
+    alignas(CACHE_LINE) std::atomic<std::size_t> m_read{0};
+    std::size_t m_write_cache = 0;
+};
+
+#endif /* ifndef RINGBUFFER_HPP */
@@ -0,0 +1,296 @@
+/******************************************************************************
+* File:             sink.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Outputs for decoded audio
+*****************************************************************************/
+
+
+#ifndef SINK_HPP
+#define SINK_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include <ringbuffer.hpp>
+
+
+/**
+ * Output for interleaved 16 bit PCM frames.
+ *
+ * A sink is opened with the format of the audio, then the frames are written and the sink
+ * is closed. Writing may block (e.g. a device sink that waits for its buffer to drain), the
+ * frames that have been passed are consumed entirely unless an error occurs. BufferedSink
+ * moves the writes to another sink onto an output thread, so that a slow sink does not stall decoding.
+ */
+class AudioSink
+{
+public:
+
+    virtual ~AudioSink() = default;
+
+
+    /**
+     * Prepares the sink for audio of a format, a sink that is open already switches to
+     * the new format if it can.
+     *
+     * @param t_sample_rate The sample rate in Hz
+     * @param t_channels    The number of samples per frame
+     *
+     * @return true if the sink accepts the format, false otherwise
+     */
+    virtual bool open(std::uint32_t t_sample_rate, std::uint32_t t_channels) noexcept = 0;
+
+
+    /**
+     * Outputs frames.
+     *
+     * @param t_samples The interleaved samples, a whole number of frames
+     * @return the number of frames that have been consumed
+     */
+    virtual std::size_t write(std::span<const std::int16_t> t_samples) noexcept = 0;
+
+
+    /**
+     * Finishes the output, the sink can be opened again afterwards.
+     */
+    virtual void close() noexcept = 0;
+
+
+    /**
+     * @return the sample rate of the sink, 0 if it is not open
+     */
+    inline std::uint32_t sampleRate() const noexcept {
+        return m_sample_rate;
+    }
+
+
+    /**
+     * @return the number of samples per frame, 0 if the sink is not open
+     */
+    inline std::uint32_t channels() const noexcept {
+        return m_channels;
+    }
+
+
+protected:
+    std::uint32_t m_sample_rate = 0;
+    std::uint32_t m_channels = 0;
+};
+
+
+/**
+ * Sink that discards the audio, but counts the frames and measures the time between opening
+ * and closing, so that the speed of decoding can be measured without an audio device.
+ *
+ * Member variables:
+ *  m_frames:  The number of frames written since the sink has been opened
+ *  m_audio:   The duration of the audio written in µs
+ *  m_start:   The time the sink has been opened
+ *  m_stop:    The time the sink has been closed
+ *  m_open:    Whether the sink is open
+ */
+class NullSink : public AudioSink
+{
+public:
+
+    bool open(std::uint32_t t_sample_rate, std::uint32_t t_channels) noexcept override;
+
+    std::size_t write(std::span<const std::int16_t> t_samples) noexcept override;
+
+    void close() noexcept override;
+
+
+    /**
+     * @return the number of frames that have been written
+     */
+    inline std::uint64_t frames() const noexcept {
+        return m_frames;
+    }
+
+
+    /**
+     * @return the duration of the audio that has been written in ms, format changes are taken into account
+     */
+    inline std::uint64_t duration() const noexcept {
+        return m_audio / 1000;
+    }
+
+
+    /**
+     * @return the wall clock time since the sink has been opened in ms, until it has been closed
+     */
+    std::uint64_t elapsed() const noexcept;
+
+
+    /**
+     * @return the wall clock time divided by the duration of the audio, below 1 means faster than real time
+     */
+    double realTimeFactor() const noexcept;
+
+
+private:
+    std::uint64_t m_frames = 0;
+    std::uint64_t m_audio = 0;
+    std::chrono::steady_clock::time_point m_start{};
+    std::chrono::steady_clock::time_point m_stop{};
+    bool m_open = false;
+};
+
+
+/**
+ * Sink that writes a RIFF/WAVE file with 16 bit PCM samples.
+ *
+ * The sizes in the header are written when the sink is closed, since they are not known
+ * before. A file has a single format, so the format can't change while the sink is open.
+ *
+ * Member variables:
+ *  m_path:   The path of the file
+ *  m_stream: The stream of the open file
+ *  m_bytes:  The number of bytes of samples written so far
+ *  m_buffer: Buffer for converting samples to little endian
+ */
+class WAVSink : public AudioSink
+{
+public:
+
+    // size of the RIFF, fmt and data chunk headers
+    static constexpr std::size_t SIZE_OF_HEADER = 44;
+
+
+    /**
+     * Class constructor.
+     *
+     * @param t_path The path of the file, an existing file is overwritten when the sink is opened
+     */
+    explicit WAVSink(std::string t_path) noexcept;
+
+
+    /**
+     * Class destructor, closes the file if it is still open.
+     */
+    ~WAVSink() override;
+
+
+    bool open(std::uint32_t t_sample_rate, std::uint32_t t_channels) noexcept override;
+
+    std::size_t write(std::span<const std::int16_t> t_samples) noexcept override;
+
+    void close() noexcept override;
+
+
+private:
+
+    /**
+     * Writes the header, with the sizes of the data written so far.
+     */
+    void writeHeader() noexcept;
+
+
+    std::string m_path;
+    std::ofstream m_stream;
+    std::uint64_t m_bytes = 0;
+    std::vector<char> m_buffer;
+};
+
+/**
+ * Sink that passes the audio on to another sink on an output thread.
+ *
+ * write copies the frames into a RingBuffer and returns, the output thread drains the ring
+ * into the other sink in blocks of BLOCK_FRAMES frames, so the decoder thread only waits if
+ * the ring is full. Only the frames that are left when the ring is drained (see open and close)
+ * are passed on in a smaller block. Neither side
+ * takes a lock: a side that has to wait (full or empty ring) sleeps on the progress counter
+ * of the other side with std::atomic::wait, which is only notified when something has been
+ * written or read.
+ *
+ * The other sink is only used by the output thread while the sink is open. Opening and closing
+ * first drain the ring and join the output thread, so the other sink is opened and closed on
+ * the thread that calls them and a format change takes effect after the audio of the old format.
+ * Frames that the other sink does not consume (e.g. because of a write error) are dropped.
+ *
+ * Member variables:
+ *  m_target:   The sink the audio is passed on to
+ *  m_capacity: The number of frames the ring can hold
+ *  m_buffer:   The ring, allocated when the sink is opened with a different number of channels
+ *  m_output:   The output thread, only runs while the sink is open
+ *  m_block:    The frames the output thread has read from the ring
+ *  m_produced: Incremented when frames have been written to the ring, or the output thread should stop
+ *  m_consumed: Incremented when frames have been read from the ring
+ *  m_stop:     Set when the output thread should stop once the ring is empty
+ */
+class BufferedSink : public AudioSink
+{
+public:
+
+    // the number of frames the ring holds by default, about 190 ms at 44.1 kHz
+    static constexpr std::size_t BUFFER_FRAMES = 8192;
+
+    // the number of frames the output thread passes to the other sink at once
+    static constexpr std::size_t BLOCK_FRAMES = 1152;
+
+
+    /**
+     * Class constructor.
+     *
+     * @param t_target The sink the audio is passed on to, has to outlive this sink
+     * @param t_frames The minimum number of frames the ring can hold (see RingBuffer), at least BLOCK_FRAMES
+     */
+    explicit BufferedSink(AudioSink& t_target, std::size_t t_frames = BUFFER_FRAMES) noexcept;
+
+    BufferedSink(const BufferedSink&) = delete;
+    BufferedSink& operator=(const BufferedSink&) = delete;
+
+
+    /**
+     * Class destructor, closes the sink if it is still open.
+     */
+    ~BufferedSink() override;
+
+
+    bool open(std::uint32_t t_sample_rate, std::uint32_t t_channels) noexcept override;
+
+    /**
+     * Writes the frames to the ring, waits for the output thread while the ring is full.
+     *
+     * @param t_samples The interleaved samples, a whole number of frames
+     * @return the number of frames that have been written to the ring
+     */
+    std::size_t write(std::span<const std::int16_t> t_samples) noexcept override;
+
+    void close() noexcept override;
+
+
+private:
+
+    /**
+     * Main loop of the output thread.
+     */
+    void output() noexcept;
+
+
+    /**
+     * Waits until the output thread has drained the ring and joins it.
+     */
+    void drain() noexcept;
+
+
+    AudioSink& m_target;
+    std::size_t m_capacity;
+    std::unique_ptr<RingBuffer> m_buffer;
+    std::thread m_output;
+    std::vector<std::int16_t> m_block;
+
+    std::atomic<std::uint32_t> m_produced{0};
+    std::atomic<std::uint32_t> m_consumed{0};
+    std::atomic<bool> m_stop{false};
+};
+
+#endif /* ifndef SINK_HPP */
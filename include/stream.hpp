@@ -0,0 +1,234 @@
+/******************************************************************************
+* File:             stream.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Decoding of the audio of a song
+*****************************************************************************/
+
+
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <decoder.hpp>
+#include <filehandler.hpp>
+#include <mp3.hpp>
+#include <song.hpp>
+
+
+namespace MP3 {
+
+    /**
+     * Decodes the audio of a song into PCM frames, with the samples that are not part of the
+     * audio removed, so that consecutive songs can be spliced without a gap.
+     *
+     * If the first frame holds a VBR header with a LAME extension, the encoder delay plus the
+     * delay of the decoder are dropped from the start and the padding from the end. The delay
+     * of the song (TDLY) is played as silence in front of the audio.
+     *
+     * The file is not loaded as a whole, the frames are decoded from a window of WINDOW_SIZE
+     * bytes that is refilled from the file, so the memory used doesn't depend on the size of
+     * the file (apart from the frame index, which takes 2 bytes per frame once seek is used).
+     *
+     * Member variables:
+     *  m_handler:       The file
+     *  m_file_size:     The size of the file in bytes
+     *  m_window:        The window of the file the frames are decoded from
+     *  m_window_start:  The offset of the window in the file
+     *  m_position:      The offset of the next frame in the file
+     *  m_decoder:       The decoder
+     *  m_pcm:           The samples of the last decoded frame
+     *  m_pcm_start:     The first frame in m_pcm that has not been read yet
+     *  m_pcm_end:       The number of frames in m_pcm
+     *  m_ahead:         Samples that have been decoded ahead of time (see prefetch)
+     *  m_ahead_start:   The first sample in m_ahead that has not been read yet
+     *  m_silence:       The number of frames of silence that are left to be read
+     *  m_skip:          The number of decoded frames that are left to be dropped
+     *  m_remaining:     The number of frames that are left to be read, UINT64_MAX if unknown
+     *  m_first:         The offset of the first audio frame in the file
+     *  m_delay:         The number of decoded frames dropped at the start (encoder and decoder delay)
+     *  m_lead:          The number of frames of silence played in front of the audio
+     *  m_total:         The number of frames of audio without delay and padding, UINT64_MAX if unknown
+     *  m_index:         The frame index, empty until the first seek
+     *  m_sample_rate:   The sample rate of the first frame
+     *  m_channels:      The number of channels of the first frame
+     *  m_frame_size:    The size of the last decoded frame in bytes, to estimate the remaining frames
+     *  m_frame_samples: The number of samples per channel of the last decoded frame
+     */
+    class Stream
+    {
+    public:
+
+        // samples of delay of the decoder (the filterbanks), dropped along with the encoder delay
+        static constexpr std::uint64_t DECODER_DELAY = 529;
+
+        // size of the window of the file the frames are decoded from
+        static constexpr std::size_t WINDOW_SIZE = 64 * 1024;
+
+        // bytes that have to be in the window after a frame for it to be decoded: the largest frame
+        // (layer 2, 384 kbit/s at 32 kHz, padded) and the header of the frame after it, twice to
+        // validate a frame found while resyncing
+        static constexpr std::size_t LOOKAHEAD = 2 * (1729 + SIZE_OF_HEADER);
+
+
+        /**
+         * Class constructor, opens the file and decodes the first frame.
+         *
+         * @param t_song The song, the tag has to be parsed already (see ID3::readID3)
+         */
+        explicit Stream(const Song& t_song) noexcept;
+
+        Stream(const Stream&) = delete;
+        Stream& operator=(const Stream&) = delete;
+
+
+        /**
+         * Reads decoded frames.
+         *
+         * Frames that have a different format than the first frame (which is not allowed in a
+         * file, but happens with damaged files) are dropped.
+         *
+         * @param t_pcm Output for the interleaved samples
+         * @return the number of frames that have been written, less than fit only at the end
+         */
+        std::size_t read(std::span<std::int16_t> t_pcm) noexcept;
+
+
+        /**
+         * Decodes frames ahead of time, so that reading them later is cheap.
+         *
+         * @param t_frames The number of frames
+         * @return the number of frames that have been decoded, less than requested only at the end
+         */
+        std::size_t prefetch(std::size_t t_frames) noexcept;
+
+
+        /**
+         * Estimates the number of frames that are left to be read, exact for songs with a LAME
+         * extension and songs with a constant bitrate.
+         *
+         * @return the number of frames
+         */
+        std::uint64_t remaining() const noexcept;
+
+
+        /**
+         * Moves to a point in time, the next frame that is read is the one at that time.
+         *
+         * The output is sample accurate: decoding starts early enough that the frame before the target
+         * frame (which fills the overlap of the filterbanks) finds its main data in the bit reservoir.
+         *
+         * @param t_ms The point in time in ms, relative to the start of the silence in front of the audio
+         * @return false if there is no audio to seek in, the position is unchanged then
+         */
+        bool seek(std::uint64_t t_ms) noexcept;
+
+
+        /**
+         * @return true if the file contains audio
+         */
+        inline bool valid() const noexcept {
+            return m_channels != 0;
+        }
+
+
+        /**
+         * @return true if every frame has been read
+         */
+        inline bool finished() const noexcept {
+            return m_ahead_start == m_ahead.size() && m_silence == 0 && m_pcm_start == m_pcm_end && (m_remaining == 0 || m_position >= m_file_size);
+        }
+
+
+        /**
+         * @return the sample rate of the audio in Hz
+         */
+        inline std::uint32_t sampleRate() const noexcept {
+            return m_sample_rate;
+        }
+
+
+        /**
+         * @return the number of samples per frame
+         */
+        inline std::uint32_t channels() const noexcept {
+            return m_channels;
+        }
+
+
+    private:
+
+        /**
+         * Makes sure the window holds LOOKAHEAD bytes from a position on (or the rest of the file),
+         * refilling it starting at that position if it doesn't.
+         *
+         * @param t_position The offset in the file
+         * @return a view of the window from the position to the end of the window, empty at the end of the file
+         */
+        std::span<const char> input(std::uint64_t t_position) noexcept;
+
+
+        /**
+         * Moves m_position to the next frame at or after it.
+         *
+         * @return false if there is no frame left in the file
+         */
+        bool sync() noexcept;
+
+
+        /**
+         * Reads frames without the ones that have been decoded ahead of time.
+         *
+         * @param t_pcm Output for the interleaved samples
+         * @return the number of frames that have been written
+         */
+        std::size_t decodeInto(std::span<std::int16_t> t_pcm) noexcept;
+
+
+        /**
+         * Decodes frames until one of them yields frames that are not dropped, or the end is reached.
+         *
+         * @return true if there are frames in m_pcm
+         */
+        bool decode() noexcept;
+
+
+        Filehandler m_handler;
+        std::uint64_t m_file_size = 0;
+
+        std::vector<char> m_window;
+        std::uint64_t m_window_start = 0;
+        std::uint64_t m_position = 0;
+
+        Decoder m_decoder;
+
+        std::vector<std::int16_t> m_pcm;
+        std::size_t m_pcm_start = 0;
+        std::size_t m_pcm_end = 0;
+
+        std::vector<std::int16_t> m_ahead;
+        std::size_t m_ahead_start = 0;
+
+        std::uint64_t m_silence = 0;
+        std::uint64_t m_skip = 0;
+        std::uint64_t m_remaining = UINT64_MAX;
+
+        std::uint64_t m_first = 0;
+        std::uint64_t m_delay = 0;
+        std::uint64_t m_lead = 0;
+        std::uint64_t m_total = UINT64_MAX;
+
+        FrameIndex m_index;
+
+        std::uint32_t m_sample_rate = 0;
+        std::uint32_t m_channels = 0;
+
+        std::size_t m_frame_size = 0;
+        std::size_t m_frame_samples = 0;
+    };
+}
+
+#endif /* ifndef STREAM_HPP */
@@ -0,0 +1,125 @@
+/******************************************************************************
+* File:             threadpool.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Work-stealing thread pool
+*****************************************************************************/
+
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Thread pool where every worker has its own task queue.
+ *
+ * Tasks are distributed over the queues round robin. A worker takes tasks from the back
+ * of its own queue, and if that is empty it steals tasks from the front of the queues of
+ * the other workers, so that no worker is idle while there is still work left somewhere.
+ *
+ * Member variables:
+ *  m_queues:          One task queue per worker
+ *  m_threads:         The worker threads
+ *  m_next:            Index of the queue that the next task is pushed to
+ *  m_queued:          Number of tasks that are waiting in any of the queues
+ *  m_pending:         Number of tasks that have been submitted but have not finished yet
+ *  m_mutex:           Mutex for the condition variables and the stop flag
+ *  m_work_available:  Notified when a task has been submitted or the pool is stopped
+ *  m_done:            Notified when the last pending task has finished
+ *  m_stop:            Set when the pool is destroyed
+ */
+class ThreadPool
+{
+public:
+
+    /**
+     * Class constructor, starts the worker threads.
+     *
+     * @param t_threads The number of worker threads, uses one thread per core if this is 0
+     */
+    explicit ThreadPool(std::size_t t_threads = 0);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+
+    /**
+     * Adds a task to the queue of one of the workers.
+     *
+     * @param t_task The function that should be executed by the pool
+     */
+    void submit(std::function<void()> t_task);
+
+
+    /**
+     * Blocks until every task that has been submitted so far has finished.
+     */
+    void wait();
+
+
+    /**
+     * @return the number of worker threads
+     */
+    inline std::size_t size() const noexcept {
+        return m_threads.size();
+    }
+
+
+    /**
+     * Class destructor, lets the workers finish the tasks that are left and joins them.
+     */
+    ~ThreadPool();
+
+
+private:
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+
+    /**
+     * Takes a task from the back of the queue of worker t_index, or steals
+     * one from the front of the queue of another worker.
+     * m_queued is decremented under the lock of that queue, like it is incremented in submit.
+     *
+     * @param t_index The index of the worker looking for work
+     * @param t_task  A reference to the function object the task is moved into
+     *
+     * @return true if a task has been found, false if all queues are empty
+     */
+    bool take(std::size_t t_index, std::function<void()>& t_task);
+
+
+    /**
+     * Main loop of worker t_index.
+     */
+    void work(std::size_t t_index);
+
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::atomic<std::size_t> m_next{0};
+    std::atomic<std::size_t> m_queued{0};
+    std::atomic<std::size_t> m_pending{0};
+
+    std::mutex m_mutex;
+    std::condition_variable m_work_available;
+    std::condition_variable m_done;
+    bool m_stop = false;
+};
+
+#endif /* ifndef THREADPOOL_HPP */
@@ -0,0 +1,159 @@
+/******************************************************************************
+* File:             thumbnail.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Cache for downscaled album art
+*****************************************************************************/
+
+#ifndef THUMBNAIL_HPP
+#define THUMBNAIL_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include <picture.hpp>
+
+
+// list of pixel formats, the value is the number of bytes per pixel
+typedef enum {
+
+    RGB565 = 0x02,
+    RGB888 = 0x03
+
+} PixelFormat;
+
+
+/**
+ * Raw image with the pixels stored row by row without any padding.
+ * RGB565 pixels are stored as little endian 16 bit integers.
+ *
+ * width:  The width of the image in pixels
+ * height: The height of the image in pixels
+ * format: The format of the pixels
+ * pixels: The pixel data (width * height * format bytes)
+ */
+struct Image {
+    std::uint16_t width;
+    std::uint16_t height;
+    PixelFormat format;
+    std::vector<std::uint8_t> pixels;
+};
+
+
+/**
+ * Cache for thumbnails of album art.
+ *
+ * Decoding a large cover every time a track changes is slow on a small device, so every
+ * picture is decoded once and downscaled to all sizes in SIZES (in both pixel formats).
+ * The thumbnails are stored as raw images in the cache directory, named after the hash of the
+ * picture data (see ArtStore::hash()), so that identical covers share their thumbnails.
+ *
+ * Thumbnail file: 4 bytes magic ("THMB"), 2 bytes width, 2 bytes height, 1 byte pixel format, pixels
+ *
+ * Member variables:
+ *  m_directory: The directory the thumbnails are stored in
+ */
+class ThumbnailCache
+{
+public:
+
+    static constexpr char MAGIC[4] = {'T', 'H', 'M', 'B'};
+    static constexpr std::size_t SIZE_OF_HEADER = 9;
+
+    // maximum width and height of the thumbnails that are created for every picture
+    static constexpr std::array<std::uint16_t, 3> SIZES = {64, 128, 256};
+
+
+    /**
+     * Class constructor.
+     *
+     * @param t_directory The directory the thumbnails are stored in, created if it does not exist
+     */
+    explicit ThumbnailCache(std::string t_directory);
+
+    ThumbnailCache() = delete;
+
+
+    /**
+     * @return the default directory for thumbnails, which is thumbnails in the cache directory of the player
+     */
+    static std::string defaultDirectory();
+
+
+    /**
+     * Returns a thumbnail of a picture.
+     *
+     * If the thumbnail is not cached yet, the picture is decoded and thumbnails of every
+     * size in SIZES are created and stored.
+     *
+     * @param t_picture The picture
+     * @param t_size    The maximum width and height, has to be one of SIZES
+     * @param t_format  The pixel format of the thumbnail
+     *
+     * @return the thumbnail, or an empty optional if the picture can't be decoded or the size is not supported
+     */
+    std::optional<Image> get(const ID3::Picture& t_picture, std::uint16_t t_size, PixelFormat t_format) const;
+
+
+    /**
+     * Decodes a JPEG or PNG image (based on the content, the MIME type is not reliable).
+     *
+     * JPEG images are decoded at a reduced scale if they are a lot larger than the largest
+     * thumbnail, which is a lot faster than decoding them at full size.
+     *
+     * @param t_data A view of the encoded image
+     * @return the decoded RGB888 image, or an empty optional if the data can't be decoded
+     */
+    static std::optional<Image> decode(std::span<const char> t_data);
+
+
+    /**
+     * Downscales an RGB888 image so that it fits into a square, keeping the aspect ratio.
+     * Every pixel of the result is the average of the pixels of the area it covers.
+     * Images that already fit are copied as they are.
+     *
+     * @param t_image The RGB888 image
+     * @param t_size  The maximum width and height
+     *
+     * @return the downscaled image
+     */
+    static Image downscale(const Image& t_image, std::uint16_t t_size);
+
+
+    /**
+     * Converts an RGB888 image to RGB565.
+     *
+     * @param t_image The RGB888 image
+     * @return the converted image
+     */
+    static Image toRGB565(const Image& t_image);
+
+
+private:
+
+    /**
+     * @return the path of the thumbnail file for a hash, size and format
+     */
+    std::string path(std::uint64_t t_hash, std::uint16_t t_size, PixelFormat t_format) const;
+
+
+    /**
+     * Reads a thumbnail file.
+     */
+    static std::optional<Image> load(const std::string& t_path);
+
+
+    /**
+     * Writes a thumbnail file (to a temporary file first, which then replaces the file).
+     */
+    static bool store(const std::string& t_path, const Image& t_image);
+
+
+    std::string m_directory;
+};
+
+#endif /* ifndef THUMBNAIL_HPP */
@@ -0,0 +1,56 @@
+/******************************************************************************
+* File:             unicode.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Transcoding of UTF-16 encoded text to UTF-8
+*****************************************************************************/
+
+
+#ifndef UNICODE_HPP
+#define UNICODE_HPP
+
+#include <cstddef>
+#include <span>
+
+
+namespace Unicode {
+
+    /**
+     * @param t_bytes The number of bytes of UTF-16 encoded text
+     * @return the largest number of bytes the text can take up when it is encoded as UTF-8,
+     *         which is 3 bytes per code unit (surrogate pairs take up 4 bytes for 2 code units)
+     */
+    constexpr std::size_t maxUTF8Size(std::size_t t_bytes) noexcept {
+        return t_bytes / 2 * 3;
+    }
+
+
+    /**
+     * Finds the end of null terminated UTF-16 encoded text.
+     *
+     * @param t_data The text, starting at the first code unit
+     * @return the offset of the 0x0000 code unit in bytes, or the size of the text rounded
+     *         down to whole code units if it is not terminated
+     */
+    std::size_t findTerminator(std::span<const char> t_data) noexcept;
+
+
+    /**
+     * Transcodes UTF-16 encoded text to UTF-8.
+     *
+     * Surrogate pairs are combined into a single code point, surrogates that are not part
+     * of a pair are replaced with U+FFFD. A trailing byte that is not a whole code unit is ignored.
+     * Runs of ASCII characters are transcoded 8 code units at a time with SSE2 or NEON if the
+     * build supports them.
+     *
+     * @param t_data       The text, without BOM and terminator
+     * @param t_big_endian True if the code units are big endian, false if they are little endian
+     * @param t_output     Output for the UTF-8 encoded text, has to hold maxUTF8Size(t_data.size()) bytes
+     *
+     * @return the number of bytes written to the output
+     */
+    std::size_t utf16ToUTF8(std::span<const char> t_data, bool t_big_endian, char t_output[]) noexcept;
+}
+
+#endif /* ifndef UNICODE_HPP */
@@ -0,0 +1,125 @@
+/******************************************************************************
+* File:             watcher.hpp
+*
+* Author:           Tom Schammo
+* Created:          17/10/2026
+* Description:      Keeps a list of songs up to date using inotify
+*****************************************************************************/
+
+#ifndef WATCHER_HPP
+#define WATCHER_HPP
+
+#include <sys/inotify.h>
+#include <unordered_map>
+#include <cache.hpp>
+#include <song.hpp>
+
+
+/**
+ * Watches music directories (recursively) with inotify and applies the changes
+ * to a list of songs, so that only files that have been created, modified, moved
+ * or deleted have to be looked at instead of rescanning the whole library.
+ *
+ * The list of songs is expected to be sorted by path (like the result of Library::scan)
+ * and is kept sorted.
+ *
+ * Member variables:
+ *  m_roots:        The directories that are watched
+ *  m_cache:        A pointer to the metadata cache that is updated along with the songs, or nullptr
+ *  m_fd:           The inotify file descriptor
+ *  m_directories:  The watched directories by watch descriptor
+ */
+class Watcher
+{
+public:
+
+    // events that are of interest for directories and the files in them
+    static constexpr std::uint32_t EVENTS = IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_DELETE_SELF;
+
+
+    /**
+     * Class constructor, sets up watches for the roots and all of their subdirectories.
+     *
+     * @param t_roots The directories that should be watched
+     * @param t_cache A pointer to the metadata cache that should be kept up to date, or nullptr
+     */
+    explicit Watcher(std::vector<std::string> t_roots, MetadataCache* t_cache = nullptr);
+
+    Watcher(const Watcher&) = delete;
+    Watcher& operator=(const Watcher&) = delete;
+
+
+    /**
+     * @return true if inotify has been set up successfully, false otherwise
+     */
+    inline bool valid() const noexcept {
+        return m_fd >= 0;
+    }
+
+
+    /**
+     * Waits for changes in the watched directories and applies them to the songs.
+     *
+     * New and modified files are parsed, deleted files (and files that have been moved out
+     * of the watched directories) are removed. If the kernel dropped events the roots are rescanned.
+     *
+     * @param t_songs   A reference to the sorted list of songs that should be updated
+     * @param t_timeout The maximum time to wait for events in milliseconds, -1 waits forever
+     *
+     * @return the number of songs that have been added, updated or removed
+     */
+    std::size_t poll(std::vector<Song>& t_songs, int t_timeout);
+
+
+    /**
+     * Class destructor, closes the inotify file descriptor.
+     */
+    ~Watcher();
+
+
+private:
+
+    /**
+     * Adds a watch for a directory and all of its subdirectories.
+     *
+     * @param t_directory The path of the directory
+     */
+    void watch(const std::string& t_directory);
+
+
+    /**
+     * Removes the watches of a directory and all of its subdirectories.
+     *
+     * @param t_directory The path of the directory
+     */
+    void unwatch(const std::string& t_directory);
+
+
+    /**
+     * Parses a file and inserts it into the list of songs, or replaces the song if it is already in the list.
+     *
+     * @param t_songs A reference to the sorted list of songs
+     * @param t_path  The path of the file
+     */
+    void update(std::vector<Song>& t_songs, const std::string& t_path);
+
+
+    /**
+     * Removes a song from the list, or all songs in a directory.
+     *
+     * @param t_songs     A reference to the sorted list of songs
+     * @param t_path      The path of the file or directory
+     * @param t_directory true if the path is a directory
+     *
+     * @return the number of songs that have been removed
+     */
+    static std::size_t remove(std::vector<Song>& t_songs, const std::string& t_path, bool t_directory);
+
+
+    std::vector<std::string> m_roots;
+    MetadataCache* m_cache;
+    int m_fd;
+    std::unordered_map<int, std::string> m_directories;
+};
+
+#endif /* ifndef WATCHER_HPP */
@@ -0,0 +1,113 @@
+#include <artstore.hpp>
+#include <algorithm>
+#include <cstring>
+#include <log.hpp>
+
+
+ID3::ArtStore& ID3::ArtStore::instance() {
+
+    static ArtStore store;
+
+    return store;
+}
+
+
+std::uint64_t ID3::ArtStore::hash(std::span<const char> t_data) noexcept {
+
+    constexpr std::uint64_t PRIME = 0x9e3779b97f4a7c15;
+
+    // finalizer of MurmurHash3, spreads every input bit over the whole word
+    auto mix = [](std::uint64_t t_value) {
+        t_value ^= t_value >> 33;
+        t_value *= 0xff51afd7ed558ccd;
+        t_value ^= t_value >> 33;
+        t_value *= 0xc4ceb9fe1a85ec53;
+        t_value ^= t_value >> 33;
+        return t_value;
+    };
+
+    std::uint64_t hash = t_data.size() * PRIME;
+
+    std::size_t i = 0;
+
+    for (; i + sizeof(std::uint64_t) <= t_data.size(); i += sizeof(std::uint64_t)) {
+
+        std::uint64_t word;
+        std::memcpy(&word, t_data.data() + i, sizeof(word));
+
+        hash = (hash ^ (word * PRIME)) * PRIME;
+        hash ^= hash >> 29;
+    }
+
+    std::uint64_t tail = 0;
+
+    for (std::size_t shift = 0; i < t_data.size(); ++i, shift += 8)
+        tail |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(t_data[i])) << shift;
+
+    hash = mix(hash ^ tail);
+
+    return hash == 0 ? 1 : hash;
+}
+
+
+std::shared_ptr<std::vector<char>> ID3::ArtStore::intern(std::uint64_t t_hash, std::span<const char> t_data) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto& entry = m_images[t_hash];
+
+    if (auto buffer = entry.lock()) {
+
+        // making sure that this is not a hash collision
+        if (buffer->size() == t_data.size() && std::equal(buffer->begin(), buffer->end(), t_data.begin())) {
+            log::debug(fmt::format("Sharing {} bytes of picture data with hash {:#018x}", t_data.size(), t_hash));
+            return buffer;
+        }
+
+        log::warn(fmt::format("Hash collision for picture data with hash {:#018x}, not sharing it", t_hash));
+
+        return std::make_shared<std::vector<char>>(t_data.begin(), t_data.end());
+    }
+
+    auto buffer = std::make_shared<std::vector<char>>(t_data.begin(), t_data.end());
+
+    entry = buffer;
+
+    if (m_images.size() >= m_sweep_at) {
+        sweep();
+        m_sweep_at = m_images.size() + SWEEP_INTERVAL;
+    }
+
+    return buffer;
+}
+
+
+std::shared_ptr<std::vector<char>> ID3::ArtStore::find(std::uint64_t t_hash, std::size_t t_size) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto entry = m_images.find(t_hash);
+
+    if (entry == m_images.end())
+        return nullptr;
+
+    auto buffer = entry->second.lock();
+
+    return buffer && buffer->size() == t_size ? buffer : nullptr;
+}
+
+
+std::size_t ID3::ArtStore::size() {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    sweep();
+
+    return m_images.size();
+}
+
+
+void ID3::ArtStore::sweep() {
+
+    std::erase_if(m_images, [](const auto& entry) { return entry.second.expired(); });
+}
@@ -0,0 +1,297 @@
+#include <cache.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <filehandler.hpp>
+#include <log.hpp>
+
+
+namespace {
+
+    template<typename T>
+    void append(std::vector<char>& t_buffer, T t_value) {
+
+        const auto* bytes = reinterpret_cast<const char*>(&t_value);
+
+        t_buffer.insert(t_buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+
+    void append(std::vector<char>& t_buffer, const std::string& t_string) {
+
+        auto length = static_cast<std::uint16_t>(std::min<std::size_t>(t_string.size(), UINT16_MAX));
+
+        append(t_buffer, length);
+
+        t_buffer.insert(t_buffer.end(), t_string.begin(), t_string.begin() + length);
+    }
+
+
+    template<typename T>
+    bool extract(std::span<const char> t_data, std::size_t& t_position, T& t_value) {
+
+        if (t_data.size() - t_position < sizeof(T))
+            return false;
+
+        std::memcpy(&t_value, t_data.data() + t_position, sizeof(T));
+
+        t_position += sizeof(T);
+
+        return true;
+    }
+
+
+    bool extract(std::span<const char> t_data, std::size_t& t_position, std::string& t_string) {
+
+        std::uint16_t length = 0;
+
+        if (!extract(t_data, t_position, length) || t_data.size() - t_position < length)
+            return false;
+
+        t_string.assign(t_data.data() + t_position, length);
+
+        t_position += length;
+
+        return true;
+    }
+}
+
+
+MetadataCache::MetadataCache(std::string t_filename) : m_filename(std::move(t_filename)) {
+
+    load();
+}
+
+
+std::optional<FileStamp> MetadataCache::stamp(const std::string& t_path) noexcept {
+
+    std::error_code error;
+
+    auto size = std::filesystem::file_size(t_path, error);
+
+    if (error)
+        return std::nullopt;
+
+    auto mtime = std::filesystem::last_write_time(t_path, error);
+
+    if (error)
+        return std::nullopt;
+
+    return FileStamp{size, mtime.time_since_epoch().count()};
+}
+
+
+std::filesystem::path MetadataCache::cacheDirectory() {
+
+    std::filesystem::path directory;
+
+    if (const char* cache_home = std::getenv("XDG_CACHE_HOME"); cache_home != nullptr && *cache_home != '\0')
+        directory = cache_home;
+
+    else if (const char* home = std::getenv("HOME"); home != nullptr)
+        directory = std::filesystem::path(home) / ".cache";
+
+    return directory / "mp3-player";
+}
+
+
+std::string MetadataCache::defaultPath() {
+
+    return (cacheDirectory() / "library.cache").string();
+}
+
+
+std::optional<Song> MetadataCache::lookup(const std::string& t_path, const FileStamp& t_stamp) const {
+
+    auto entry = m_entries.find(t_path);
+
+    if (entry == m_entries.end() || entry->second.stamp != t_stamp)
+        return std::nullopt;
+
+    return entry->second.song;
+}
+
+
+void MetadataCache::store(const Song& t_song, const FileStamp& t_stamp) {
+
+    m_entries.insert_or_assign(t_song.m_path, Entry{t_stamp, t_song});
+
+    m_dirty = true;
+}
+
+
+void MetadataCache::serialize(const Song& t_song, const FileStamp& t_stamp, std::vector<char>& t_buffer) {
+
+    append(t_buffer, t_stamp.size);
+    append(t_buffer, t_stamp.mtime);
+
+    append(t_buffer, t_song.m_audio_start);
+    append(t_buffer, t_song.m_counter_offset);
+    append(t_buffer, t_song.m_duration);
+    append(t_buffer, t_song.m_delay);
+    append(t_buffer, t_song.m_play_counter);
+
+    append(t_buffer, t_song.m_path);
+    append(t_buffer, t_song.m_title);
+    append(t_buffer, t_song.m_album);
+    append(t_buffer, t_song.m_artist);
+    append(t_buffer, t_song.m_genre);
+    append(t_buffer, t_song.m_release);
+    append(t_buffer, t_song.m_track_number);
+
+    auto pictures = static_cast<std::uint8_t>(std::min<std::size_t>(t_song.m_art.size(), UINT8_MAX));
+
+    append(t_buffer, pictures);
+
+    for (std::size_t i = 0; i < pictures; ++i) {
+
+        const auto& art = t_song.m_art[i];
+
+        append(t_buffer, art.m_offset);
+        append(t_buffer, art.m_size);
+        append(t_buffer, art.m_hash);
+        append(t_buffer, static_cast<std::uint8_t>(art.m_pic_type));
+        append(t_buffer, art.m_mime_type);
+    }
+}
+
+
+std::optional<std::pair<Song, FileStamp>> MetadataCache::deserialize(std::span<const char> t_data, std::size_t& t_position) {
+
+    FileStamp stamp{};
+    Song song("");
+
+    bool valid = extract(t_data, t_position, stamp.size)
+                 && extract(t_data, t_position, stamp.mtime)
+                 && extract(t_data, t_position, song.m_audio_start)
+                 && extract(t_data, t_position, song.m_counter_offset)
+                 && extract(t_data, t_position, song.m_duration)
+                 && extract(t_data, t_position, song.m_delay)
+                 && extract(t_data, t_position, song.m_play_counter)
+                 && extract(t_data, t_position, song.m_path)
+                 && extract(t_data, t_position, song.m_title)
+                 && extract(t_data, t_position, song.m_album)
+                 && extract(t_data, t_position, song.m_artist)
+                 && extract(t_data, t_position, song.m_genre)
+                 && extract(t_data, t_position, song.m_release)
+                 && extract(t_data, t_position, song.m_track_number);
+
+    std::uint8_t pictures = 0;
+
+    if (!valid || !extract(t_data, t_position, pictures))
+        return std::nullopt;
+
+    for (std::uint8_t i = 0; i < pictures; ++i) {
+
+        std::uint32_t offset = 0;
+        std::uint32_t size = 0;
+        std::uint64_t hash = 0;
+        std::uint8_t type = 0;
+        std::string mime_type;
+
+        if (!extract(t_data, t_position, offset) || !extract(t_data, t_position, size) || !extract(t_data, t_position, hash)
+            || !extract(t_data, t_position, type) || !extract(t_data, t_position, mime_type))
+            return std::nullopt;
+
+        // only the location of the picture is cached, the data is loaded when it is needed
+        song.m_art.emplace_back(song.m_path, offset, size, mime_type, static_cast<ID3::PictureType>(type));
+        song.m_art.back().m_hash = hash;
+    }
+
+    return std::make_pair(std::move(song), stamp);
+}
+
+
+void MetadataCache::load() {
+
+    Filehandler handler(m_filename, true);
+
+    if (!handler.isMapped()) {
+        log::info(fmt::format("No metadata cache found at {}", m_filename));
+        return;
+    }
+
+    auto data = handler.bytes();
+
+    std::size_t position = 0;
+
+    char magic[4]{};
+    std::uint32_t version = 0;
+    std::uint32_t count = 0;
+
+    bool valid = extract(data, position, magic) && extract(data, position, version) && extract(data, position, count);
+
+    if (!valid || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != FORMAT_VERSION) {
+        log::warn(fmt::format("Ignoring metadata cache {} as it has an unknown format", m_filename));
+        return;
+    }
+
+    m_entries.reserve(count);
+
+    for (std::uint32_t i = 0; i < count; ++i) {
+
+        auto entry = deserialize(data, position);
+
+        if (!entry) {
+            log::warn(fmt::format("Metadata cache {} is truncated after {} entries", m_filename, i));
+            break;
+        }
+
+        auto path = entry->first.m_path;
+
+        m_entries.insert_or_assign(std::move(path), Entry{entry->second, std::move(entry->first)});
+    }
+
+    log::info(fmt::format("Loaded {} entries from metadata cache {}", m_entries.size(), m_filename));
+}
+
+
+bool MetadataCache::save() {
+
+    if (!m_dirty)
+        return true;
+
+    // dropping songs that have been deleted since they have been cached
+    std::erase_if(m_entries, [](const auto& entry) {
+        std::error_code error;
+        return !std::filesystem::exists(entry.first, error);
+    });
+
+    std::vector<char> buffer;
+
+    buffer.insert(buffer.end(), MAGIC, MAGIC + sizeof(MAGIC));
+    append(buffer, FORMAT_VERSION);
+    append(buffer, static_cast<std::uint32_t>(m_entries.size()));
+
+    for (const auto& [path, entry] : m_entries)
+        serialize(entry.song, entry.stamp, buffer);
+
+    std::error_code error;
+
+    std::filesystem::create_directories(std::filesystem::path(m_filename).parent_path(), error);
+
+    std::string temporary = m_filename + ".tmp";
+
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::out | std::ios::trunc);
+
+        stream.write(buffer.data(), static_cast<long>(buffer.size()));
+
+        if (!stream) {
+            log::error(fmt::format("Could not write metadata cache to {}", temporary));
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, m_filename, error);
+
+    if (error) {
+        log::error(fmt::format("Could not replace {}: {}", m_filename, error.message()));
+        return false;
+    }
+
+    log::info(fmt::format("Saved {} entries to metadata cache {}", m_entries.size(), m_filename));
+
+    m_dirty = false;
+
+    return true;
+}
@@ -0,0 +1,829 @@
+#include <decoder.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <huffman.hpp>
+#include <numbers>
+
+
+namespace {
+
+    using MP3::DSP::sample;
+    using MP3::byte;
+
+
+    /**
+     * Boundaries of the scalefactor bands in lines (long blocks) or lines per window (short blocks).
+     */
+    struct Bands {
+        std::uint16_t l[23];
+        std::uint16_t s[14];
+    };
+
+
+    // scalefactor bands by sample rate (44.1, 48, 32, 22.05, 24, 16, 11.025, 12 and 8 kHz)
+    constexpr Bands BANDS[9] = {
+        {{0, 4, 8, 12, 16, 20, 24, 30, 36, 44, 52, 62, 74, 90, 110, 134, 162, 196, 238, 288, 342, 418, 576},
+         {0, 4, 8, 12, 16, 22, 30, 40, 52, 66, 84, 106, 136, 192}},
+        {{0, 4, 8, 12, 16, 20, 24, 30, 36, 42, 50, 60, 72, 88, 106, 128, 156, 190, 230, 276, 330, 384, 576},
+         {0, 4, 8, 12, 16, 22, 28, 38, 50, 64, 80, 100, 126, 192}},
+        {{0, 4, 8, 12, 16, 20, 24, 30, 36, 44, 54, 66, 82, 102, 126, 156, 194, 240, 296, 364, 448, 550, 576},
+         {0, 4, 8, 12, 16, 22, 30, 42, 58, 78, 104, 138, 180, 192}},
+        {{0, 6, 12, 18, 24, 30, 36, 44, 54, 66, 80, 96, 116, 140, 168, 200, 238, 284, 336, 396, 464, 522, 576},
+         {0, 4, 8, 12, 18, 24, 32, 42, 56, 74, 100, 132, 174, 192}},
+        {{0, 6, 12, 18, 24, 30, 36, 44, 54, 66, 80, 96, 114, 136, 162, 194, 232, 278, 332, 394, 464, 540, 576},
+         {0, 4, 8, 12, 18, 26, 36, 48, 62, 80, 104, 136, 180, 192}},
+        {{0, 6, 12, 18, 24, 30, 36, 44, 54, 66, 80, 96, 116, 140, 168, 200, 238, 284, 336, 396, 464, 522, 576},
+         {0, 4, 8, 12, 18, 26, 36, 48, 62, 80, 104, 134, 174, 192}},
+        {{0, 6, 12, 18, 24, 30, 36, 44, 54, 66, 80, 96, 116, 140, 168, 200, 238, 284, 336, 396, 464, 522, 576},
+         {0, 4, 8, 12, 18, 26, 36, 48, 62, 80, 104, 134, 174, 192}},
+        {{0, 6, 12, 18, 24, 30, 36, 44, 54, 66, 80, 96, 116, 140, 168, 200, 238, 284, 336, 396, 464, 522, 576},
+         {0, 4, 8, 12, 18, 26, 36, 48, 62, 80, 104, 134, 174, 192}},
+        {{0, 12, 24, 36, 48, 60, 72, 88, 108, 132, 160, 192, 232, 280, 336, 400, 476, 566, 568, 570, 572, 574, 576},
+         {0, 8, 16, 24, 36, 52, 72, 96, 124, 160, 162, 164, 166, 192}}
+    };
+
+
+    // added to the scalefactors of long blocks if preflag is set
+    constexpr byte PRETAB[22] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 3, 3, 3, 2, 0};
+
+
+    // number of bits of the two groups of scalefactors by scalefac_compress (MPEG 1)
+    constexpr byte SLEN[16][2] = {
+        {0, 0}, {0, 1}, {0, 2}, {0, 3}, {3, 0}, {1, 1}, {1, 2}, {1, 3},
+        {2, 1}, {2, 2}, {2, 3}, {3, 1}, {3, 2}, {3, 3}, {4, 2}, {4, 3}
+    };
+
+
+    // number of scalefactors in the four groups of scalefactors (MPEG 2 and 2.5),
+    // by scalefac_compress range and block type (long, short, mixed)
+    constexpr byte SCALEFACTOR_COUNTS[6][3][4] = {
+        {{6, 5, 5, 5}, {9, 9, 9, 9}, {6, 9, 9, 9}},
+        {{6, 5, 7, 3}, {9, 9, 12, 6}, {6, 9, 12, 6}},
+        {{11, 10, 0, 0}, {18, 18, 0, 0}, {15, 18, 0, 0}},
+        {{7, 7, 7, 0}, {12, 12, 12, 0}, {6, 15, 12, 0}},
+        {{6, 6, 6, 3}, {12, 9, 9, 6}, {6, 12, 9, 6}},
+        {{8, 8, 5, 0}, {15, 12, 9, 0}, {6, 18, 9, 0}}
+    };
+
+
+    // largest value of a pair after adding linbits
+    constexpr std::size_t MAX_VALUE = 15 + (1 << 13) - 1;
+
+
+    /**
+     * x^(4/3) as a normalized mantissa (between 2^30 and 2^31) and an exponent.
+     */
+    struct Power {
+        std::uint32_t mantissa;
+        std::int32_t exponent;
+    };
+
+
+    /**
+     * Coefficient tables, built once on first use.
+     *
+     * powers:       x^(4/3) for every value of a spectral line
+     * quarters:     2^(i / 4) with 30 fractional bits
+     * intensity:    Left and right factor of the intensity stereo positions (MPEG 1)
+     * intensity_lsf: Left and right factor of the intensity stereo positions by the lowest bit of scalefac_compress (MPEG 2 and 2.5)
+     * cs, ca:       Coefficients of the antialias butterflies
+     * mid_side:     1 / sqrt(2)
+     */
+    struct Tables {
+        Power powers[MAX_VALUE + 1];
+        std::uint32_t quarters[4];
+        std::int32_t intensity[7][2];
+        std::int32_t intensity_lsf[2][32][2];
+        std::int32_t cs[8];
+        std::int32_t ca[8];
+        std::int32_t mid_side;
+    };
+
+
+    std::int32_t coefficient(double t_value) noexcept {
+        return static_cast<std::int32_t>(std::lround(t_value * (1 << MP3::DSP::COEFFICIENT_BITS)));
+    }
+
+
+    const Tables& tables() noexcept {
+
+        static const Tables tables = [] {
+
+            Tables result{};
+
+            for (std::size_t i = 1; i <= MAX_VALUE; ++i) {
+
+                int exponent = 0;
+
+                double mantissa = std::frexp(std::pow(static_cast<double>(i), 4.0 / 3.0), &exponent);
+
+                // frexp returns a mantissa between 0.5 and 1
+                result.powers[i] = {static_cast<std::uint32_t>(std::llround(mantissa * 2147483648.0)), exponent - 31};
+            }
+
+            for (std::size_t i = 0; i < 4; ++i)
+                result.quarters[i] = static_cast<std::uint32_t>(std::llround(std::pow(2.0, static_cast<double>(i) / 4.0) * (1 << 30)));
+
+            for (std::size_t i = 0; i < 7; ++i) {
+
+                double angle = static_cast<double>(i) * std::numbers::pi / 12;
+
+                double left = std::sin(angle) / (std::sin(angle) + std::cos(angle));
+
+                result.intensity[i][0] = coefficient(left);
+                result.intensity[i][1] = coefficient(1.0 - left);
+            }
+
+            for (std::size_t i = 0; i < 2; ++i) {
+
+                double base = i == 0 ? std::pow(2.0, -0.25) : std::pow(2.0, -0.5);
+
+                for (std::size_t position = 0; position < 32; ++position) {
+
+                    double left = position % 2 == 1 ? std::pow(base, static_cast<double>((position + 1) / 2)) : 1.0;
+                    double right = position % 2 == 0 ? std::pow(base, static_cast<double>(position / 2)) : 1.0;
+
+                    result.intensity_lsf[i][position][0] = coefficient(left);
+                    result.intensity_lsf[i][position][1] = coefficient(right);
+                }
+            }
+
+            constexpr double C[8] = {-0.6, -0.535, -0.33, -0.185, -0.095, -0.041, -0.0142, -0.0037};
+
+            for (std::size_t i = 0; i < 8; ++i) {
+                result.cs[i] = coefficient(1.0 / std::sqrt(1.0 + C[i] * C[i]));
+                result.ca[i] = coefficient(C[i] / std::sqrt(1.0 + C[i] * C[i]));
+            }
+
+            result.mid_side = coefficient(1.0 / std::numbers::sqrt2);
+
+            return result;
+        }();
+
+        return tables;
+    }
+
+
+    /**
+     * @return the index of the sample rate in BANDS
+     */
+    std::size_t bandIndex(const MP3::FrameHeader& t_header) noexcept {
+
+        std::size_t base = t_header.version == MP3::MPEG_1 ? 0 : t_header.version == MP3::MPEG_2 ? 3 : 6;
+
+        switch (t_header.sample_rate) {
+            case 44100: case 22050: case 11025: return base;
+            case 48000: case 24000: case 12000: return base + 1;
+            default: return base + 2;
+        }
+    }
+
+
+    /**
+     * Requantizes a spectral line: sign(x) * |x|^(4/3) * 2^(t_quarters / 4).
+     *
+     * @param t_value    The value of the line
+     * @param t_quarters The exponent of the gain in quarters
+     *
+     * @return the requantized line, clipped to the range of a sample
+     */
+    sample requantizeLine(std::int32_t t_value, std::int32_t t_quarters) noexcept {
+
+        if (t_value == 0)
+            return 0;
+
+        const auto& table = tables();
+
+        const auto& power = table.powers[std::min<std::size_t>(static_cast<std::size_t>(std::abs(t_value)), MAX_VALUE)];
+
+        // product of mantissas with 61 fractional bits
+        std::uint64_t product = std::uint64_t{power.mantissa} * table.quarters[t_quarters & 0x03];
+
+        std::int32_t shift = MP3::DSP::FRACTION_BITS - 61 + 31 + power.exponent + (t_quarters >> 2);
+
+        // limited to 64 times the full scale so that the stereo processing cannot overflow
+        constexpr sample LIMIT = (1 << 30) - 1;
+
+        sample magnitude = LIMIT;
+
+        if (shift < 0) {
+
+            if (shift <= -62)
+                return 0;
+
+            std::uint64_t value = (product + (std::uint64_t{1} << (-shift - 1))) >> -shift;
+
+            magnitude = value > LIMIT ? LIMIT : static_cast<sample>(value);
+        }
+
+        return t_value < 0 ? -magnitude : magnitude;
+    }
+}
+
+
+void MP3::Decoder::reset() noexcept {
+
+    m_reservoir_size = 0;
+    m_scalefactors = {};
+    m_overlap = {};
+    m_synthesis = {};
+}
+
+
+std::size_t MP3::Decoder::decode(std::span<const char> t_frame, std::span<std::int16_t> t_pcm) noexcept {
+
+    auto header = parseHeader(t_frame);
+
+    if (!header || header->layer != 3 || t_frame.size() < header->size || t_pcm.size() < MAX_SAMPLES * header->channels())
+        return 0;
+
+    // a different stream, nothing of the previous frames can be used
+    if (header->channels() != m_channels || header->sample_rate != m_sample_rate) {
+        reset();
+        m_channels = header->channels();
+        m_sample_rate = header->sample_rate;
+    }
+
+    std::size_t side_start = SIZE_OF_HEADER + (header->crc ? 2 : 0);
+    std::size_t main_start = side_start + sideInformationSize(*header);
+
+    if (main_start > header->size)
+        return 0;
+
+    SideInformation info{};
+
+    BitReader side(t_frame.subspan(side_start, main_start - side_start));
+
+    readSideInformation(side, *header, info);
+
+    // appending the main data of the frame to the reservoir
+    auto main = t_frame.subspan(main_start, header->size - main_start);
+
+    bool underflow = info.main_data_begin > m_reservoir_size;
+
+    std::size_t start = underflow ? 0 : m_reservoir_size - info.main_data_begin;
+
+    std::memcpy(m_reservoir.data() + m_reservoir_size, main.data(), main.size());
+
+    m_reservoir_size += main.size();
+
+    std::size_t channels = header->channels();
+    std::size_t granules = header->version == MPEG_1 ? 2 : 1;
+
+    if (underflow)
+        std::fill(t_pcm.begin(), t_pcm.begin() + static_cast<std::ptrdiff_t>(header->samples * channels), std::int16_t{0});
+
+    else {
+
+        BitReader reader(std::span<const char>(m_reservoir.data(), m_reservoir_size), start * 8);
+
+        for (std::size_t gr = 0; gr < granules; ++gr) {
+
+            for (std::size_t ch = 0; ch < channels; ++ch) {
+
+                auto& granule = info.granules[gr][ch];
+
+                std::size_t part2_start = reader.position();
+
+                readScalefactors(reader, *header, info, granule, gr, ch);
+                readLines(reader, granule, part2_start + granule.part2_3_length, ch);
+
+                // skipping stuffing bits
+                reader.seek(part2_start + granule.part2_3_length);
+
+                requantize(*header, granule, ch);
+            }
+
+            if (channels == 2)
+                stereo(*header, info.granules[gr][1]);
+
+            for (std::size_t ch = 0; ch < channels; ++ch)
+                reconstruct(*header, info.granules[gr][ch], ch, t_pcm.data() + gr * LINES * channels + ch);
+        }
+    }
+
+    // keeping the data that following frames might refer to
+    std::size_t keep = std::min(m_reservoir_size, MAX_MAIN_DATA_BEGIN);
+
+    std::memmove(m_reservoir.data(), m_reservoir.data() + m_reservoir_size - keep, keep);
+
+    m_reservoir_size = keep;
+
+    return header->samples;
+}
+
+
+void MP3::Decoder::readSideInformation(BitReader& t_reader, const FrameHeader& t_header, SideInformation& t_info) const noexcept {
+
+    bool lsf = t_header.version != MPEG_1;
+    std::size_t channels = t_header.channels();
+    const auto& bands = BANDS[bandIndex(t_header)];
+
+    if (lsf) {
+        t_info.main_data_begin = t_reader.read(8);
+        t_reader.read(channels == 1 ? 1 : 2);
+    }
+
+    else {
+
+        t_info.main_data_begin = t_reader.read(9);
+        t_reader.read(channels == 1 ? 5 : 3);
+
+        for (std::size_t ch = 0; ch < channels; ++ch)
+            for (auto& band : t_info.scfsi[ch])
+                band = t_reader.bit() != 0;
+    }
+
+    for (std::size_t gr = 0; gr < (lsf ? 1 : 2); ++gr) {
+
+        for (std::size_t ch = 0; ch < channels; ++ch) {
+
+            auto& granule = t_info.granules[gr][ch];
+
+            granule.part2_3_length = t_reader.read(12);
+            granule.big_values = std::min<std::uint32_t>(t_reader.read(9), LINES / 2);
+            granule.global_gain = t_reader.read(8);
+            granule.scalefac_compress = t_reader.read(lsf ? 9 : 4);
+            granule.window_switching = t_reader.bit() != 0;
+
+            if (granule.window_switching) {
+
+                granule.block_type = static_cast<byte>(t_reader.read(2));
+                granule.mixed_block = t_reader.bit() != 0;
+
+                for (std::size_t i = 0; i < 2; ++i)
+                    granule.table_select[i] = static_cast<byte>(t_reader.read(5));
+
+                granule.table_select[2] = 0;
+
+                for (auto& gain : granule.subblock_gain)
+                    gain = static_cast<byte>(t_reader.read(3));
+
+                // region 0 covers the first 36 lines (9 short bands), region 1 the rest
+                granule.region1_start = granule.shortBlocks() && !granule.mixed_block ? bands.s[3] * 3u : bands.l[8];
+                granule.region2_start = LINES;
+            }
+
+            else {
+
+                granule.block_type = 0;
+                granule.mixed_block = false;
+
+                for (auto& table : granule.table_select)
+                    table = static_cast<byte>(t_reader.read(5));
+
+                std::uint32_t region0_count = t_reader.read(4);
+                std::uint32_t region1_count = t_reader.read(3);
+
+                granule.region1_start = bands.l[std::min<std::uint32_t>(region0_count + 1, 22)];
+                granule.region2_start = bands.l[std::min<std::uint32_t>(region0_count + region1_count + 2, 22)];
+            }
+
+            granule.preflag = lsf ? false : t_reader.bit() != 0;
+            granule.scalefac_scale = t_reader.bit() != 0;
+            granule.count1table_select = static_cast<byte>(t_reader.bit());
+        }
+    }
+}
+
+
+void MP3::Decoder::readScalefactors(BitReader& t_reader, const FrameHeader& t_header, const SideInformation& t_info,
+                                    Granule& t_granule, std::size_t t_granule_index, std::size_t t_channel) noexcept {
+
+    if (t_header.version != MPEG_1) {
+        readScalefactorsLSF(t_reader, t_header, t_granule, t_channel);
+        return;
+    }
+
+    auto& scalefactors = m_scalefactors[t_channel];
+
+    std::uint32_t slen1 = SLEN[t_granule.scalefac_compress][0];
+    std::uint32_t slen2 = SLEN[t_granule.scalefac_compress][1];
+
+    // 7 is the illegal intensity stereo position for every band
+    scalefactors.illegal_l.fill(7);
+    scalefactors.illegal_s.fill(7);
+
+    if (t_granule.shortBlocks()) {
+
+        std::size_t first = 0;
+
+        if (t_granule.mixed_block) {
+
+            for (std::size_t sfb = 0; sfb < 8; ++sfb)
+                scalefactors.l[sfb] = static_cast<byte>(t_reader.read(slen1));
+
+            first = 3;
+        }
+
+        for (std::size_t sfb = first; sfb < 12; ++sfb)
+            for (auto& scalefactor : scalefactors.s[sfb])
+                scalefactor = static_cast<byte>(t_reader.read(sfb < 6 ? slen1 : slen2));
+
+        scalefactors.s[12] = {0, 0, 0};
+    }
+
+    else {
+
+        constexpr std::size_t GROUPS[5] = {0, 6, 11, 16, 21};
+
+        for (std::size_t group = 0; group < 4; ++group) {
+
+            // the scalefactors of the first granule are used if the scalefactor selection information is set
+            if (t_granule_index == 1 && t_info.scfsi[t_channel][group])
+                continue;
+
+            for (std::size_t sfb = GROUPS[group]; sfb < GROUPS[group + 1]; ++sfb)
+                scalefactors.l[sfb] = static_cast<byte>(t_reader.read(group < 2 ? slen1 : slen2));
+        }
+
+        scalefactors.l[21] = 0;
+    }
+}
+
+
+void MP3::Decoder::readScalefactorsLSF(BitReader& t_reader, const FrameHeader& t_header, Granule& t_granule, std::size_t t_channel) noexcept {
+
+    auto& scalefactors = m_scalefactors[t_channel];
+
+    std::uint32_t compress = t_granule.scalefac_compress;
+    std::uint32_t slen[4] = {0, 0, 0, 0};
+    std::size_t table = 0;
+
+    // the right channel of intensity stereo coded frames stores the intensity positions
+    bool intensity = t_channel == 1 && t_header.channel_mode == JOINT_STEREO && (t_header.mode_extension & 0x01);
+
+    if (!intensity) {
+
+        if (compress < 400) {
+            slen[0] = (compress >> 4) / 5;
+            slen[1] = (compress >> 4) % 5;
+            slen[2] = (compress & 0x0f) >> 2;
+            slen[3] = compress & 0x03;
+            table = 0;
+        }
+
+        else if (compress < 500) {
+            compress -= 400;
+            slen[0] = (compress >> 2) / 5;
+            slen[1] = (compress >> 2) % 5;
+            slen[2] = compress & 0x03;
+            table = 1;
+        }
+
+        else {
+            compress -= 500;
+            slen[0] = compress / 3;
+            slen[1] = compress % 3;
+            table = 2;
+            t_granule.preflag = true;
+        }
+    }
+
+    else {
+
+        compress >>= 1;
+
+        if (compress < 180) {
+            slen[0] = compress / 36;
+            slen[1] = (compress % 36) / 6;
+            slen[2] = (compress % 36) % 6;
+            table = 3;
+        }
+
+        else if (compress < 244) {
+            compress -= 180;
+            slen[0] = (compress % 64) >> 4;
+            slen[1] = (compress % 16) >> 2;
+            slen[2] = compress % 4;
+            table = 4;
+        }
+
+        else {
+            compress -= 244;
+            slen[0] = compress / 3;
+            slen[1] = compress % 3;
+            table = 5;
+        }
+    }
+
+    std::size_t block = t_granule.shortBlocks() ? (t_granule.mixed_block ? 2 : 1) : 0;
+
+    // reading all scalefactors in the order of the bands first
+    byte values[39] = {};
+    byte illegal[39] = {};
+    std::size_t count = 0;
+
+    for (std::size_t group = 0; group < 4; ++group) {
+        for (std::size_t i = 0; i < SCALEFACTOR_COUNTS[table][block][group]; ++i, ++count) {
+            values[count] = static_cast<byte>(t_reader.read(slen[group]));
+            illegal[count] = static_cast<byte>((1u << slen[group]) - 1);
+        }
+    }
+
+    std::size_t index = 0;
+
+    if (block != 1) {
+
+        std::size_t long_bands = block == 2 ? 6 : 21;
+
+        for (std::size_t sfb = 0; sfb < long_bands; ++sfb, ++index) {
+            scalefactors.l[sfb] = values[index];
+            scalefactors.illegal_l[sfb] = illegal[index];
+        }
+
+        scalefactors.l[21] = 0;
+        scalefactors.illegal_l[21] = illegal[index - 1];
+    }
+
+    if (block != 0) {
+
+        for (std::size_t sfb = block == 2 ? 3 : 0; sfb < 12; ++sfb) {
+
+            scalefactors.illegal_s[sfb] = illegal[index];
+
+            for (auto& scalefactor : scalefactors.s[sfb])
+                scalefactor = values[index++];
+        }
+
+        scalefactors.s[12] = {0, 0, 0};
+        scalefactors.illegal_s[12] = scalefactors.illegal_s[11];
+    }
+}
+
+
+void MP3::Decoder::readLines(BitReader& t_reader, const Granule& t_granule, std::size_t t_end, std::size_t t_channel) noexcept {
+
+    // the values are decoded into the buffer of the requantized lines
+    auto& lines = m_lines[t_channel];
+
+    std::size_t line = 0;
+    std::size_t big_values = t_granule.big_values * 2;
+
+    for (; line < big_values; line += 2) {
+
+        std::uint32_t table = t_granule.table_select[line < t_granule.region1_start ? 0 : line < t_granule.region2_start ? 1 : 2];
+
+        Huffman::decodePair(t_reader, table, lines[line], lines[line + 1]);
+    }
+
+    while (line < LINES && t_reader.position() < t_end) {
+
+        std::int32_t values[4];
+
+        Huffman::decodeQuadruple(t_reader, t_granule.count1table_select, values);
+
+        // a quadruple that ends after the data of the granule is discarded
+        if (t_reader.position() > t_end)
+            break;
+
+        for (std::size_t i = 0; i < 4 && line < LINES; ++i)
+            lines[line++] = values[i];
+    }
+
+    std::fill(lines.begin() + static_cast<std::ptrdiff_t>(line), lines.end(), 0);
+
+    while (line > 0 && lines[line - 1] == 0)
+        --line;
+
+    m_nonzero[t_channel] = line;
+}
+
+
+void MP3::Decoder::requantize(const FrameHeader& t_header, const Granule& t_granule, std::size_t t_channel) noexcept {
+
+    const auto& bands = BANDS[bandIndex(t_header)];
+    const auto& scalefactors = m_scalefactors[t_channel];
+
+    auto& lines = m_lines[t_channel];
+
+    std::size_t nonzero = m_nonzero[t_channel];
+
+    std::int32_t gain = static_cast<std::int32_t>(t_granule.global_gain) - 210;
+    std::int32_t multiplier = t_granule.scalefac_scale ? 4 : 2;
+
+    auto apply = [&](std::size_t t_begin, std::size_t t_end, std::int32_t t_quarters) {
+        for (std::size_t i = t_begin; i < t_end && i < nonzero; ++i)
+            lines[i] = requantizeLine(lines[i], t_quarters);
+    };
+
+    std::size_t long_bands = 0;
+
+    if (!t_granule.shortBlocks())
+        long_bands = 22;
+
+    // the first 36 lines of mixed blocks are long blocks
+    else if (t_granule.mixed_block)
+        long_bands = t_header.version == MPEG_1 ? 8 : 6;
+
+    for (std::size_t sfb = 0; sfb < long_bands; ++sfb) {
+
+        std::int32_t scalefactor = scalefactors.l[sfb] + (t_granule.preflag ? PRETAB[sfb] : 0);
+
+        apply(bands.l[sfb], bands.l[sfb + 1], gain - multiplier * scalefactor);
+    }
+
+    if (!t_granule.shortBlocks())
+        return;
+
+    // short blocks are stored band by band, with the lines of the three windows after each other
+    std::size_t line = bands.l[long_bands];
+
+    for (std::size_t sfb = t_granule.mixed_block ? 3 : 0; sfb < 13 && line < nonzero; ++sfb) {
+
+        std::size_t width = bands.s[sfb + 1] - bands.s[sfb];
+
+        for (std::size_t window = 0; window < 3; ++window, line += width) {
+
+            std::int32_t quarters = gain - 8 * t_granule.subblock_gain[window] - multiplier * scalefactors.s[sfb][window];
+
+            apply(line, line + width, quarters);
+        }
+    }
+}
+
+
+void MP3::Decoder::stereo(const FrameHeader& t_header, const Granule& t_granule) noexcept {
+
+    if (t_header.channel_mode != JOINT_STEREO)
+        return;
+
+    const auto& table = tables();
+    const auto& bands = BANDS[bandIndex(t_header)];
+    const auto& scalefactors = m_scalefactors[1];
+
+    auto& left = m_lines[0];
+    auto& right = m_lines[1];
+
+    bool mid_side = t_header.mode_extension & 0x02;
+    bool intensity = t_header.mode_extension & 0x01;
+    bool lsf = t_header.version != MPEG_1;
+
+    auto process = [&](std::size_t t_begin, std::size_t t_end, bool t_intensity, byte t_position, byte t_illegal) {
+
+        if (t_intensity && t_position != t_illegal) {
+
+            const auto& factors = lsf ? table.intensity_lsf[t_granule.scalefac_compress & 0x01][t_position & 0x1f]
+                                      : table.intensity[std::min<byte>(t_position, 6)];
+
+            for (std::size_t i = t_begin; i < t_end; ++i) {
+                right[i] = DSP::multiply(left[i], factors[1]);
+                left[i] = DSP::multiply(left[i], factors[0]);
+            }
+        }
+
+        else if (mid_side) {
+
+            for (std::size_t i = t_begin; i < t_end; ++i) {
+
+                sample mid = left[i];
+                sample side = right[i];
+
+                left[i] = DSP::multiply(mid + side, table.mid_side);
+                right[i] = DSP::multiply(mid - side, table.mid_side);
+            }
+        }
+    };
+
+    // intensity stereo is used for the bands above the last band with values in the right channel
+    std::size_t nonzero = m_nonzero[1];
+
+    if (!t_granule.shortBlocks()) {
+
+        for (std::size_t sfb = 0; sfb < 22; ++sfb) {
+
+            // the last band uses the intensity position of the band below
+            std::size_t position = sfb == 21 ? 20 : sfb;
+
+            process(bands.l[sfb], bands.l[sfb + 1], intensity && bands.l[sfb] >= nonzero,
+                    scalefactors.l[position], scalefactors.illegal_l[sfb]);
+        }
+    }
+
+    else {
+
+        std::size_t long_bands = t_granule.mixed_block ? (lsf ? 6 : 8) : 0;
+        std::size_t first_short = t_granule.mixed_block ? 3 : 0;
+
+        // the highest band with values in the right channel for every window
+        std::array<std::size_t, 3> highest{};
+        bool values = false;
+
+        std::size_t line = bands.l[long_bands];
+
+        for (std::size_t sfb = first_short; sfb < 13; ++sfb) {
+
+            std::size_t width = bands.s[sfb + 1] - bands.s[sfb];
+
+            for (std::size_t window = 0; window < 3; ++window, line += width) {
+
+                if (std::any_of(right.begin() + static_cast<std::ptrdiff_t>(line), right.begin() + static_cast<std::ptrdiff_t>(line + width),
+                                [](sample value) { return value != 0; })) {
+                    highest[window] = sfb + 1;
+                    values = true;
+                }
+            }
+        }
+
+        // the long bands of mixed blocks are only intensity coded if all short bands are
+        for (std::size_t sfb = 0; sfb < long_bands; ++sfb)
+            process(bands.l[sfb], bands.l[sfb + 1], intensity && !values && bands.l[sfb] >= nonzero,
+                    scalefactors.l[sfb], scalefactors.illegal_l[sfb]);
+
+        line = bands.l[long_bands];
+
+        for (std::size_t sfb = first_short; sfb < 13; ++sfb) {
+
+            std::size_t width = bands.s[sfb + 1] - bands.s[sfb];
+            std::size_t position = sfb == 12 ? 11 : sfb;
+
+            for (std::size_t window = 0; window < 3; ++window, line += width)
+                process(line, line + width, intensity && sfb >= std::max(highest[window], first_short),
+                        scalefactors.s[position][window], scalefactors.illegal_s[sfb]);
+        }
+    }
+
+    m_nonzero[0] = m_nonzero[1] = std::max(m_nonzero[0], intensity ? LINES : m_nonzero[1]);
+}
+
+
+void MP3::Decoder::reconstruct(const FrameHeader& t_header, const Granule& t_granule, std::size_t t_channel, std::int16_t* t_pcm) noexcept {
+
+    const auto& table = tables();
+    const auto& bands = BANDS[bandIndex(t_header)];
+
+    auto& lines = m_lines[t_channel];
+
+    if (t_granule.shortBlocks()) {
+
+        // reordering the lines of short blocks so that the windows are interleaved (line 3 * i + window)
+        std::array<sample, LINES> reordered;
+
+        std::size_t first = t_granule.mixed_block ? 3 : 0;
+        std::size_t line = bands.s[first] * 3u;
+
+        for (std::size_t sfb = first; sfb < 13; ++sfb) {
+
+            std::size_t start = bands.s[sfb];
+            std::size_t width = bands.s[sfb + 1] - start;
+
+            for (std::size_t window = 0; window < 3; ++window)
+                for (std::size_t i = 0; i < width; ++i)
+                    reordered[3 * (start + i) + window] = lines[line + window * width + i];
+
+            line += 3 * width;
+        }
+
+        std::copy(reordered.begin() + bands.s[first] * 3, reordered.end(), lines.begin() + bands.s[first] * 3);
+    }
+
+    // antialiasing the boundaries of the subbands of long blocks
+    if (!t_granule.shortBlocks() || t_granule.mixed_block) {
+
+        std::size_t limit = t_granule.shortBlocks() ? 2 : 32;
+
+        for (std::size_t sb = 1; sb < limit; ++sb) {
+
+            for (std::size_t i = 0; i < 8; ++i) {
+
+                sample& upper = lines[18 * sb - 1 - i];
+                sample& lower = lines[18 * sb + i];
+
+                sample a = upper;
+                sample b = lower;
+
+                upper = DSP::multiply(a, table.cs[i]) - DSP::multiply(b, table.ca[i]);
+                lower = DSP::multiply(b, table.cs[i]) + DSP::multiply(a, table.ca[i]);
+            }
+        }
+    }
+
+    DSP::sample subbands[32][18];
+
+    auto& overlap = m_overlap[t_channel];
+
+    for (std::size_t sb = 0; sb < 32; ++sb) {
+
+        byte block_type = t_granule.mixed_block && sb < 2 ? 0 : t_granule.block_type;
+
+        DSP::inverseMDCT(lines.data() + 18 * sb, overlap.data() + 18 * sb, subbands[sb], block_type);
+
+        // inverting every other sample of the odd subbands, which are mirrored in frequency
+        if (sb % 2 == 1)
+            for (std::size_t t = 1; t < 18; t += 2)
+                subbands[sb][t] = -subbands[sb][t];
+    }
+
+    std::size_t channels = t_header.channels();
+
+    for (std::size_t t = 0; t < 18; ++t) {
+
+        DSP::sample samples[32];
+
+        for (std::size_t sb = 0; sb < 32; ++sb)
+            samples[sb] = subbands[sb][t];
+
+        DSP::synthesize(m_synthesis[t_channel], samples, t_pcm + t * 32 * channels, channels);
+    }
+}
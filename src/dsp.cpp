@@ -0,0 +1,212 @@
+#include <dsp.hpp>
+#include <atomic>
+#include <cmath>
+#include <kernels.hpp>
+#include <numbers>
+
+
+namespace {
+
+    using MP3::DSP::sample;
+
+
+    // synthesis window of ISO/IEC 11172-3 Annex B (Table B.3) scaled by 2^16, only the first half
+    // (the second half is mirrored) and without the sign of every odd block of 64 coefficients
+    constexpr std::int32_t WINDOW[257] = {
+             0,     -1,     -1,     -1,     -1,     -1,     -1,     -2,     -2,     -2,     -2,     -3,     -3,     -4,     -4,     -5,
+            -5,     -6,     -7,     -7,     -8,     -9,    -10,    -11,    -13,    -14,    -16,    -17,    -19,    -21,    -24,    -26,
+           -29,    -31,    -35,    -38,    -41,    -45,    -49,    -53,    -58,    -63,    -68,    -73,    -79,    -85,    -91,    -97,
+          -104,   -111,   -117,   -125,   -132,   -139,   -147,   -154,   -161,   -169,   -176,   -183,   -190,   -196,   -202,   -208,
+          -213,   -218,   -222,   -225,   -227,   -228,   -228,   -227,   -224,   -221,   -215,   -208,   -200,   -189,   -177,   -163,
+          -146,   -127,   -106,    -83,    -57,    -29,      2,     36,     72,    111,    153,    197,    244,    294,    347,    401,
+           459,    519,    581,    645,    711,    779,    848,    919,    991,   1064,   1137,   1210,   1283,   1356,   1428,   1498,
+          1567,   1634,   1698,   1759,   1817,   1870,   1919,   1962,   2001,   2032,   2057,   2075,   2085,   2087,   2080,   2063,
+          2037,   2000,   1952,   1893,   1822,   1739,   1644,   1535,   1414,   1280,   1131,    970,    794,    605,    402,    185,
+           -45,   -288,   -545,   -814,  -1095,  -1388,  -1692,  -2006,  -2330,  -2663,  -3004,  -3351,  -3705,  -4063,  -4425,  -4788,
+         -5153,  -5517,  -5879,  -6237,  -6589,  -6935,  -7271,  -7597,  -7910,  -8209,  -8491,  -8755,  -8998,  -9219,  -9416,  -9585,
+         -9727,  -9838,  -9916,  -9959,  -9966,  -9935,  -9863,  -9750,  -9592,  -9389,  -9139,  -8840,  -8492,  -8092,  -7640,  -7134,
+         -6574,  -5959,  -5288,  -4561,  -3776,  -2935,  -2037,  -1082,    -70,    998,   2122,   3300,   4533,   5818,   7154,   8540,
+          9975,  11455,  12980,  14548,  16155,  17799,  19478,  21189,  22929,  24694,  26482,  28289,  30112,  31947,  33791,  35640,
+         37489,  39336,  41176,  43006,  44821,  46617,  48390,  50137,  51853,  53534,  55178,  56778,  58333,  59838,  61289,  62684,
+         64019,  65290,  66494,  67629,  68692,  69679,  70590,  71420,  72169,  72835,  73415,  73908,  74313,  74630,  74856,  74992,
+         75038
+    };
+
+
+    /**
+     * Converts a floating point value to a coefficient, only used to build the tables.
+     */
+    std::int32_t coefficient(double t_value) noexcept {
+        return static_cast<std::int32_t>(std::lround(t_value * (1 << MP3::DSP::COEFFICIENT_BITS)));
+    }
+
+
+    /**
+     * Coefficient tables, built once on first use.
+     *
+     * imdct_long:  Cosine table of the 36 point IMDCT
+     * imdct_short: Cosine table of the 12 point IMDCT
+     * windows:     IMDCT windows by block type (the short window in the first 12 coefficients of type 2)
+     * matrixing:   Cosine table of the matrixing of the synthesis
+     * synthesis:   Synthesis window
+     */
+    struct Tables {
+        std::int32_t imdct_long[36][18];
+        std::int32_t imdct_short[12][6];
+        std::int32_t windows[4][36];
+        std::int32_t matrixing[64][32];
+        std::int32_t synthesis[512];
+    };
+
+
+    /**
+     * @return the selected instruction set, initially the best one that is supported
+     */
+    std::atomic<MP3::DSP::Kernel>& selected() noexcept {
+
+        static std::atomic<MP3::DSP::Kernel> kernel = [] {
+
+            for (auto candidate : {MP3::DSP::AVX2, MP3::DSP::SSE2, MP3::DSP::NEON})
+                if (MP3::DSP::kernels(candidate))
+                    return candidate;
+
+            return MP3::DSP::SCALAR;
+        }();
+
+        return kernel;
+    }
+
+
+    const MP3::DSP::Kernels& active() noexcept {
+        return *MP3::DSP::kernels(selected().load(std::memory_order_relaxed));
+    }
+
+
+    const Tables& tables() noexcept {
+
+        static const Tables tables = [] {
+
+            using std::numbers::pi;
+
+            Tables result{};
+
+            for (std::size_t i = 0; i < 36; ++i)
+                for (std::size_t k = 0; k < 18; ++k)
+                    result.imdct_long[i][k] = coefficient(std::cos(pi / 72 * static_cast<double>((2 * i + 1 + 18) * (2 * k + 1))));
+
+            for (std::size_t i = 0; i < 12; ++i)
+                for (std::size_t k = 0; k < 6; ++k)
+                    result.imdct_short[i][k] = coefficient(std::cos(pi / 24 * static_cast<double>((2 * i + 1 + 6) * (2 * k + 1))));
+
+            for (std::size_t i = 0; i < 36; ++i) {
+
+                double normal = std::sin(pi / 36 * (static_cast<double>(i) + 0.5));
+
+                result.windows[0][i] = coefficient(normal);
+
+                // start block, normal rising half followed by the falling half of a short window
+                result.windows[1][i] = coefficient(i < 18 ? normal : i < 24 ? 1.0 : i < 30 ? std::sin(pi / 12 * (static_cast<double>(i) - 18 + 0.5)) : 0.0);
+
+                // stop block, rising half of a short window followed by the normal falling half
+                result.windows[3][i] = coefficient(i < 6 ? 0.0 : i < 12 ? std::sin(pi / 12 * (static_cast<double>(i) - 6 + 0.5)) : i < 18 ? 1.0 : normal);
+
+                result.windows[2][i] = i < 12 ? coefficient(std::sin(pi / 12 * (static_cast<double>(i) + 0.5))) : 0;
+            }
+
+            for (std::size_t i = 0; i < 64; ++i)
+                for (std::size_t k = 0; k < 32; ++k)
+                    result.matrixing[i][k] = coefficient(std::cos(pi / 64 * static_cast<double>((16 + i) * (2 * k + 1))));
+
+            for (std::size_t i = 0; i < 512; ++i) {
+
+                std::int32_t value = WINDOW[i <= 256 ? i : 512 - i];
+
+                result.synthesis[i] = ((i / 64) % 2 == 1 ? -value : value) * (1 << (MP3::DSP::COEFFICIENT_BITS - 16));
+            }
+
+            return result;
+        }();
+
+        return tables;
+    }
+}
+
+
+void MP3::DSP::inverseMDCT(const sample t_lines[18], sample t_overlap[18], sample t_samples[18], byte t_block_type) noexcept {
+
+    const auto& table = tables();
+
+    sample block[36];
+
+    if (t_block_type != 2) {
+
+        const auto& window = table.windows[t_block_type];
+
+        active().transform(table.imdct_long[0], t_lines, 36, 18, block);
+
+        for (std::size_t i = 0; i < 36; ++i)
+            block[i] = multiply(block[i], window[i]);
+    }
+
+    // three overlapping short blocks, placed at 6, 12 and 18
+    else {
+
+        const auto& window = table.windows[2];
+
+        std::fill(block, block + 36, 0);
+
+        for (std::size_t w = 0; w < 3; ++w) {
+
+            sample lines[6];
+            sample samples[12];
+
+            for (std::size_t k = 0; k < 6; ++k)
+                lines[k] = t_lines[3 * k + w];
+
+            active().transform(table.imdct_short[0], lines, 12, 6, samples);
+
+            for (std::size_t i = 0; i < 12; ++i)
+                block[6 + 6 * w + i] += multiply(samples[i], window[i]);
+        }
+    }
+
+    for (std::size_t i = 0; i < 18; ++i) {
+        t_samples[i] = block[i] + t_overlap[i];
+        t_overlap[i] = block[18 + i];
+    }
+}
+
+
+MP3::DSP::Kernel MP3::DSP::kernel() noexcept {
+    return selected().load(std::memory_order_relaxed);
+}
+
+
+bool MP3::DSP::useKernel(Kernel t_kernel) noexcept {
+
+    if (!kernels(t_kernel))
+        return false;
+
+    selected().store(t_kernel, std::memory_order_relaxed);
+
+    return true;
+}
+
+
+void MP3::DSP::synthesize(Synthesis& t_state, const sample t_subbands[32], std::int16_t* t_pcm, std::size_t t_stride) noexcept {
+
+    const auto& table = tables();
+    const auto& kernels = active();
+
+    t_state.offset = (t_state.offset + 1024 - 64) & 1023;
+
+    kernels.transform(table.matrixing[0], t_subbands, 64, 32, t_state.v.data() + t_state.offset);
+
+    // windowing of the U vector, which consists of the first and last 32 values of every other V vector
+    sample samples[32];
+
+    kernels.window(t_state.v.data(), t_state.offset, table.synthesis, samples);
+
+    for (std::size_t j = 0; j < 32; ++j)
+        t_pcm[j * t_stride] = toPCM(samples[j]);
+}
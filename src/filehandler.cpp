@@ -1,17 +1,30 @@
 #include <filehandler.hpp>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <log.hpp>
 
 
-Filehandler::Filehandler(std::string  t_filename) noexcept : m_filename(std::move(t_filename)) {
+Filehandler::Filehandler(std::string  t_filename, bool t_map) noexcept : m_filename(std::move(t_filename)) {
 
     log::info(fmt::format("Creating file handler object for file {}", m_filename));
 
     if (exists()) {
 
-        log::info(fmt::format("Opening file {}", m_filename));
+        if (t_map && map()) {
+            log::info(fmt::format("Mapped {} bytes of file {}", m_mapping_size, m_filename));
+        }
+
+        else {
 
-        this->m_stream.open(m_filename, std::ios::binary | std::ios::in);
+            log::info(fmt::format("Opening file {}", m_filename));
+
+            this->m_stream.open(m_filename, std::ios::binary | std::ios::in);
+        }
     }
 
     else
@@ -19,10 +32,89 @@ Filehandler::Filehandler(std::string  t_filename) noexcept : m_filename(std::mov
 }
 
 
+Filehandler::Filehandler(Filehandler && t_other) noexcept : m_filename(std::move(t_other.m_filename)), m_stream(std::move(t_other.m_stream)),
+                                                            m_mapping(t_other.m_mapping), m_mapping_size(t_other.m_mapping_size) {
+
+    t_other.m_mapping = nullptr;
+    t_other.m_mapping_size = 0;
+}
+
+
+bool Filehandler::map() noexcept {
+
+    int fd = ::open(m_filename.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        log::warn(fmt::format("Could not open {} for mapping, falling back to a stream", m_filename));
+        return false;
+    }
+
+    struct stat info{};
+
+    // empty files can not be mapped
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    auto size = static_cast<std::size_t>(info.st_size);
+
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping stays valid after closing the file descriptor
+    ::close(fd);
+
+    if (mapping == MAP_FAILED) {
+        log::warn(fmt::format("Could not map {}, falling back to a stream", m_filename));
+        return false;
+    }
+
+    m_mapping = static_cast<const char*>(mapping);
+    m_mapping_size = size;
+
+    return true;
+}
+
+
+void Filehandler::unmap() const noexcept {
+
+    if (m_mapping != nullptr) {
+
+        log::info(fmt::format("Unmapping file {}", m_filename));
+
+        munmap(const_cast<char*>(m_mapping), m_mapping_size);
+
+        m_mapping = nullptr;
+        m_mapping_size = 0;
+    }
+}
+
+
+void Filehandler::copyBytes(char t_buffer[], const std::uint32_t t_position, enum std::_Ios_Seekdir t_way, const std::uint32_t t_bytes) const noexcept {
+
+    std::uint64_t start = t_position;
+
+    if (t_way == std::ios_base::end)
+        start += m_mapping_size;
+
+    if (start < m_mapping_size) {
+
+        auto count = std::min<std::uint64_t>(t_bytes, m_mapping_size - start);
+
+        std::memcpy(t_buffer, m_mapping + start, count);
+    }
+}
+
+
 void Filehandler::readBytes(char t_buffer[], const std::uint32_t t_position, const std::uint32_t t_bytes) const noexcept {
 
     log::debug(fmt::format("Reading {} bytes starting at offset {} from file: ", t_bytes, t_position, m_filename));
 
+    if (isMapped()) {
+        copyBytes(t_buffer, t_position, std::ios::beg, t_bytes);
+        return;
+    }
+
     m_stream.seekg(t_position, std::ios::beg);
     m_stream.read(t_buffer, t_bytes);
 
@@ -34,6 +126,11 @@ void Filehandler::readBytes(char t_buffer[], const std::uint32_t t_position, enu
     log::debug(fmt::format("Reading {} bytes starting at offset {} relative to the {} of the file: {}",
                            t_bytes, t_position, (t_way == std::ios_base::beg ? "beginning" : "end"), m_filename));
 
+    if (isMapped()) {
+        copyBytes(t_buffer, t_position, t_way, t_bytes);
+        return;
+    }
+
     m_stream.seekg(t_position, t_way);
     m_stream.read(t_buffer, t_bytes);
 
@@ -61,6 +158,12 @@ void Filehandler::deleteBytes(std::uint32_t t_position, std::uint32_t t_bytes) c
 
     // TODO assert that all read/write operations were successful before deleting file at the end
 
+    // the file is going to be replaced, so the mapping of the old file is of no use anymore
+    if (isMapped()) {
+        unmap();
+        m_stream.open(m_filename, std::ios::binary | std::ios::in);
+    }
+
     // opening a temporary file to write the content of the original file to
     std::ofstream stream;
     stream.open(m_filename + ".tmp", std::ios::binary | std::ios::out);
@@ -244,8 +347,13 @@ void Filehandler::readString(std::string& t_string, const std::uint32_t t_positi
     // reserving enough space for the string and a potentially missing  null terminator to avoid reallocation
     buffer.reserve(t_bytes + 1);
 
-    m_stream.seekg(t_position, std::ios::beg);
-    m_stream.read(buffer.data(), t_bytes);
+    if (isMapped())
+        copyBytes(buffer.data(), t_position, std::ios::beg, t_bytes);
+
+    else {
+        m_stream.seekg(t_position, std::ios::beg);
+        m_stream.read(buffer.data(), t_bytes);
+    }
 
     // if the string read is not null terminated its contents are copied into a new
     // buffer that is one byte longer, and a '\0' byte is added at the end
@@ -272,8 +380,13 @@ void Filehandler::readString(std::string& t_string, const std::uint32_t t_positi
     // reserving enough space for the string and a potentially missing null terminator to avoid reallocation
     buffer.reserve(t_bytes + 1);
 
-    m_stream.seekg(t_position, t_way);
-    m_stream.read(buffer.data(), t_bytes);
+    if (isMapped())
+        copyBytes(buffer.data(), t_position, t_way, t_bytes);
+
+    else {
+        m_stream.seekg(t_position, t_way);
+        m_stream.read(buffer.data(), t_bytes);
+    }
 
     // if the string read is not null terminated its contents are copied into a new
     // buffer that is one byte longer, and a '\0' byte is added at the end
@@ -291,6 +404,26 @@ std::unique_ptr<std::vector<std::string>> Filehandler::read() const noexcept {
 
     log::info(fmt::format("Reading file: {}", m_filename));
 
+    if (isMapped()) {
+
+        auto lines = std::make_unique<std::vector<std::string>>();
+
+        std::string_view content(m_mapping, m_mapping_size);
+
+        while (!content.empty()) {
+
+            auto end = content.find('\n');
+
+            lines->emplace_back(content.substr(0, end));
+
+            content.remove_prefix(end == std::string_view::npos ? content.size() : end + 1);
+        }
+
+        log::info(fmt::format("Read {} lines in file {}", lines->size(), m_filename));
+
+        return lines;
+    }
+
     char data[1];
 
     m_stream.seekg(0, std::ios::beg);
@@ -319,6 +452,8 @@ std::unique_ptr<std::vector<std::string>> Filehandler::read() const noexcept {
 
 Filehandler::~Filehandler() noexcept {
 
+    unmap();
+
     if(m_stream.is_open()) {
         log::info(fmt::format("Closing stream of {}", m_filename));
         m_stream.close();
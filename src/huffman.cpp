@@ -0,0 +1,246 @@
+#include <huffman.hpp>
+#include <algorithm>
+#include <utility>
+
+
+namespace {
+
+    using MP3::Huffman::CodeTable;
+
+
+    /**
+     * Entry of a lookup table, indexed by the next bits of the stream.
+     *
+     * Codes of up to ROOT_BITS bits are decoded with a single lookup. The entries of longer codes
+     * refer to a second level table, which is indexed by the bits after the first ROOT_BITS bits.
+     *
+     * value:  The symbol, or the position of the second level table if bits is not 0
+     * length: The number of bits to consume
+     * bits:   The number of bits that index the second level table, 0 for symbols
+     */
+    struct Entry {
+        std::uint16_t value;
+        std::uint8_t length;
+        std::uint8_t bits;
+    };
+
+
+    // the largest number of bits of the first level tables
+    constexpr std::size_t ROOT_BITS = 8;
+
+
+    /**
+     * Bits and size of a lookup table.
+     *
+     * root: The number of bits of the first level table
+     * size: The number of entries of all levels
+     */
+    struct Layout {
+        std::size_t root;
+        std::size_t size;
+    };
+
+
+    /**
+     * @return the length of the longest code that starts with t_prefix and is longer than t_root bits, 0 if there is none
+     */
+    constexpr std::size_t longest(const CodeTable& t_table, std::size_t t_symbols, std::size_t t_root, std::size_t t_prefix) {
+
+        std::size_t length = 0;
+
+        for (std::size_t symbol = 0; symbol < t_symbols; ++symbol)
+            if (t_table.lengths[symbol] > t_root && (std::size_t{t_table.codes[symbol]} >> (t_table.lengths[symbol] - t_root)) == t_prefix)
+                length = std::max<std::size_t>(length, t_table.lengths[symbol]);
+
+        return length;
+    }
+
+
+    constexpr Layout layout(const CodeTable& t_table, std::size_t t_symbols) {
+
+        std::size_t length = 0;
+
+        for (std::size_t symbol = 0; symbol < t_symbols; ++symbol)
+            length = std::max<std::size_t>(length, t_table.lengths[symbol]);
+
+        Layout result{std::min(length, ROOT_BITS), 0};
+
+        result.size = std::size_t{1} << result.root;
+
+        for (std::size_t prefix = 0; prefix < (std::size_t{1} << result.root); ++prefix)
+            if (std::size_t bits = longest(t_table, t_symbols, result.root, prefix); bits != 0)
+                result.size += std::size_t{1} << (bits - result.root);
+
+        return result;
+    }
+
+
+    /**
+     * Builds the lookup table of a code table.
+     *
+     * @param t_table   The code table
+     * @param t_symbols The number of symbols in the table
+     */
+    template <std::size_t SIZE>
+    constexpr std::array<Entry, SIZE> build(const CodeTable& t_table, std::size_t t_symbols) {
+
+        std::array<Entry, SIZE> entries{};
+
+        std::size_t root = layout(t_table, t_symbols).root;
+        std::size_t next = std::size_t{1} << root;
+
+        for (std::size_t prefix = 0; prefix < (std::size_t{1} << root); ++prefix) {
+            if (std::size_t length = longest(t_table, t_symbols, root, prefix); length != 0) {
+                entries[prefix] = {static_cast<std::uint16_t>(next), static_cast<std::uint8_t>(root), static_cast<std::uint8_t>(length - root)};
+                next += std::size_t{1} << (length - root);
+            }
+        }
+
+        for (std::size_t symbol = 0; symbol < t_symbols; ++symbol) {
+
+            std::size_t length = t_table.lengths[symbol];
+            std::size_t code = t_table.codes[symbol];
+
+            // the code fills every entry it is a prefix of
+            std::size_t first = 0;
+            std::size_t count = 0;
+            std::size_t consumed = length;
+
+            if (length <= root) {
+                first = code << (root - length);
+                count = std::size_t{1} << (root - length);
+            }
+
+            else {
+
+                const Entry& table = entries[code >> (length - root)];
+
+                consumed = length - root;
+                first = table.value + ((code & ((std::size_t{1} << consumed) - 1)) << (table.bits - consumed));
+                count = std::size_t{1} << (table.bits - consumed);
+            }
+
+            for (std::size_t i = 0; i < count; ++i)
+                entries[first + i] = {static_cast<std::uint16_t>(symbol), static_cast<std::uint8_t>(consumed), 0};
+        }
+
+        return entries;
+    }
+
+
+    /**
+     * @return the index of the table in TABLES that holds the codes of table t_table,
+     *         tables that only differ by linbits share their lookup tables
+     */
+    constexpr std::size_t codes(std::size_t t_table) noexcept {
+        return t_table < 16 ? t_table : t_table < 24 ? 16 : 24;
+    }
+
+
+    template <std::size_t TABLE>
+    constexpr std::size_t SYMBOLS = std::size_t{MP3::Huffman::TABLES[TABLE].dimension} * MP3::Huffman::TABLES[TABLE].dimension;
+
+    template <std::size_t TABLE>
+    constexpr auto LOOKUP = build<layout(MP3::Huffman::TABLES[TABLE], SYMBOLS<TABLE>).size>(MP3::Huffman::TABLES[TABLE], SYMBOLS<TABLE>);
+
+    template <std::size_t TABLE>
+    constexpr auto COUNT1_LOOKUP = build<layout(MP3::Huffman::COUNT1_TABLES[TABLE], 16).size>(MP3::Huffman::COUNT1_TABLES[TABLE], 16);
+
+
+    /**
+     * View of a lookup table.
+     *
+     * entries: The entries of all levels
+     * root:    The number of bits of the first level table
+     */
+    struct Lookup {
+        const Entry* entries;
+        std::size_t root;
+    };
+
+
+    template <std::size_t... TABLES>
+    constexpr std::array<Lookup, 32> lookups(std::index_sequence<TABLES...>) noexcept {
+
+        auto lookup = []<std::size_t TABLE>() -> Lookup {
+
+            if constexpr (MP3::Huffman::TABLES[TABLE].dimension == 0)
+                return {nullptr, 0};
+
+            else
+                return {LOOKUP<codes(TABLE)>.data(), layout(MP3::Huffman::TABLES[TABLE], SYMBOLS<TABLE>).root};
+        };
+
+        return {lookup.template operator()<TABLES>()...};
+    }
+
+
+    // lookup tables by table_select
+    constexpr std::array<Lookup, 32> LOOKUPS = lookups(std::make_index_sequence<32>());
+
+    // lookup tables by count1table_select
+    constexpr std::array<Lookup, 2> COUNT1_LOOKUPS = {{
+        {COUNT1_LOOKUP<0>.data(), layout(MP3::Huffman::COUNT1_TABLES[0], 16).root},
+        {COUNT1_LOOKUP<1>.data(), layout(MP3::Huffman::COUNT1_TABLES[1], 16).root}
+    }};
+
+
+    /**
+     * Decodes a symbol with at most two lookups.
+     */
+    inline std::int32_t decode(const Lookup& t_lookup, BitReader& t_reader) noexcept {
+
+        Entry entry = t_lookup.entries[t_reader.peek(t_lookup.root)];
+
+        if (entry.bits != 0) {
+            t_reader.skip(entry.length);
+            entry = t_lookup.entries[entry.value + t_reader.peek(entry.bits)];
+        }
+
+        t_reader.skip(entry.length);
+
+        return entry.value;
+    }
+}
+
+
+void MP3::Huffman::decodePair(BitReader& t_reader, std::uint32_t t_table, std::int32_t& t_x, std::int32_t& t_y) noexcept {
+
+    const auto& table = TABLES[t_table];
+
+    if (table.dimension == 0) {
+        t_x = t_y = 0;
+        return;
+    }
+
+    std::int32_t symbol = decode(LOOKUPS[t_table], t_reader);
+
+    t_x = symbol / table.dimension;
+    t_y = symbol % table.dimension;
+
+    if (table.linbits != 0 && t_x == 15)
+        t_x += static_cast<std::int32_t>(t_reader.read(table.linbits));
+
+    if (t_x != 0 && t_reader.bit())
+        t_x = -t_x;
+
+    if (table.linbits != 0 && t_y == 15)
+        t_y += static_cast<std::int32_t>(t_reader.read(table.linbits));
+
+    if (t_y != 0 && t_reader.bit())
+        t_y = -t_y;
+}
+
+
+void MP3::Huffman::decodeQuadruple(BitReader& t_reader, std::uint32_t t_table, std::int32_t t_values[4]) noexcept {
+
+    std::int32_t symbol = decode(COUNT1_LOOKUPS[t_table], t_reader);
+
+    for (std::size_t i = 0; i < 4; ++i) {
+
+        t_values[i] = (symbol >> (3 - i)) & 0x01;
+
+        if (t_values[i] != 0 && t_reader.bit())
+            t_values[i] = -t_values[i];
+    }
+}
@@ -1,14 +1,15 @@
 #include <id3.hpp>
+#include <artstore.hpp>
+#include <cstring>
+#include <mp3.hpp>
 #include <picture.hpp>
+#include <zlib.h>
 
 using namespace ID3;
 
-bool ID3::detectID3(Filehandler& t_handler) noexcept {
+bool ID3::detectID3(const char t_header[]) noexcept {
 
-    std::string s;
-    t_handler.readString(s, LOCATION_START, 3);
-
-    bool result = s == "ID3";
+    bool result = t_header[0] == 'I' && t_header[1] == 'D' && t_header[2] == '3';
 
     log::debug(result ? "Found ID3 header!" : "No ID3 header present in file");
 
@@ -31,13 +32,9 @@ bool detectID3Footer(Filehandler& t_handler) noexcept {
 }
 
 
-std::uint8_t ID3::getVersion(Filehandler& t_handler) noexcept {
-
-    char buffer[SIZE_OF_VERSION];
-
-    t_handler.readBytes(buffer, LOCATION_VERSION, SIZE_OF_VERSION);
+std::uint8_t ID3::getVersion(const char t_header[]) noexcept {
 
-    auto version = static_cast<std::uint8_t>(*buffer);
+    auto version = static_cast<std::uint8_t>(t_header[LOCATION_VERSION]);
 
 
     log::debug(fmt::format("ID3 file has version: 2.{:d}", version));
@@ -46,26 +43,44 @@ std::uint8_t ID3::getVersion(Filehandler& t_handler) noexcept {
 }
 
 
-std::uint8_t ID3::getFlags(Filehandler& t_handler) noexcept {
-    char buffer[SIZE_OF_FLAGS];
+std::uint8_t ID3::getFlags(const char t_header[]) noexcept {
+
+    return static_cast<std::uint8_t>(t_header[LOCATION_FLAGS]);
+}
 
-    t_handler.readBytes(buffer, LOCATION_FLAGS, SIZE_OF_FLAGS);
 
-    return static_cast<std::uint8_t>(*buffer);
+std::uint32_t ID3::getSize(const char t_buffer[], const bool t_syncsafe) noexcept {
+
+    // TODO max size of tag (update this as well as position)
+    auto size = static_cast<std::uint32_t>(convert_bytes(t_buffer, SIZE_OF_SIZE, t_syncsafe));
+
+    return size;
 }
 
 
-std::uint32_t ID3::getSize(Filehandler& t_handler, const bool t_extended) noexcept {
+std::size_t ID3::synchronize(std::span<const char> t_data, char t_output[]) noexcept {
 
-    const unsigned char BUFFER_LOCATION = t_extended ? SIZE_OF_HEADER : LOCATION_SIZE;
+    std::size_t position = 0;
+    std::size_t size = 0;
 
-    std::array<char, SIZE_OF_SIZE> buffer{};
+    while (position < t_data.size()) {
 
-    t_handler.readBytes(buffer.data(), BUFFER_LOCATION, SIZE_OF_SIZE);
+        const void* sync = std::memchr(t_data.data() + position, 0xff, t_data.size() - position);
 
+        // the run of bytes up to and including the next 0xff byte
+        std::size_t end = sync == nullptr ? t_data.size() : static_cast<std::size_t>(static_cast<const char*>(sync) - t_data.data()) + 1;
 
-    // TODO max size of tag (update this as well as position)
-    auto size = static_cast<std::uint32_t>(convert_bytes(buffer.data(), SIZE_OF_SIZE, true));
+        // nothing has to be moved until the first byte has been removed when synchronizing in place
+        if (t_output + size != t_data.data() + position)
+            std::memmove(t_output + size, t_data.data() + position, end - position);
+
+        size += end - position;
+        position = end;
+
+        // skipping the 0x00 byte that has been inserted after the 0xff byte
+        if (sync != nullptr && position < t_data.size() && t_data[position] == 0x00)
+            ++position;
+    }
 
     return size;
 }
@@ -73,287 +88,511 @@ std::uint32_t ID3::getSize(Filehandler& t_handler, const bool t_extended) noexce
 
 void ID3::synchronize(std::vector<char>& t_data) noexcept {
 
-    bool sync = true;
+    t_data.resize(synchronize(t_data, t_data.data()));
+}
 
-    for (std::uint_fast32_t i = 0; i < t_data.size(); ++i) {
-        if (sync) {
-            sync = (static_cast<unsigned char>(t_data.at(i)) != 0xff);
-        }
 
-        else {
-            if (t_data.at(i) == 0x00)
-                t_data.erase(t_data.begin() + static_cast<long>(i));
+namespace {
 
-            sync = true;
-        }
+    /**
+     * Handles a TIT2 frame, the title of the song.
+     */
+    void parseTitle(const FrameData& t_frame, [[maybe_unused]] std::span<const char> t_tag, Song& t_song, [[maybe_unused]] const ParseOptions& t_options, ParseContext& t_context) noexcept {
+
+        auto data = t_frame.data();
 
+        // TODO deal with possibility of having an error
+        auto content = decode_text(data[LOCATION_TEXT_ENCODING], data, LOCATION_TEXT, t_context.arena());
+
+        log::info(fmt::format("Found a TIT2 frame, setting song title to: {}", std::string_view(content)));
+
+        t_song.m_title = std::string(content);
     }
 
-}
 
+    /**
+     * Handles a TALB frame, the album title.
+     */
+    void parseAlbum(const FrameData& t_frame, [[maybe_unused]] std::span<const char> t_tag, Song& t_song, [[maybe_unused]] const ParseOptions& t_options, ParseContext& t_context) noexcept {
 
-std::unique_ptr<std::vector<char>> ID3::prepareFrameData(Filehandler& t_handler, FrameHeader& t_frame_header, std::uint32_t& t_position) noexcept {
+        auto data = t_frame.data();
 
-    log::debug(fmt::format("Reading {} bytes of Frame with ID {}", t_frame_header.size, t_frame_header.id));
+        // TODO deal with possibility of having an error
+        auto content = decode_text(data[LOCATION_TEXT_ENCODING], data, LOCATION_TEXT, t_context.arena());
 
-    auto frame_content = readFrame(t_handler, t_position, t_frame_header.size);
+        log::info(fmt::format("Found a TALB frame, setting album title to: {}", std::string_view(content)));
 
-    // synchronizing frame data
-    if (t_frame_header.format_flags & (1 << 1))
-        synchronize(*frame_content);
+        t_song.m_album = std::string(content);
+    }
 
 
-    if (t_frame_header.format_flags & (1 << 2)) {
-        log::debug(fmt::format("{} is an encrypted frame...", t_frame_header.id));
-        // TODO frame is encrypted
-        // TODO 1 byte with encryption method is added
-        // TODO see ENCR frame
-        // TODO decrypt after sync
+    /**
+     * Handles a TPE1 frame, the artist.
+     */
+    void parseArtist(const FrameData& t_frame, [[maybe_unused]] std::span<const char> t_tag, Song& t_song, [[maybe_unused]] const ParseOptions& t_options, ParseContext& t_context) noexcept {
+
+        auto data = t_frame.data();
+
+        // TODO deal with possibility of having an error
+        auto content = decode_text(data[LOCATION_TEXT_ENCODING], data, LOCATION_TEXT, t_context.arena());
+
+        log::info(fmt::format("Found a TPE1 frame, setting artist to: {}", std::string_view(content)));
+
+        t_song.m_artist = std::string(content);
     }
 
-    if (t_frame_header.format_flags & (1 << 3)) {
-        log::debug(fmt::format("{} is a compressed frame...", t_frame_header.id));
-        // TODO frame is compressed with zlib
-        // TODO decompress after sync
+
+    /**
+     * Handles a TDRL frame, the release time.
+     */
+    void parseReleaseTime(const FrameData& t_frame, [[maybe_unused]] std::span<const char> t_tag, Song& t_song, [[maybe_unused]] const ParseOptions& t_options, ParseContext& t_context) noexcept {
+
+        auto data = t_frame.data();
+
+        // starting from 0, five characters (4 + '\0')
+        // TODO is this right?
+        // TODO deal with possibility of having an error
+        auto content = std::string_view(decode_text(data[LOCATION_TEXT_ENCODING], data, LOCATION_TEXT, t_context.arena())).substr(0, 5);
+
+        log::info(fmt::format("Found a TDRL frame, setting release year to: {}", content));
+
+        t_song.m_release = std::string(content);
     }
 
-    return frame_content;
 
-}
+    /**
+     * Handles a TDRC frame, the recording time.
+     */
+    void parseRecordingTime(const FrameData& t_frame, [[maybe_unused]] std::span<const char> t_tag, Song& t_song, [[maybe_unused]] const ParseOptions& t_options, ParseContext& t_context) noexcept {
 
+        // release year has precedence over recording year but if
+        // there is no TDRL frame, this frame will be used for the date instead
+        if (t_song.m_release.empty()) {
 
-bool ID3::parseFrame(Filehandler& t_handler, FrameHeader& t_frame_header, std::uint32_t& t_position, Song& t_song) noexcept {
+            auto data = t_frame.data();
 
-    // this frame is a padding frame, skipping
-    if (t_frame_header.id[0] == 0x00) {
+            // starting from 0, five characters (4 + '\0')
+            // TODO is this right?
+            // TODO deal with possibility of having an error
+            auto content = std::string_view(decode_text(data[LOCATION_TEXT_ENCODING], data, LOCATION_TEXT, t_context.arena())).substr(0, 5);
 
-        log::debug("Encountered a frame id starting with 0x00 which is probably due to padding, skipping to the end of the tag...");
+            log::info(fmt::format("Found a TDRC frame, setting release year to: {}", content));
 
-        // TODO this does not work, there is no such things as 'padding frames'
-        // TODO I have to skip to the end of the tag
-        t_position += t_frame_header.size;
+            t_song.m_release = std::string(content);
+        }
 
-        return false;
+        else {
+
+            log::info("Found a TDRC frame, but release year has already been set. Skipping...");
+        }
     }
 
-    else {
 
+    /**
+     * Handles a TLEN frame, the length of the song.
+     */
+    void parseLength(const FrameData& t_frame, [[maybe_unused]] std::span<const char> t_tag, Song& t_song, [[maybe_unused]] const ParseOptions& t_options, [[maybe_unused]] ParseContext& t_context) noexcept {
 
-        if (t_frame_header.id == "TIT2") {
+        auto data = t_frame.data();
 
-            auto data = *prepareFrameData(t_handler, t_frame_header, t_position);
+        auto len = convert_bytes(data.data(), static_cast<std::uint32_t>(data.size()), false);
 
-            // TODO deal with possibility of having an error
-            std::string content = decode_text(data.at(LOCATION_TEXT_ENCODING), data, LOCATION_TEXT);
+        log::info(fmt::format("Found a TLEN frame, setting track length to: {}", len));
+
+        t_song.m_duration = len;
+    }
 
-            log::info(fmt::format("Found a TIT2 frame, setting song title to: {}", content));
 
-            t_song.m_title = content;
+    /**
+     * Handles a TDLY frame, the playlist delay.
+     */
+    void parsePlaylistDelay(const FrameData& t_frame, [[maybe_unused]] std::span<const char> t_tag, Song& t_song, [[maybe_unused]] const ParseOptions& t_options, [[maybe_unused]] ParseContext& t_context) noexcept {
 
-        } else if (t_frame_header.id == "TALB") {
+        auto data = t_frame.data();
 
-            auto data = *prepareFrameData(t_handler, t_frame_header, t_position);
+        auto delay = convert_bytes(data.data(), static_cast<std::uint32_t>(data.size()), false);
 
-            // TODO deal with possibility of having an error
-            std::string content = decode_text(data.at(LOCATION_TEXT_ENCODING), data, LOCATION_TEXT);
+        log::info(fmt::format("Found a TDLY frame, setting delay to: {}ms", delay));
+
+        t_song.m_delay = delay;
+    }
 
-            log::info(fmt::format("Found a TALB frame, setting album title to: {}", content));
 
-            t_song.m_album = content;
+    /**
+     * Handles a TCON frame, the content type.
+     */
+    void parseContentType(const FrameData& t_frame, [[maybe_unused]] std::span<const char> t_tag, Song& t_song, [[maybe_unused]] const ParseOptions& t_options, ParseContext& t_context) noexcept {
 
-        } else if (t_frame_header.id == "TPE1") {
+        // custom genres have precedence over content type but if
+        // there is no custom genre set, this frame will be used for the genre instead
+        // TODO this is different for older tag versions
+        if (t_song.m_genre == "Unknown Genre") {
 
-            auto data = *prepareFrameData(t_handler, t_frame_header, t_position);
+            auto data = t_frame.data();
 
             // TODO deal with possibility of having an error
-            std::string content = decode_text(data.at(LOCATION_TEXT_ENCODING), data, LOCATION_TEXT);
+            auto content = decode_text(data[LOCATION_TEXT_ENCODING], data, LOCATION_TEXT, t_context.arena());
 
-            log::info(fmt::format("Found a TPE1 frame, setting artist to: {}", content));
+            log::info(fmt::format("Found a TCON frame, setting genre to: {}", std::string_view(content)));
 
-            t_song.m_artist = content;
+            // TODO not sure if this is always fine (as there can also be numbers apparently)
+            //      so maybe this is not the correct way to "parse" the data, but I'll have to
+            //      check with more files.
+            t_song.m_genre = std::string(content);
+        }
+    }
 
-        } else if (t_frame_header.id == "TDRL") {
 
-            auto data = *prepareFrameData(t_handler, t_frame_header, t_position);
+    /**
+     * Handles a TRCK frame, the track number.
+     */
+    void parseTrackNumber(const FrameData& t_frame, [[maybe_unused]] std::span<const char> t_tag, Song& t_song, [[maybe_unused]] const ParseOptions& t_options, [[maybe_unused]] ParseContext& t_context) noexcept {
 
+        auto data = t_frame.data();
 
-            // starting from 0, five characters (4 + '\0')
-            // TODO is this right?
-            // TODO deal with possibility of having an error
-            std::string content = decode_text(data.at(LOCATION_TEXT_ENCODING), data, LOCATION_TEXT).substr(0, 5);
+        // TRCK frame can contain a / with the total amount of tracks
+        // after the track number. I don't care about that
+        std::string track_number(data.begin(), std::find(data.begin(), data.end(), '/'));
+
+        log::info(fmt::format("Found a TRCK frame, setting track number to: {}", track_number));
+
+        t_song.m_track_number = track_number;
+    }
+
+
+    /**
+     * Handles an APIC frame, an attached picture.
+     */
+    void parsePicture(const FrameData& t_frame, std::span<const char> t_tag, Song& t_song, const ParseOptions& t_options, ParseContext& t_context) noexcept {
+
+        log::info("Found an APIC frame");
+
+        auto data = t_frame.data();
+
+        std::uint32_t iterator = 0;
+
+        // byte indicating text encoding
+        std::int8_t text_encoding = data[iterator++];
+
+        std::string mime_type(data.begin() + iterator, std::find(data.begin() + iterator, data.end(), '\0'));
+
+        iterator += static_cast<std::uint32_t>(mime_type.size());
+
+        // skipping the null terminator of the MIME type
+        iterator++;
+
+        log::debug(fmt::format("Found picture with MIME type: {}", mime_type));
+
+        if (iterator >= data.size()) {
+            log::error("APIC frame ends before the picture type");
+        }
+
+        // MIME Type is not a link, continuing as planned
+        else if (mime_type != "-->") {
+
+            auto pic_type = static_cast<ID3::PictureType>(data[iterator++]);
+
+            auto container = decode_text_retain_position(text_encoding, data, iterator, t_context.arena());
+
+            if (!container.error) {
+
+                iterator = container.position;
 
-            log::info(fmt::format("Found a TDRL frame, setting release year to: {}", content));
+                auto picture = data.subspan(iterator);
 
-            t_song.m_release = content;
+                auto size = static_cast<std::uint32_t>(picture.size());
 
-        } else if (t_frame_header.id == "TDRC") {
+                // songs of the same album usually share the same cover, the
+                // hash is used to keep only one copy of identical pictures in memory
+                auto hash = ArtStore::hash(picture);
 
-            // release year has precedence over recording year but if
-            // there is no TDRL frame, this frame will be used for the date instead
-            if (t_song.m_release.empty()) {
+                // the offset in the file is only known if the frame data did not have to be altered
+                bool in_file = t_options.in_file && !t_frame.owned();
 
-                auto data = *prepareFrameData(t_handler, t_frame_header, t_position);
+                std::uint32_t offset = in_file ? static_cast<std::uint32_t>(SIZE_OF_HEADER + (data.data() - t_tag.data()) + iterator) : 0;
 
-                // starting from 0, five characters (4 + '\0')
-                // TODO is this right?
-                // TODO deal with possibility of having an error
-                std::string content = decode_text(data.at(LOCATION_TEXT_ENCODING), data, LOCATION_TEXT).substr(0, 5);
+                // only recording where the data is, it is loaded once it is needed
+                if (t_options.lazy_art && in_file) {
 
-                log::info(fmt::format("Found a TDRC frame, setting release year to: {}", content));
+                    log::debug(fmt::format("Recording location of {} bytes of picture data at offset {}", size, offset));
+
+                    t_song.m_art.emplace_back(t_song.m_path, offset, size, mime_type, pic_type);
+                    t_song.m_art.back().m_hash = hash;
+                }
+
+                else {
+
+                    // extracting picture data, or sharing it with an identical picture
+                    auto pic_data = ArtStore::instance().intern(hash, picture);
+
+                    ID3::Picture art = ID3::Picture(pic_data, mime_type, pic_type);
+
+                    art.m_size = size;
+                    art.m_hash = hash;
+
+                    if (in_file) {
+                        art.m_path = t_song.m_path;
+                        art.m_offset = offset;
+                    }
+
+                    t_song.m_art.push_back(std::move(art));
+                }
 
-                t_song.m_release = content;
             }
 
             else {
+                // TODO deal with error
 
-                log::info("Found a TDRC frame, but release year has already been set. Skipping...");
+                log::error(std::string(container.text));
             }
+        }
 
-        } else if (t_frame_header.id == "TLEN") {
+        // MIME Type is a link
+        // Links are ignored because this code will not run on a network capable device,
+        // so there is no way it will ever make use of that information.
+        else {
 
-            auto data = *prepareFrameData(t_handler, t_frame_header, t_position);
+            log::warn("Found APIC frames containing links, those are ignored as they are of no use for the purpose of this device.");
+
+            log::info(fmt::format("Skipping {} bytes...", data.size()));
+        }
+    }
 
-            auto len = convert_bytes(data.data(), static_cast<std::uint32_t>(data.size()), false);
 
-            log::info(fmt::format("Found a TLEN frame, setting track length to: {}", len));
+    /**
+     * Handles a PCNT frame, the play counter.
+     */
+    void parsePlayCounter(const FrameData& t_frame, [[maybe_unused]] std::span<const char> t_tag, Song& t_song, [[maybe_unused]] const ParseOptions& t_options, [[maybe_unused]] ParseContext& t_context) noexcept {
 
-            t_song.m_duration = len;
+        auto data = t_frame.data();
 
-        } else if (t_frame_header.id == "TDLY") {
+        std::uint64_t play_counter = convert_bytes(data.data(), static_cast<std::uint32_t>(data.size()), false);
 
-            auto data = *prepareFrameData(t_handler, t_frame_header, t_position);
+        log::info(fmt::format("Found an PCNT frame, setting play counter to: {}", play_counter));
+
+        t_song.m_play_counter = play_counter;
+    }
 
-            auto delay = convert_bytes(data.data(), static_cast<std::uint32_t>(data.size()), false);
 
-            log::info(fmt::format("Found a TDLY frame, setting delay to: {}ms", delay));
+    // the number of slots of the frame handler table, a power of two that leaves room for registered handlers
+    constexpr std::size_t HANDLER_SLOTS = 64;
 
-            t_song.m_delay = delay;
 
-        } else if (t_frame_header.id == "TCON") {
+    /**
+     * A slot of the frame handler table, slots with an id of 0 are empty.
+     */
+    struct HandlerSlot {
+        std::uint32_t id;
+        FrameHandler handler;
+    };
 
-            // custom genres have precedence over content type but if
-            // there is no custom genre set, this frame will be used for the genre instead
-            // TODO this is different for older tag versions
-            if (t_song.m_genre == "Unknown Genre") {
+    using HandlerTable = std::array<HandlerSlot, HANDLER_SLOTS>;
+
+
+    /**
+     * @return the slot in which probing for the frame ID starts (Fibonacci hashing)
+     */
+    constexpr std::size_t slot(std::uint32_t t_id) noexcept {
+        return (t_id * 0x9e3779b1u) >> 26;
+    }
 
-                auto data = *prepareFrameData(t_handler, t_frame_header, t_position);
 
-                // TODO deal with possibility of having an error
-                std::string content = decode_text(data.at(LOCATION_TEXT_ENCODING), data, LOCATION_TEXT);
+    /**
+     * Inserts a handler into the table with linear probing, replacing the handler of the frame ID if there is one.
+     *
+     * @return false if the table is full
+     */
+    constexpr bool insert(HandlerTable& t_table, std::uint32_t t_id, FrameHandler t_handler) noexcept {
 
-                log::info(fmt::format("Found a TCON frame, setting genre to: {}", content));
+        for (std::size_t probe = 0, index = slot(t_id); probe < HANDLER_SLOTS; ++probe, index = (index + 1) % HANDLER_SLOTS) {
 
-                // TODO not sure if this is always fine (as there can also be numbers apparently)
-                //      so maybe this is not the correct way to "parse" the data, but I'll have to
-                //      check with more files.
-                t_song.m_genre = content;
+            if (t_table[index].id == t_id || t_table[index].id == 0) {
+                t_table[index] = {t_id, t_handler};
+                return true;
             }
+        }
 
-        } else if (t_frame_header.id == "TRCK") {
+        return false;
+    }
 
-            auto data = *prepareFrameData(t_handler, t_frame_header, t_position);
 
-            std::string track_number;
+    /**
+     * @return the table of the handlers of the supported frames
+     */
+    consteval HandlerTable buildHandlers() noexcept {
 
-            // TRCK frame can contain a / with the total amount of tracks
-            // after the track number. I don't care about that
-            for (std::int_fast8_t c : data) {
-                if (c == '/')
-                    break;
+        HandlerTable table{};
+
+        insert(table, fourCC("TIT2"), parseTitle);
+        insert(table, fourCC("TALB"), parseAlbum);
+        insert(table, fourCC("TPE1"), parseArtist);
+        insert(table, fourCC("TDRL"), parseReleaseTime);
+        insert(table, fourCC("TDRC"), parseRecordingTime);
+        insert(table, fourCC("TLEN"), parseLength);
+        insert(table, fourCC("TDLY"), parsePlaylistDelay);
+        insert(table, fourCC("TCON"), parseContentType);
+        insert(table, fourCC("TRCK"), parseTrackNumber);
+        insert(table, fourCC("APIC"), parsePicture);
+        insert(table, fourCC("PCNT"), parsePlayCounter);
+
+        return table;
+    }
 
-                else
-                    track_number += c;
-            }
 
-            log::info(fmt::format("Found a TRCK frame, setting track number to: {}", track_number));
+    // built at compile time, so that looking up a frame is a hash and a few compares
+    constinit HandlerTable handlers = buildHandlers();
+}
 
-            t_song.m_track_number = track_number;
 
+bool ID3::registerFrameHandler(std::uint32_t t_id, FrameHandler t_handler) noexcept {
 
-        } else if (t_frame_header.id == "APIC") {
+    if (t_id == 0 || !insert(handlers, t_id, t_handler)) {
+        log::error(fmt::format("Could not register a handler for frame {:#010x}", t_id));
+        return false;
+    }
 
-            log::info("Found an APIC frame");
+    return true;
+}
 
-            auto data = *prepareFrameData(t_handler, t_frame_header, t_position);
 
-            std::uint32_t iterator = 0;
+FrameHandler ID3::frameHandler(std::uint32_t t_id) noexcept {
 
-            // byte indicating text encoding
-            std::int8_t text_encoding = data.at(iterator++);
+    for (std::size_t probe = 0, index = slot(t_id); probe < HANDLER_SLOTS; ++probe, index = (index + 1) % HANDLER_SLOTS) {
 
-            std::string mime_type;
+        if (handlers[index].id == t_id)
+            return handlers[index].handler;
 
-            char c = data.at(iterator);
+        if (handlers[index].id == 0)
+            break;
+    }
 
-            while (c != 0) {
-                mime_type += c;
-                c = data.at(++iterator);
-            }
+    return nullptr;
+}
 
-            log::debug(fmt::format("Found picture with MIME type: {}", mime_type));
 
-            // MIME Type is not a link, continuing as planned
-            if (mime_type != "-->") {
+FrameData ID3::prepareFrameData(std::span<const char> t_tag, FrameHeader& t_frame_header, std::uint32_t& t_position, ParseContext& t_context) noexcept {
 
-                auto pic_type = static_cast<ID3::PictureType>(data.at(iterator++));
+    log::debug(fmt::format("Reading {} bytes of Frame with ID {}", t_frame_header.size, t_frame_header.id));
 
-                auto container = decode_text_retain_position(text_encoding, data, iterator);
+    auto data = readFrame(t_tag, t_position, t_frame_header.size);
 
-                if (!container.error) {
+    bool unsynchronised = t_frame_header.format_flags & (1 << 1);
+    bool compressed = t_frame_header.format_flags & (1 << 3);
 
-                    iterator = container.position;
+    // the group identifier and the encryption method are one byte each, the data length indicator is a syncsafe integer
+    std::size_t added = (t_frame_header.format_flags & (1 << 6) ? 1 : 0) + (t_frame_header.format_flags & (1 << 2) ? 1 : 0);
+    std::uint32_t length = 0;
 
-                    auto pic_data = std::make_shared<std::vector<char>>();
-                    pic_data->reserve(data.size() - iterator);
+    if (t_frame_header.format_flags & (1 << 0) && data.size() >= added + SIZE_OF_SIZE) {
 
+        length = getSize(data.data() + added, true);
+        added += SIZE_OF_SIZE;
+    }
 
-                    // extracting picture data
-                    while (iterator < data.size()) {
-                        pic_data->push_back(data.at(iterator++));
-                    }
+    if (added >= data.size()) {
+        log::error(fmt::format("Frame {} only holds the bytes added by its flags", t_frame_header.id));
+        return FrameData(data, t_context.scratch());
+    }
 
+    FrameData frame_content(data.subspan(added), t_context.scratch());
 
-                    ID3::Picture art = ID3::Picture(pic_data, mime_type, pic_type);
+    if (t_frame_header.format_flags & (1 << 2)) {
+        log::debug(fmt::format("{} is an encrypted frame...", t_frame_header.id));
+        // TODO frame is encrypted
+        // TODO see ENCR frame
+        // TODO decrypt after sync
+        return frame_content;
+    }
 
-                    // TODO not sure if a copy is the best idea here, but I'll leave
-                    //      it like this for now
-                    t_song.m_art.push_back(art);
+    if (compressed) {
 
-                }
+        log::debug(fmt::format("{} is a compressed frame with {} bytes of data...", t_frame_header.id, length));
 
-                else {
-                    // TODO deal with error
+        // the size of the data is unknown without the data length indicator
+        if (length == 0) {
+            log::error(fmt::format("Compressed frame {} has no data length indicator, skipping frame...", t_frame_header.id));
+            return FrameData({}, t_context.scratch());
+        }
 
-                    log::error(container.text);
-                }
-            }
+        auto input = frame_content.view();
+        auto& buffer = frame_content.buffer();
 
-            // MIME Type is a link
-            // Links are ignored because this code will not run on a network capable device,
-            // so there is no way it will ever make use of that information.
-            else {
+        // the synchronized data is stored behind the space for the decompressed data
+        buffer.resize(length + (unsynchronised ? input.size() : 0));
 
-                log::warn("Found APIC frames containing links, those are ignored as they are of no use for the purpose of this device.");
+        if (unsynchronised)
+            input = std::span<const char>(buffer.data() + length, synchronize(input, buffer.data() + length));
 
-                log::info(fmt::format("Skipping {} bytes...", t_frame_header.size));
-            }
+        uLongf size = length;
+
+        int result = uncompress(reinterpret_cast<Bytef*>(buffer.data()), &size, reinterpret_cast<const Bytef*>(input.data()), input.size());
+
+        // the compressed data is dropped, there is nothing to parse in it (Z_BUF_ERROR means that the
+        // data length indicator is too small, the data would only be decompressed partially)
+        if (result != Z_OK || size == 0) {
+
+            log::error(fmt::format("Could not decompress frame {}: {}, skipping frame...", t_frame_header.id, zError(result)));
+
+            return FrameData({}, t_context.scratch());
+        }
+
+        buffer.resize(size);
+    }
 
-        } else if (t_frame_header.id == "PCNT") {
+    // synchronizing frame data
+    else if (unsynchronised) {
 
-            auto data = *prepareFrameData(t_handler, t_frame_header, t_position);
+        auto& buffer = frame_content.buffer();
 
-            std::uint64_t play_counter = convert_bytes(data.data(), static_cast<std::uint32_t>(data.size()), false);
+        buffer.resize(frame_content.view().size());
+        buffer.resize(synchronize(frame_content.view(), buffer.data()));
+    }
 
-            log::info(fmt::format("Found an PCNT frame, setting play counter to: {}", play_counter));
+    return frame_content;
+}
 
 
-            t_song.m_play_counter = play_counter;
+bool ID3::parseFrame(std::span<const char> t_tag, FrameHeader& t_frame_header, std::uint32_t& t_position, Song& t_song, const ParseOptions& t_options, ParseContext& t_context) noexcept {
 
-        } else {
+    // this frame is a padding frame, skipping
+    if (t_frame_header.id[0] == 0x00) {
+
+        log::debug("Encountered a frame id starting with 0x00 which is probably due to padding, skipping to the end of the tag...");
+
+        // TODO this does not work, there is no such things as 'padding frames'
+        // TODO I have to skip to the end of the tag
+        t_position += t_frame_header.size;
+
+        return false;
+    }
+
+    // there is nothing to parse in an empty frame
+    else if (t_frame_header.size == 0) {
+
+        log::warn(fmt::format("Frame {} is empty, skipping frame...", t_frame_header.id));
+
+        return true;
+    }
+
+    else {
+
+        auto handler = frameHandler(fourCC(t_frame_header.id));
+
+        if (handler == nullptr) {
             log::warn(fmt::format("FrameID: {} is not supported yet, skipping frame...", t_frame_header.id));
             t_position += t_frame_header.size;
         }
 
+        else {
+
+            // the data is always prepared, so that the position is past the frame even if the handler ignores it
+            auto frame = prepareFrameData(t_tag, t_frame_header, t_position, t_context);
+
+            // the data of frames that could not be prepared is dropped
+            if (!frame.data().empty())
+                handler(frame, t_tag, t_song, t_options, t_context);
+        }
+
         // TODO TFLT (audio type, default is MPEG)
         // TODO MLLT (MPEG location lookup table (do I need this) (4.6), mentions player counter (4.16))
         // TODO ENCR and AENC frames?
@@ -365,11 +604,9 @@ bool ID3::parseFrame(Filehandler& t_handler, FrameHeader& t_frame_header, std::u
 }
 
 
-FrameHeader ID3::readFrameHeader(Filehandler& t_handler, std::uint32_t& t_position, const bool t_syncsafe) noexcept {
-
-    char buffer[SIZE_OF_HEADER]{};
+FrameHeader ID3::readFrameHeader(std::span<const char> t_tag, std::uint32_t& t_position, const bool t_syncsafe) noexcept {
 
-    t_handler.readBytes(buffer, t_position, static_cast<std::uint32_t>(SIZE_OF_HEADER));
+    const char* buffer = t_tag.data() + t_position;
 
     t_position += SIZE_OF_HEADER;
 
@@ -378,9 +615,7 @@ FrameHeader ID3::readFrameHeader(Filehandler& t_handler, std::uint32_t& t_positi
     frame_id = {buffer[0], buffer[1], buffer[2], buffer[3]};
 
 
-    const char size_bytes[4] = {buffer[4], buffer[5], buffer[6], buffer[7]};
-
-    auto size = static_cast<std::uint32_t>(convert_bytes(size_bytes, SIZE_OF_SIZE, t_syncsafe));
+    auto size = static_cast<std::uint32_t>(convert_bytes(buffer + 4, SIZE_OF_SIZE, t_syncsafe));
 
     auto status_flags = static_cast<byte>(buffer[8]);
     auto format_flags = static_cast<byte>(buffer[9]);
@@ -390,11 +625,9 @@ FrameHeader ID3::readFrameHeader(Filehandler& t_handler, std::uint32_t& t_positi
 }
 
 
-std::unique_ptr<std::vector<char>> ID3::readFrame(Filehandler& t_handler, std::uint32_t& t_position, const std::uint32_t t_bytes) noexcept {
-
-    auto frame_content = std::make_unique<std::vector<char>>(t_bytes);
+std::span<const char> ID3::readFrame(std::span<const char> t_tag, std::uint32_t& t_position, const std::uint32_t t_bytes) noexcept {
 
-    t_handler.readBytes(frame_content->data(), t_position, t_bytes);
+    auto frame_content = t_tag.subspan(t_position, t_bytes);
 
     // taking frame data in account when updating position
     t_position += t_bytes;
@@ -403,123 +636,161 @@ std::unique_ptr<std::vector<char>> ID3::readFrame(Filehandler& t_handler, std::u
 }
 
 
-void ID3::readID3(Song& t_song) noexcept {
+void ID3::parseTag(std::span<const char> t_tag, const std::uint8_t t_version, const std::uint8_t t_flags, Song& t_song, const ParseOptions& t_options) noexcept {
 
-    Filehandler handler = Filehandler(t_song.m_path);
+    ParseContext context;
 
-    if (detectID3(handler)) {
+    parseTag(t_tag, t_version, t_flags, t_song, context, t_options);
+}
 
-        // retrieve ID3 version
-        auto version = getVersion(handler);
 
-        log::info(fmt::format("ID3v2.{:d}", version));
+void ID3::parseTag(std::span<const char> t_tag, const std::uint8_t t_version, const std::uint8_t t_flags, Song& t_song, ParseContext& t_context, const ParseOptions& t_options) noexcept {
 
-        // TODO proceed with extracting metadata
-        auto flags = getFlags(handler);
+    // the whole ID3v2.3 tag is unsynchronised, including the frame headers, so it is synchronized
+    // before anything is read, an ID3v2.4 tag is synchronized frame by frame instead
+    if (t_flags & (1 << 7) && t_version == 3) {
 
-        // NOTE size is without 10 bytes of header
-        auto size = getSize(handler, false);
+        log::debug("This tag is unsynchronised, synchronizing it...");
 
-        log::info(fmt::format("ID3 Tag has {} bytes", size));
+        std::pmr::vector<char> synchronized(t_tag.size(), t_context.arena());
 
-        std::uint32_t extended_size = 0;
+        synchronized.resize(synchronize(t_tag, synchronized.data()));
 
-        // Not supported ID3 version, skipping the tag
-        // TODO Implement ID3v2.2 and below
-        if (version != 4 && version != 3) {
-            log::error(fmt::format("This software does not support ID3 version ID3v2.{:d}", version));
+        ParseOptions options = t_options;
+        options.in_file = false;
 
-            // TODO set filepointer to after tag?
-            // TODO if I'd do that, I'd have to know whether it contains extended headers though (for complete size)
-        }
+        parseTag(synchronized, t_version, static_cast<std::uint8_t>(t_flags & ~(1 << 7)), t_song, t_context, options);
 
-        else {
+        return;
+    }
 
-            // TODO synchronize
-            if (flags & (1 << 7)) {
-                log::debug("This tag is unsynchronised...");
-            }
+    std::uint32_t position = 0;
 
-            // Extended header is present, skipping it...
-            if (flags & (1 << 6)) {
-                extended_size = getSize(handler, true);
+    // Extended header is present, skipping it...
+    if (t_flags & (1 << 6) && t_tag.size() >= SIZE_OF_SIZE) {
 
-                log::debug("This tag has an extended header. Skipping it for now...");
+        auto extended_size = getSize(t_tag.data(), t_version == 4);
 
-            }
+        // the size of an ID3v2.3 extended header does not include the 4 size bytes
+        position = t_version == 4 ? extended_size : extended_size + SIZE_OF_SIZE;
 
-            // TODO footer present (do I care?)
-            // TODO probably need to tell the mp3 decoder to stop 10 bytes before EOF
-            if (flags & (1 << 4)) {
-                log::debug("This tag has a footer. Skipping it for now...");
+        log::debug("This tag has an extended header. Skipping it for now...");
+    }
 
-                // size += 10;
-                // don't do this, just set a footer bit to true or something
-            }
+    log::debug(fmt::format("Starting to read frames at position {}", position));
 
+    while (position + SIZE_OF_HEADER <= t_tag.size()) {
 
-            std::int64_t size_remaining = size + extended_size;
+        log::info(fmt::format("{} bytes remaining...", t_tag.size() - position));
+        log::info(fmt::format("Continuing to read at position: {}", position));
 
-            std::uint32_t position = SIZE_OF_HEADER + extended_size;
+        // I need to keep the original position to set offsets later
+        std::uint32_t original_position = position;
 
-            log::debug(fmt::format("Starting to read frames at position {}", position));
+        auto header = readFrameHeader(t_tag, position, t_version == 4);
 
-            while (size_remaining > 0) {
-                log::info(fmt::format("{} bytes remaining...", size_remaining));
-                log::info(fmt::format("{} > 0", size_remaining));
-                log::info(fmt::format("Continuing to read at position: {}", position));
+        // the frames of an unsynchronised ID3v2.4 tag are all unsynchronised, even if their flag is not set
+        FrameHeader frame_header{header.id, header.size, header.status_flags,
+                                 static_cast<byte>(t_flags & (1 << 7) ? header.format_flags | (1 << 1) : header.format_flags)};
 
-                // I need to keep the original position to do some calculations and set offsets later
-                std::uint32_t original_position_file = position;
+        if (frame_header.size > t_tag.size() - position) {
+            log::error(fmt::format("Frame {} has {} bytes, but only {} bytes are left in the tag",
+                                   frame_header.id, frame_header.size, t_tag.size() - position));
+            break;
+        }
 
+        // There are no frames left, the rest is padding
+        if (!parseFrame(t_tag, frame_header, position, t_song, t_options, t_context)) {
 
-                auto frame_header = readFrameHeader(handler, position, version == 4);
-                auto result = parseFrame(handler, frame_header, position, t_song);
+            log::debug("Read a frame_id starting with 0x00, the rest of the tag is padding");
+            break;
+        }
 
-                // There are no frames left, the rest is padding
-                if (!result) {
+        if (fourCC(frame_header.id) == fourCC("PCNT") && t_options.in_file) {
 
-                    log::debug("Result has no value, so read a frame_id starting with 0x00");
+            // setting position of start of play counter frame (relative to the start of the file)
+            t_song.m_counter_offset = SIZE_OF_HEADER + original_position;
+        }
+    }
+}
 
-                    // this is alright because size_remaining > 0
-                    position = static_cast<std::uint32_t>(size_remaining);
-                    size_remaining = 0;
-                }
 
-                else {
+void ID3::readID3(Song& t_song, const ParseOptions& t_options) noexcept {
 
-                    if (frame_header.id == "PCNT") {
+    // mapping the file if possible so that the tag can be parsed in place
+    Filehandler handler = Filehandler(t_song.m_path, true);
 
-                        // setting position of start of play counter frame
-                        t_song.m_counter_offset = original_position_file;
+    std::array<char, SIZE_OF_HEADER> header{};
 
-                    }
+    handler.readBytes(header.data(), LOCATION_START, SIZE_OF_HEADER);
 
-                    size_remaining -= (position - original_position_file);
+    if (detectID3(header.data())) {
 
-                    log::info(fmt::format("Size remaining: {}", size_remaining));
+        // retrieve ID3 version
+        auto version = getVersion(header.data());
 
+        log::info(fmt::format("ID3v2.{:d}", version));
 
-                    // frame_id has been not been set properly,
-                    // still parsing the frame as I can't skip it
-                    // without knowing it's size
-                    // TODO is this ever empty?
-                    if (frame_header.id.empty()) {
-                        log::error("frame_id has not been set properly");
-                    }
+        auto flags = getFlags(header.data());
 
+        // NOTE size is without 10 bytes of header
+        auto size = getSize(header.data() + LOCATION_SIZE, true);
 
-                }
+        log::info(fmt::format("ID3 Tag has {} bytes", size));
+
+        // Not supported ID3 version, skipping the tag
+        // TODO Implement ID3v2.2 and below
+        if (version != 4 && version != 3) {
+            log::error(fmt::format("This software does not support ID3 version ID3v2.{:d}", version));
+        }
+
+        else {
+
+            // the tag buffer and the strings are allocated from the arena of the context
+            ParseContext context;
+
+            std::pmr::vector<char> buffer(context.arena());
+            std::span<const char> tag;
+
+            // the tag can be addressed directly if the file is memory mapped
+            if (handler.isMapped()) {
+
+                auto file = handler.bytes();
+
+                if (file.size() > SIZE_OF_HEADER)
+                    tag = file.subspan(SIZE_OF_HEADER, std::min<std::size_t>(size, file.size() - SIZE_OF_HEADER));
+            }
+
+            // reading the whole tag with a single read otherwise, all frames are parsed from memory
+            else {
+
+                buffer.resize(size);
+
+                handler.readBytes(buffer.data(), SIZE_OF_HEADER, size);
+
+                tag = buffer;
             }
 
+            parseTag(tag, version, flags, t_song, context, t_options);
         }
 
+        // the audio data starts after the tag (and the footer if there is one)
+        t_song.m_audio_start = SIZE_OF_HEADER + size;
 
+        if (flags & (1 << 4)) {
+            log::debug("This tag has a footer, skipping it...");
+
+            t_song.m_audio_start += SIZE_OF_HEADER;
+        }
     }
 
     else {
         log::debug(fmt::format("No ID3 Tag has been prepended to file: {}", t_song.m_path));
     }
+
+    // most files don't have a TLEN frame, the duration can be calculated from the first frame instead
+    if (t_song.m_duration == 0 && handler.isMapped() && handler.bytes().size() > t_song.m_audio_start)
+        t_song.m_duration = MP3::estimateDuration(handler.bytes().subspan(t_song.m_audio_start));
 }
 
 
@@ -0,0 +1,301 @@
+#include <kernels.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_X86
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define KERNELS_NEON
+#endif
+
+
+namespace {
+
+    using MP3::DSP::sample;
+    using MP3::DSP::COEFFICIENT_BITS;
+
+
+    /**
+     * @return the position of the first value of the 32 values of the U vector for the
+     *         window block t_block (see MP3::DSP::synthesize)
+     */
+    inline std::size_t windowPosition(std::size_t t_offset, std::size_t t_block) noexcept {
+        return (t_offset + 128 * (t_block / 2) + (t_block % 2 == 1 ? 96 : 0)) & 1023;
+    }
+
+
+    void transformScalar(const std::int32_t* t_matrix, const sample* t_input, std::size_t t_rows, std::size_t t_columns, sample* t_output) noexcept {
+
+        for (std::size_t row = 0; row < t_rows; ++row, t_matrix += t_columns) {
+
+            std::int64_t sum = 0;
+
+            for (std::size_t k = 0; k < t_columns; ++k)
+                sum += std::int64_t{t_input[k]} * t_matrix[k];
+
+            t_output[row] = static_cast<sample>(sum >> COEFFICIENT_BITS);
+        }
+    }
+
+
+    void windowScalar(const sample* t_v, std::size_t t_offset, const std::int32_t* t_window, sample* t_output) noexcept {
+
+        std::int64_t sums[32] = {};
+
+        // 16 blocks of 32 values, alternating between the first and the last 32 values of a V vector
+        for (std::size_t block = 0; block < 16; ++block) {
+
+            const sample* v = t_v + windowPosition(t_offset, block);
+            const std::int32_t* window = t_window + 32 * block;
+
+            for (std::size_t j = 0; j < 32; ++j)
+                sums[j] += std::int64_t{v[j]} * window[j];
+        }
+
+        for (std::size_t j = 0; j < 32; ++j)
+            t_output[j] = static_cast<sample>(sums[j] >> COEFFICIENT_BITS);
+    }
+
+
+#ifdef KERNELS_X86
+
+    /**
+     * Signed 32 x 32 -> 64 bit multiplication of the even lanes, SSE2 only has an unsigned one.
+     * The product of the unsigned values is corrected by subtracting the other factor shifted by
+     * 32 bits for every negative factor.
+     */
+    __attribute__((target("sse2")))
+    inline __m128i multiplySSE2(__m128i t_a, __m128i t_b) noexcept {
+
+        __m128i product = _mm_mul_epu32(t_a, t_b);
+
+        __m128i correction = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(t_a, 31), t_b),
+                                           _mm_and_si128(_mm_srai_epi32(t_b, 31), t_a));
+
+        return _mm_sub_epi64(product, _mm_slli_epi64(correction, 32));
+    }
+
+
+    /**
+     * Adds the products of the four lanes of t_a and t_b to the two 64 bit lanes of t_even (lanes 0 and 2) and t_odd (lanes 1 and 3).
+     */
+    __attribute__((target("sse2")))
+    inline void accumulateSSE2(__m128i t_a, __m128i t_b, __m128i& t_even, __m128i& t_odd) noexcept {
+        t_even = _mm_add_epi64(t_even, multiplySSE2(t_a, t_b));
+        t_odd = _mm_add_epi64(t_odd, multiplySSE2(_mm_srli_epi64(t_a, 32), _mm_srli_epi64(t_b, 32)));
+    }
+
+
+    __attribute__((target("sse2")))
+    void transformSSE2(const std::int32_t* t_matrix, const sample* t_input, std::size_t t_rows, std::size_t t_columns, sample* t_output) noexcept {
+
+        std::size_t vectorized = t_columns & ~std::size_t{3};
+
+        for (std::size_t row = 0; row < t_rows; ++row, t_matrix += t_columns) {
+
+            __m128i even = _mm_setzero_si128();
+            __m128i odd = _mm_setzero_si128();
+
+            for (std::size_t k = 0; k < vectorized; k += 4)
+                accumulateSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t_input + k)),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_matrix + k)), even, odd);
+
+            alignas(16) std::int64_t lanes[2];
+
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(even, odd));
+
+            std::int64_t sum = lanes[0] + lanes[1];
+
+            for (std::size_t k = vectorized; k < t_columns; ++k)
+                sum += std::int64_t{t_input[k]} * t_matrix[k];
+
+            t_output[row] = static_cast<sample>(sum >> COEFFICIENT_BITS);
+        }
+    }
+
+
+    __attribute__((target("sse2")))
+    void windowSSE2(const sample* t_v, std::size_t t_offset, const std::int32_t* t_window, sample* t_output) noexcept {
+
+        for (std::size_t j = 0; j < 32; j += 4) {
+
+            __m128i even = _mm_setzero_si128();
+            __m128i odd = _mm_setzero_si128();
+
+            for (std::size_t block = 0; block < 16; ++block)
+                accumulateSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t_v + windowPosition(t_offset, block) + j)),
+                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_window + 32 * block + j)), even, odd);
+
+            alignas(16) std::int64_t sums[2][2];
+
+            _mm_store_si128(reinterpret_cast<__m128i*>(sums[0]), even);
+            _mm_store_si128(reinterpret_cast<__m128i*>(sums[1]), odd);
+
+            t_output[j] = static_cast<sample>(sums[0][0] >> COEFFICIENT_BITS);
+            t_output[j + 1] = static_cast<sample>(sums[1][0] >> COEFFICIENT_BITS);
+            t_output[j + 2] = static_cast<sample>(sums[0][1] >> COEFFICIENT_BITS);
+            t_output[j + 3] = static_cast<sample>(sums[1][1] >> COEFFICIENT_BITS);
+        }
+    }
+
+
+    /**
+     * Adds the products of the eight lanes of t_a and t_b to the four 64 bit lanes of t_even and t_odd.
+     */
+    __attribute__((target("avx2")))
+    inline void accumulateAVX2(__m256i t_a, __m256i t_b, __m256i& t_even, __m256i& t_odd) noexcept {
+        t_even = _mm256_add_epi64(t_even, _mm256_mul_epi32(t_a, t_b));
+        t_odd = _mm256_add_epi64(t_odd, _mm256_mul_epi32(_mm256_srli_epi64(t_a, 32), _mm256_srli_epi64(t_b, 32)));
+    }
+
+
+    __attribute__((target("avx2")))
+    void transformAVX2(const std::int32_t* t_matrix, const sample* t_input, std::size_t t_rows, std::size_t t_columns, sample* t_output) noexcept {
+
+        std::size_t vectorized = t_columns & ~std::size_t{7};
+
+        for (std::size_t row = 0; row < t_rows; ++row, t_matrix += t_columns) {
+
+            __m256i even = _mm256_setzero_si256();
+            __m256i odd = _mm256_setzero_si256();
+
+            for (std::size_t k = 0; k < vectorized; k += 8)
+                accumulateAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_input + k)),
+                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_matrix + k)), even, odd);
+
+            alignas(32) std::int64_t lanes[4];
+
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(even, odd));
+
+            std::int64_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+            for (std::size_t k = vectorized; k < t_columns; ++k)
+                sum += std::int64_t{t_input[k]} * t_matrix[k];
+
+            t_output[row] = static_cast<sample>(sum >> COEFFICIENT_BITS);
+        }
+    }
+
+
+    __attribute__((target("avx2")))
+    void windowAVX2(const sample* t_v, std::size_t t_offset, const std::int32_t* t_window, sample* t_output) noexcept {
+
+        for (std::size_t j = 0; j < 32; j += 8) {
+
+            __m256i even = _mm256_setzero_si256();
+            __m256i odd = _mm256_setzero_si256();
+
+            for (std::size_t block = 0; block < 16; ++block)
+                accumulateAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_v + windowPosition(t_offset, block) + j)),
+                               _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t_window + 32 * block + j)), even, odd);
+
+            alignas(32) std::int64_t sums[2][4];
+
+            _mm256_store_si256(reinterpret_cast<__m256i*>(sums[0]), even);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(sums[1]), odd);
+
+            for (std::size_t i = 0; i < 4; ++i) {
+                t_output[j + 2 * i] = static_cast<sample>(sums[0][i] >> COEFFICIENT_BITS);
+                t_output[j + 2 * i + 1] = static_cast<sample>(sums[1][i] >> COEFFICIENT_BITS);
+            }
+        }
+    }
+
+#endif
+
+
+#ifdef KERNELS_NEON
+
+    void transformNEON(const std::int32_t* t_matrix, const sample* t_input, std::size_t t_rows, std::size_t t_columns, sample* t_output) noexcept {
+
+        std::size_t vectorized = t_columns & ~std::size_t{3};
+
+        for (std::size_t row = 0; row < t_rows; ++row, t_matrix += t_columns) {
+
+            int64x2_t low = vdupq_n_s64(0);
+            int64x2_t high = vdupq_n_s64(0);
+
+            for (std::size_t k = 0; k < vectorized; k += 4) {
+
+                int32x4_t input = vld1q_s32(t_input + k);
+                int32x4_t coefficients = vld1q_s32(t_matrix + k);
+
+                low = vmlal_s32(low, vget_low_s32(input), vget_low_s32(coefficients));
+                high = vmlal_s32(high, vget_high_s32(input), vget_high_s32(coefficients));
+            }
+
+            int64x2_t lanes = vaddq_s64(low, high);
+
+            std::int64_t sum = vgetq_lane_s64(lanes, 0) + vgetq_lane_s64(lanes, 1);
+
+            for (std::size_t k = vectorized; k < t_columns; ++k)
+                sum += std::int64_t{t_input[k]} * t_matrix[k];
+
+            t_output[row] = static_cast<sample>(sum >> COEFFICIENT_BITS);
+        }
+    }
+
+
+    void windowNEON(const sample* t_v, std::size_t t_offset, const std::int32_t* t_window, sample* t_output) noexcept {
+
+        for (std::size_t j = 0; j < 32; j += 4) {
+
+            int64x2_t low = vdupq_n_s64(0);
+            int64x2_t high = vdupq_n_s64(0);
+
+            for (std::size_t block = 0; block < 16; ++block) {
+
+                int32x4_t v = vld1q_s32(t_v + windowPosition(t_offset, block) + j);
+                int32x4_t coefficients = vld1q_s32(t_window + 32 * block + j);
+
+                low = vmlal_s32(low, vget_low_s32(v), vget_low_s32(coefficients));
+                high = vmlal_s32(high, vget_high_s32(v), vget_high_s32(coefficients));
+            }
+
+            vst1_s32(t_output + j, vshrn_n_s64(low, COEFFICIENT_BITS));
+            vst1_s32(t_output + j + 2, vshrn_n_s64(high, COEFFICIENT_BITS));
+        }
+    }
+
+#endif
+}
+
+
+const MP3::DSP::Kernels* MP3::DSP::kernels(Kernel t_kernel) noexcept {
+
+    static constexpr Kernels SCALAR_KERNELS = {transformScalar, windowScalar};
+
+    switch (t_kernel) {
+
+        case SCALAR:
+            return &SCALAR_KERNELS;
+
+#ifdef KERNELS_X86
+
+        case SSE2: {
+            static constexpr Kernels SSE2_KERNELS = {transformSSE2, windowSSE2};
+            return __builtin_cpu_supports("sse2") ? &SSE2_KERNELS : nullptr;
+        }
+
+        case AVX2: {
+            static constexpr Kernels AVX2_KERNELS = {transformAVX2, windowAVX2};
+            return __builtin_cpu_supports("avx2") ? &AVX2_KERNELS : nullptr;
+        }
+
+#endif
+
+#ifdef KERNELS_NEON
+
+        case NEON: {
+            static constexpr Kernels NEON_KERNELS = {transformNEON, windowNEON};
+            return &NEON_KERNELS;
+        }
+
+#endif
+
+        default:
+            return nullptr;
+    }
+}
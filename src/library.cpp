@@ -0,0 +1,106 @@
+#include <library.hpp>
+#include <algorithm>
+#include <cctype>
+#include <id3.hpp>
+#include <threadpool.hpp>
+
+
+bool Library::isMP3(const std::filesystem::path& t_path) noexcept {
+
+    auto extension = t_path.extension().string();
+
+    return extension.size() == 4 && extension[0] == '.'
+           && std::tolower(static_cast<unsigned char>(extension[1])) == 'm'
+           && std::tolower(static_cast<unsigned char>(extension[2])) == 'p'
+           && extension[3] == '3';
+}
+
+
+std::vector<std::string> Library::findFiles(const std::string& t_root) noexcept {
+
+    std::vector<std::string> paths;
+
+    std::error_code error;
+
+    std::filesystem::recursive_directory_iterator iterator(t_root, std::filesystem::directory_options::skip_permission_denied, error);
+
+    if (error) {
+        log::error(fmt::format("Could not open directory {}: {}", t_root, error.message()));
+        return paths;
+    }
+
+    for (const std::filesystem::recursive_directory_iterator end; iterator != end; iterator.increment(error)) {
+
+        if (error) {
+            log::warn(fmt::format("Error while scanning {}: {}", t_root, error.message()));
+            error.clear();
+            continue;
+        }
+
+        if (iterator->is_regular_file(error) && isMP3(iterator->path()))
+            paths.push_back(iterator->path().string());
+    }
+
+    std::sort(paths.begin(), paths.end());
+
+    log::info(fmt::format("Found {} mp3 files in {}", paths.size(), t_root));
+
+    return paths;
+}
+
+
+std::vector<Song> Library::scan(const std::string& t_root, std::size_t t_threads, MetadataCache* t_cache) {
+
+    auto paths = findFiles(t_root);
+
+    std::vector<Song> songs;
+    songs.reserve(paths.size());
+
+    // songs that are not cached (or have changed) and their stamps
+    std::vector<std::size_t> outdated;
+    std::vector<std::optional<FileStamp>> stamps(paths.size());
+
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+
+        if (t_cache != nullptr && (stamps[i] = MetadataCache::stamp(paths[i]))) {
+
+            if (auto cached = t_cache->lookup(paths[i], *stamps[i])) {
+                songs.push_back(std::move(*cached));
+                continue;
+            }
+        }
+
+        songs.emplace_back(paths[i]);
+        outdated.push_back(i);
+    }
+
+    log::info(fmt::format("{} of {} songs have to be parsed", outdated.size(), songs.size()));
+
+    if (!outdated.empty()) {
+
+        ThreadPool pool(t_threads);
+
+        // every task parses a few files, so that the overhead of
+        // the pool is small compared to the work that is done
+        for (std::size_t start = 0; start < outdated.size(); start += FILES_PER_TASK) {
+
+            auto end = std::min(start + FILES_PER_TASK, outdated.size());
+
+            pool.submit([&songs, &outdated, start, end] {
+                for (auto i = start; i < end; ++i)
+                    ID3::readID3(songs[outdated[i]]);
+            });
+        }
+
+        pool.wait();
+    }
+
+    if (t_cache != nullptr) {
+        for (auto i : outdated) {
+            if (stamps[i])
+                t_cache->store(songs[i], *stamps[i]);
+        }
+    }
+
+    return songs;
+}
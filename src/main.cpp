@@ -12,16 +12,99 @@
 #include <string>
 #include <song.hpp>
 #include <id3.hpp>
+#include <library.hpp>
+#include <watcher.hpp>
+#include <player.hpp>
+#include <playlist.hpp>
+#include <sink.hpp>
+#include <algorithm>
+#include <memory>
 // #include <chrono>
 
 
 int main(int arc, char* agrv[]) {
 
-    if (arc > 1) {
+    // watch mode, keeps the songs in the passed directories up to date until the program is stopped
+    if (arc > 2 && std::string(agrv[1]) == "--watch") {
+
+        std::vector<std::string> roots(agrv + 2, agrv + arc);
+
+        MetadataCache cache(MetadataCache::defaultPath());
+
+        // watching before scanning, so that nothing that changes in between is missed
+        Watcher watcher(roots, &cache);
+
+        std::vector<Song> songs;
+
+        for (const auto& root : roots) {
+            auto found = Library::scan(root, 0, &cache);
+            std::move(found.begin(), found.end(), std::back_inserter(songs));
+        }
+
+        std::sort(songs.begin(), songs.end(), [](const Song& a, const Song& b) { return a.m_path < b.m_path; });
+
+        cache.save();
+
+        std::cout << "Watching " << songs.size() << " songs" << std::endl;
+
+        while (watcher.valid()) {
+
+            if (watcher.poll(songs, -1) > 0) {
+
+                cache.save();
+
+                std::cout << "Library contains " << songs.size() << " songs" << std::endl;
+            }
+        }
+    }
+
+    // decodes a file or a playlist (m3u) into a WAV file, or into a null sink to measure the speed of decoding
+    else if (arc > 2 && std::string(agrv[1]) == "--decode") {
+
+        std::string input = agrv[2];
+        std::vector<Song> songs;
+
+        if (std::filesystem::path(input).extension() == ".m3u")
+            Playlist::readM3U(input.c_str(), songs);
+        else
+            songs.emplace_back(input);
+
+        std::unique_ptr<AudioSink> sink;
+
+        if (arc > 3)
+            sink = std::make_unique<WAVSink>(agrv[3]);
+        else
+            sink = std::make_unique<NullSink>();
+
+        Player player(std::move(songs), *sink);
+
+        player.play();
+
+        if (auto* null = dynamic_cast<NullSink*>(sink.get()))
+            std::cout << "Decoded " << null->frames() << " frames (" << null->duration() << " ms) in " << null->elapsed()
+                      << " ms, real-time factor " << null->realTimeFactor() << std::endl;
+    }
+
+    else if (arc > 1) {
 
         for(int i = 1; i < arc; i++) {
             std::string filename = agrv[i];
 
+            // scanning the whole directory if a directory has been passed
+            if (std::filesystem::is_directory(filename)) {
+
+                MetadataCache cache(MetadataCache::defaultPath());
+
+                auto songs = Library::scan(filename, 0, &cache);
+
+                cache.save();
+
+                for (auto& song : songs)
+                    song.print();
+
+                continue;
+            }
+
             // auto start = std::chrono::high_resolution_clock::now();
 
             Song song(filename);
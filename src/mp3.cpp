@@ -0,0 +1,510 @@
+#include <mp3.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filehandler.hpp>
+#include <log.hpp>
+
+
+namespace {
+
+    // bitrates in kbit/s by MPEG 1 or not, layer and bitrate index
+    constexpr std::uint16_t BITRATES[2][3][15] = {
+        {
+            {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+            {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+            {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}
+        },
+        {
+            {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+            {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+            {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320}
+        }
+    };
+
+
+    // sample rates in Hz by version id and sample rate index
+    constexpr std::uint32_t SAMPLE_RATES[4][3] = {
+        {11025, 12000, 8000},
+        {0, 0, 0},
+        {22050, 24000, 16000},
+        {44100, 48000, 32000}
+    };
+
+
+    /**
+     * Checks whether two frames belong to the same stream, which is the case
+     * if version, layer and sample rate are equal.
+     */
+    inline bool sameStream(const MP3::FrameHeader& t_a, const MP3::FrameHeader& t_b) noexcept {
+
+        return t_a.version == t_b.version && t_a.layer == t_b.layer && t_a.sample_rate == t_b.sample_rate;
+    }
+
+
+    /**
+     * Reads a big endian integer of up to 4 bytes.
+     */
+    inline std::uint32_t readBigEndian(std::span<const char> t_data, std::size_t t_position, std::size_t t_bytes) noexcept {
+
+        std::uint32_t value = 0;
+
+        for (std::size_t i = 0; i < t_bytes; ++i)
+            value = (value << 8) | static_cast<MP3::byte>(t_data[t_position + i]);
+
+        return value;
+    }
+
+
+    /**
+     * Parses the fields of a Xing or Info header and the LAME extension that might follow it.
+     *
+     * @param t_frame    A view of the frame
+     * @param t_position The position of the fields (after the identifier)
+     * @param t_header   The VBR header the fields are stored in
+     */
+    void parseXing(std::span<const char> t_frame, std::size_t t_position, MP3::VBRHeader& t_header) noexcept {
+
+        if (t_position + 4 > t_frame.size())
+            return;
+
+        std::uint32_t flags = readBigEndian(t_frame, t_position, 4);
+
+        t_position += 4;
+
+        auto available = [&](std::size_t bytes) { return t_position + bytes <= t_frame.size(); };
+
+        if ((flags & 0x01) && available(4)) {
+            t_header.frames = readBigEndian(t_frame, t_position, 4);
+            t_position += 4;
+        }
+
+        if ((flags & 0x02) && available(4)) {
+            t_header.bytes = readBigEndian(t_frame, t_position, 4);
+            t_position += 4;
+        }
+
+        if ((flags & 0x04) && available(t_header.toc.size())) {
+            std::memcpy(t_header.toc.data(), t_frame.data() + t_position, t_header.toc.size());
+            t_header.has_toc = true;
+            t_position += t_header.toc.size();
+        }
+
+        // quality indicator
+        if (flags & 0x08)
+            t_position += 4;
+
+        // LAME extension (also written by ffmpeg), the encoder delay and padding are stored as two 12 bit integers
+        if (!available(24))
+            return;
+
+        auto encoder = t_frame.subspan(t_position, 4);
+
+        if (std::memcmp(encoder.data(), "LAME", 4) == 0 || std::memcmp(encoder.data(), "Lavf", 4) == 0 || std::memcmp(encoder.data(), "Lavc", 4) == 0) {
+
+            std::uint32_t value = readBigEndian(t_frame, t_position + 21, 3);
+
+            t_header.delay = static_cast<std::uint16_t>(value >> 12);
+            t_header.padding = static_cast<std::uint16_t>(value & 0x0fff);
+        }
+    }
+
+
+    /**
+     * Parses the fields of a VBRI header, the seek table is converted to the format of the Xing seek table.
+     *
+     * @param t_frame    A view of the frame
+     * @param t_position The position of the fields (after the identifier)
+     * @param t_header   The VBR header the fields are stored in
+     */
+    void parseVBRI(std::span<const char> t_frame, std::size_t t_position, MP3::VBRHeader& t_header) noexcept {
+
+        // version, delay, quality, bytes, frames, entries, scale, entry size, frames per entry
+        if (t_position + 22 > t_frame.size())
+            return;
+
+        t_header.bytes = readBigEndian(t_frame, t_position + 6, 4);
+        t_header.frames = readBigEndian(t_frame, t_position + 10, 4);
+
+        std::uint32_t entries = readBigEndian(t_frame, t_position + 14, 2);
+        std::uint32_t scale = readBigEndian(t_frame, t_position + 16, 2);
+        std::uint32_t entry_size = readBigEndian(t_frame, t_position + 18, 2);
+        std::uint32_t frames_per_entry = readBigEndian(t_frame, t_position + 20, 2);
+
+        t_position += 22;
+
+        if (entries == 0 || entry_size == 0 || entry_size > 4 || frames_per_entry == 0 || t_header.frames == 0 || t_header.bytes == 0
+            || t_position + entries * entry_size > t_frame.size())
+            return;
+
+        // every entry is the number of bytes of the next frames_per_entry frames
+        std::vector<std::uint64_t> offsets(entries + 1, 0);
+
+        for (std::size_t i = 0; i < entries; ++i)
+            offsets[i + 1] = offsets[i] + std::uint64_t{readBigEndian(t_frame, t_position + i * entry_size, entry_size)} * scale;
+
+        for (std::size_t percent = 0; percent < t_header.toc.size(); ++percent) {
+
+            std::uint64_t frame = percent * t_header.frames / 100;
+            std::uint64_t entry = std::min<std::uint64_t>(frame / frames_per_entry, entries - 1);
+            std::uint64_t offset = offsets[entry] + (offsets[entry + 1] - offsets[entry]) * (frame - entry * frames_per_entry) / frames_per_entry;
+
+            t_header.toc[percent] = static_cast<MP3::byte>(std::min<std::uint64_t>(255, offset * 256 / t_header.bytes));
+        }
+
+        t_header.has_toc = true;
+    }
+}
+
+
+std::optional<MP3::FrameHeader> MP3::parseHeader(std::span<const char> t_data) noexcept {
+
+    if (t_data.size() < SIZE_OF_HEADER)
+        return {};
+
+    auto b0 = static_cast<byte>(t_data[0]);
+    auto b1 = static_cast<byte>(t_data[1]);
+    auto b2 = static_cast<byte>(t_data[2]);
+    auto b3 = static_cast<byte>(t_data[3]);
+
+    // 11 bit sync word
+    if (b0 != 0xff || (b1 & 0xe0) != 0xe0)
+        return {};
+
+    byte version = (b1 >> 3) & 0x03;
+    byte layer = (b1 >> 1) & 0x03;
+    byte bitrate_index = b2 >> 4;
+    byte sample_rate_index = (b2 >> 2) & 0x03;
+
+    // reserved values, free format and reserved emphasis
+    if (version == 0x01 || layer == 0x00 || bitrate_index == 0x00 || bitrate_index == 0x0f || sample_rate_index == 0x03 || (b3 & 0x03) == 0x02)
+        return {};
+
+    FrameHeader header{};
+
+    header.version = static_cast<Version>(version);
+    header.layer = static_cast<byte>(4 - layer);
+    header.crc = (b1 & 0x01) == 0;
+    header.bitrate = BITRATES[version == MPEG_1][header.layer - 1][bitrate_index];
+    header.sample_rate = SAMPLE_RATES[version][sample_rate_index];
+    header.padding = (b2 & 0x02) != 0;
+    header.channel_mode = static_cast<ChannelMode>(b3 >> 6);
+    header.mode_extension = (b3 >> 4) & 0x03;
+
+    std::uint32_t bits_per_second = header.bitrate * 1000u;
+
+    if (header.layer == 1) {
+        header.size = static_cast<std::uint16_t>((12 * bits_per_second / header.sample_rate + header.padding) * 4);
+        header.samples = 384;
+    }
+
+    else if (header.layer == 2 || version == MPEG_1) {
+        header.size = static_cast<std::uint16_t>(144 * bits_per_second / header.sample_rate + header.padding);
+        header.samples = 1152;
+    }
+
+    // layer 3 frames of MPEG 2 and 2.5 contain only one granule
+    else {
+        header.size = static_cast<std::uint16_t>(72 * bits_per_second / header.sample_rate + header.padding);
+        header.samples = 576;
+    }
+
+    return header;
+}
+
+
+std::size_t MP3::sideInformationSize(const FrameHeader& t_header) noexcept {
+
+    if (t_header.version == MPEG_1)
+        return t_header.channel_mode == MONO ? 17 : 32;
+
+    return t_header.channel_mode == MONO ? 9 : 17;
+}
+
+
+std::size_t MP3::findFrame(std::span<const char> t_data, std::size_t t_position) noexcept {
+
+    while (t_position + SIZE_OF_HEADER <= t_data.size()) {
+
+        const void* sync = std::memchr(t_data.data() + t_position, 0xff, t_data.size() - t_position);
+
+        if (sync == nullptr)
+            break;
+
+        t_position = static_cast<std::size_t>(static_cast<const char*>(sync) - t_data.data());
+
+        auto header = parseHeader(t_data.subspan(t_position));
+
+        if (header && t_position + header->size <= t_data.size()) {
+
+            std::size_t next = t_position + header->size;
+
+            if (next + SIZE_OF_HEADER > t_data.size())
+                return t_position;
+
+            auto following = parseHeader(t_data.subspan(next));
+
+            if (following && sameStream(*header, *following))
+                return t_position;
+        }
+
+        ++t_position;
+    }
+
+    return t_data.size();
+}
+
+
+std::uint64_t MP3::VBRHeader::samples() const noexcept {
+
+    std::uint64_t samples = std::uint64_t{frames} * samples_per_frame;
+
+    return samples > delay + padding ? samples - delay - padding : 0;
+}
+
+
+std::uint64_t MP3::VBRHeader::duration() const noexcept {
+
+    if (sample_rate == 0)
+        return 0;
+
+    return samples() * 1000 / sample_rate;
+}
+
+
+std::uint64_t MP3::VBRHeader::seek(std::uint64_t t_ms) const noexcept {
+
+    std::uint64_t total = duration();
+
+    if (total == 0 || bytes == 0)
+        return 0;
+
+    double percent = std::min(99.999, static_cast<double>(t_ms) * 100.0 / static_cast<double>(total));
+
+    if (!has_toc)
+        return static_cast<std::uint64_t>(percent / 100.0 * bytes);
+
+    // interpolating between the entries of the seek table
+    auto entry = static_cast<std::size_t>(percent);
+
+    double first = toc[entry];
+    double second = entry + 1 < toc.size() ? toc[entry + 1] : 256.0;
+    double position = first + (second - first) * (percent - static_cast<double>(entry));
+
+    return static_cast<std::uint64_t>(position / 256.0 * bytes);
+}
+
+
+std::optional<MP3::VBRHeader> MP3::parseVBRHeader(std::span<const char> t_frame) noexcept {
+
+    auto header = parseHeader(t_frame);
+
+    if (!header || header->layer != 3 || t_frame.size() < header->size)
+        return {};
+
+    auto frame = t_frame.first(header->size);
+
+    VBRHeader vbr;
+
+    vbr.sample_rate = header->sample_rate;
+    vbr.samples_per_frame = header->samples;
+    vbr.header_size = header->size;
+
+    // the Xing header is stored after the side information
+    std::size_t position = SIZE_OF_HEADER + (header->crc ? 2 : 0) + sideInformationSize(*header);
+
+    if (position + 4 <= frame.size() && (std::memcmp(frame.data() + position, "Xing", 4) == 0 || std::memcmp(frame.data() + position, "Info", 4) == 0)) {
+
+        parseXing(frame, position + 4, vbr);
+
+        return vbr;
+    }
+
+    // the VBRI header is always stored 32 bytes after the frame header
+    position = SIZE_OF_HEADER + 32;
+
+    if (position + 4 <= frame.size() && std::memcmp(frame.data() + position, "VBRI", 4) == 0) {
+
+        parseVBRI(frame, position + 4, vbr);
+
+        return vbr;
+    }
+
+    return {};
+}
+
+
+std::uint64_t MP3::estimateDuration(std::span<const char> t_data) noexcept {
+
+    std::size_t position = findFrame(t_data, 0);
+
+    if (position >= t_data.size())
+        return 0;
+
+    auto frame = t_data.subspan(position);
+
+    if (auto vbr = parseVBRHeader(frame); vbr && vbr->frames > 0)
+        return vbr->duration();
+
+    auto header = parseHeader(frame);
+
+    std::uint64_t bytes = t_data.size() - position;
+
+    // ID3v1 tag at the end of the file
+    if (bytes >= 128 && std::memcmp(t_data.data() + t_data.size() - 128, "TAG", 3) == 0)
+        bytes -= 128;
+
+    // bitrate is in kbit/s, so this is in ms
+    return bytes * 8 / header->bitrate;
+}
+
+
+MP3::FrameIndex MP3::FrameIndex::scan(std::span<const char> t_data, std::uint64_t t_offset) noexcept {
+
+    FrameIndex index;
+
+    std::optional<FrameHeader> first;
+
+    std::size_t position = findFrame(t_data, 0);
+    bool synced = false;
+
+    while (position + SIZE_OF_HEADER <= t_data.size()) {
+
+        auto header = parseHeader(t_data.subspan(position));
+
+        // lost sync, skipping garbage until the next frame
+        if (!header || position + header->size > t_data.size() || (first && !sameStream(*first, *header))) {
+
+            position = findFrame(t_data, position + 1);
+            synced = false;
+
+            continue;
+        }
+
+        std::size_t next = position + header->size;
+
+        // a frame that is not followed by another one is either the last frame or cut off,
+        // in which case a frame starts before the end of this one
+        if (next + SIZE_OF_HEADER <= t_data.size()) {
+
+            auto following = parseHeader(t_data.subspan(next));
+
+            if (!following || !sameStream(*header, *following)) {
+
+                if (std::size_t resync = findFrame(t_data, position + 1); resync < next) {
+
+                    position = resync;
+                    synced = false;
+
+                    continue;
+                }
+            }
+        }
+
+        if (!first) {
+
+            first = header;
+            index.m_sample_rate = header->sample_rate;
+            index.m_samples_per_frame = header->samples;
+
+            // the first frame only holds the VBR header if there is one, it is not an audio frame
+            if (parseVBRHeader(t_data.subspan(position))) {
+                position = next;
+                continue;
+            }
+        }
+
+        std::size_t frame = index.m_sizes.size();
+
+        if (!synced || frame - index.m_checkpoints.back().frame == CHECKPOINT_INTERVAL)
+            index.m_checkpoints.push_back({frame, t_offset + position});
+
+        index.m_sizes.push_back(header->size);
+
+        position = next;
+        synced = true;
+    }
+
+    return index;
+}
+
+
+MP3::FrameIndex MP3::FrameIndex::build(const Song& t_song) noexcept {
+
+    Filehandler handler(t_song.m_path, true);
+
+    if (!handler.isMapped() || handler.bytes().size() <= t_song.m_audio_start) {
+        log::warn(fmt::format("No audio data in file {}", t_song.m_path));
+        return {};
+    }
+
+    auto index = scan(handler.bytes().subspan(t_song.m_audio_start), t_song.m_audio_start);
+
+    log::debug(fmt::format("Indexed {} frames ({} ms) of file {}", index.frames(), index.duration(), t_song.m_path));
+
+    return index;
+}
+
+
+void MP3::FrameIndex::append(const FrameIndex& t_other, std::size_t t_frames) noexcept {
+
+    if (m_sizes.empty()) {
+        m_sample_rate = t_other.m_sample_rate;
+        m_samples_per_frame = t_other.m_samples_per_frame;
+    }
+
+    std::size_t frames = m_sizes.size();
+
+    for (const auto& checkpoint : t_other.m_checkpoints) {
+
+        if (checkpoint.frame >= t_frames)
+            break;
+
+        m_checkpoints.push_back({frames + checkpoint.frame, checkpoint.offset});
+    }
+
+    m_sizes.insert(m_sizes.end(), t_other.m_sizes.begin(), t_other.m_sizes.begin() + static_cast<std::ptrdiff_t>(t_frames));
+}
+
+
+std::uint64_t MP3::FrameIndex::end() const noexcept {
+
+    if (m_sizes.empty())
+        return 0;
+
+    return offset(m_sizes.size() - 1) + m_sizes.back();
+}
+
+
+std::uint64_t MP3::FrameIndex::offset(std::size_t t_frame) const noexcept {
+
+    // last checkpoint at or before the frame
+    auto checkpoint = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), t_frame,
+                                       [](std::size_t frame, const Checkpoint& c) { return frame < c.frame; }) - 1;
+
+    std::uint64_t offset = checkpoint->offset;
+
+    for (std::size_t frame = checkpoint->frame; frame < t_frame; ++frame)
+        offset += m_sizes[frame];
+
+    return offset;
+}
+
+
+std::uint64_t MP3::FrameIndex::duration() const noexcept {
+
+    if (m_sample_rate == 0)
+        return 0;
+
+    return samples() * 1000 / m_sample_rate;
+}
+
+
+std::size_t MP3::FrameIndex::frameAt(std::uint64_t t_ms) const noexcept {
+
+    if (m_samples_per_frame == 0)
+        return 0;
+
+    std::uint64_t frame = t_ms * m_sample_rate / 1000 / m_samples_per_frame;
+
+    return frame < m_sizes.size() ? frame : m_sizes.size();
+}
@@ -1,5 +1,83 @@
 #include <picture.hpp>
+#include <artstore.hpp>
+#include <filehandler.hpp>
+#include <id3.hpp>
+#include <log.hpp>
 #include <utility>
 
 ID3::Picture::Picture(std::shared_ptr<std::vector<char>> t_data, std::string t_mime_type, ID3::PictureType t_pic_type) noexcept :
                       m_data(std::move(t_data)), m_mime_type(std::move(t_mime_type)), m_pic_type(t_pic_type) {}
+
+
+ID3::Picture::Picture(std::string t_path, std::uint32_t t_offset, std::uint32_t t_size, std::string t_mime_type, ID3::PictureType t_pic_type) noexcept :
+                      m_mime_type(std::move(t_mime_type)), m_pic_type(t_pic_type), m_path(std::move(t_path)), m_offset(t_offset), m_size(t_size) {}
+
+
+std::shared_ptr<std::vector<char>> ID3::Picture::data() const {
+
+    if (m_data || m_path.empty())
+        return m_data;
+
+    auto& store = ArtStore::instance();
+
+    // another picture with the same content is already in memory
+    if (m_hash != 0 && (m_data = store.find(m_hash, m_size)))
+        return m_data;
+
+    // the data is not stored in the file as is (e.g. a cached picture of an unsynchronised frame),
+    // the tag has to be parsed again to get it
+    if (m_offset == 0) {
+
+        if (m_hash == 0)
+            return nullptr;
+
+        log::debug(fmt::format("Parsing the tag of file {} again to load {} bytes of picture data", m_path, m_size));
+
+        Song song(m_path);
+        ID3::readID3(song);
+
+        for (const auto& art : song.m_art)
+            if (art.m_hash == m_hash && art.m_size == m_size)
+                return m_data = art.data();
+
+        log::error(fmt::format("Picture data is not in the tag of file {} anymore", m_path));
+
+        return nullptr;
+    }
+
+    log::debug(fmt::format("Loading {} bytes of picture data at offset {} from file {}", m_size, m_offset, m_path));
+
+    Filehandler handler(m_path, true);
+
+    if (handler.isMapped()) {
+
+        auto file = handler.bytes();
+
+        if (static_cast<std::uint64_t>(m_offset) + m_size > file.size()) {
+            log::error(fmt::format("Picture data at offset {} is outside of file {}", m_offset, m_path));
+            return nullptr;
+        }
+
+        auto data = file.subspan(m_offset, m_size);
+
+        m_data = m_hash != 0 ? store.intern(m_hash, data) : std::make_shared<std::vector<char>>(data.begin(), data.end());
+    }
+
+    else {
+
+        auto data = std::make_shared<std::vector<char>>(m_size);
+
+        handler.readBytes(data->data(), m_offset, m_size);
+
+        m_data = m_hash != 0 ? store.intern(m_hash, *data) : std::move(data);
+    }
+
+    return m_data;
+}
+
+
+void ID3::Picture::unload() noexcept {
+
+    if (m_offset != 0 && !m_path.empty())
+        m_data.reset();
+}
@@ -0,0 +1,96 @@
+#include <player.hpp>
+#include <id3.hpp>
+#include <log.hpp>
+
+
+Player::Player(std::vector<Song> t_playlist, AudioSink& t_sink, std::uint32_t t_read_ahead) noexcept
+    : m_playlist(std::move(t_playlist)), m_output(t_sink), m_read_ahead(t_read_ahead) {}
+
+
+void Player::play() noexcept {
+
+    std::vector<std::int16_t> block(BLOCK_FRAMES * 2);
+
+    // the number of frames in the block and their format
+    std::size_t frames = 0;
+    std::uint32_t sample_rate = 0;
+    std::uint32_t channels = 0;
+
+    auto flush = [&] {
+        if (frames != 0)
+            m_output.write(std::span<const std::int16_t>(block.data(), frames * channels));
+        frames = 0;
+    };
+
+    // the next song, opened on another thread
+    std::future<Track> next;
+
+    auto track = open(m_current, false);
+
+    m_current = track.index;
+
+    auto advance = [&] {
+        track = next.valid() ? next.get() : open(m_current + 1, false);
+        m_current = track.index;
+    };
+
+    while (track.stream) {
+
+        auto& stream = *track.stream;
+
+        if (stream.sampleRate() != sample_rate || stream.channels() != channels) {
+
+            flush();
+
+            if (!m_output.open(stream.sampleRate(), stream.channels())) {
+                log::warn(fmt::format("The sink does not accept the format of {}", m_playlist[m_current].m_path));
+                advance();
+                continue;
+            }
+
+            sample_rate = stream.sampleRate();
+            channels = stream.channels();
+        }
+
+        if (!next.valid() && m_current + 1 < m_playlist.size() && stream.remaining() <= std::uint64_t{m_read_ahead} * sample_rate)
+            next = std::async(std::launch::async, &Player::open, this, m_current + 1, true);
+
+        frames += stream.read(std::span<std::int16_t>(block.data() + frames * channels, (BLOCK_FRAMES - frames) * channels));
+
+        if (frames == BLOCK_FRAMES)
+            flush();
+
+        // the next song fills the rest of the block if it has the same format
+        if (stream.finished())
+            advance();
+    }
+
+    flush();
+
+    m_output.close();
+}
+
+
+Player::Track Player::open(std::size_t t_index, bool t_prefetch) noexcept {
+
+    for (; t_index < m_playlist.size(); ++t_index) {
+
+        auto& song = m_playlist[t_index];
+
+        ID3::readID3(song);
+
+        auto stream = std::make_unique<MP3::Stream>(song);
+
+        if (stream->valid()) {
+
+            if (t_prefetch)
+                stream->prefetch(stream->sampleRate() * PREFETCH_MS / 1000);
+
+            log::info(fmt::format("Opened {}", song.m_path));
+
+            return {t_index, std::move(stream)};
+        }
+    }
+
+    return {t_index, nullptr};
+}
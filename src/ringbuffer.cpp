@@ -0,0 +1,75 @@
+#include <ringbuffer.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+
+RingBuffer::RingBuffer(std::size_t t_frames, std::size_t t_channels)
+    : m_capacity(std::bit_ceil(std::max<std::size_t>(t_frames, 1))), m_channels(std::max<std::size_t>(t_channels, 1)) {
+
+    m_samples = std::make_unique<std::int16_t[]>(m_capacity * m_channels);
+}
+
+
+std::size_t RingBuffer::write(std::span<const std::int16_t> t_samples) noexcept {
+
+    std::size_t write = m_write.load(std::memory_order_relaxed);
+    std::size_t frames = t_samples.size() / m_channels;
+
+    // only loading the index of the consumer if the buffer seems to be too full
+    if (m_capacity - (write - m_read_cache) < frames)
+        m_read_cache = m_read.load(std::memory_order_acquire);
+
+    frames = std::min(frames, m_capacity - (write - m_read_cache));
+
+    if (frames == 0)
+        return 0;
+
+    store(write, frames, t_samples.data());
+
+    m_write.store(write + frames, std::memory_order_release);
+
+    return frames;
+}
+
+
+std::size_t RingBuffer::read(std::span<std::int16_t> t_samples) noexcept {
+
+    std::size_t read = m_read.load(std::memory_order_relaxed);
+    std::size_t frames = t_samples.size() / m_channels;
+
+    // only loading the index of the producer if the buffer seems to be too empty
+    if (m_write_cache - read < frames)
+        m_write_cache = m_write.load(std::memory_order_acquire);
+
+    frames = std::min(frames, m_write_cache - read);
+
+    if (frames == 0)
+        return 0;
+
+    load(read, frames, t_samples.data());
+
+    m_read.store(read + frames, std::memory_order_release);
+
+    return frames;
+}
+
+
+void RingBuffer::store(std::size_t t_index, std::size_t t_frames, const std::int16_t* t_samples) noexcept {
+
+    std::size_t start = t_index & (m_capacity - 1);
+    std::size_t first = std::min(t_frames, m_capacity - start);
+
+    std::memcpy(m_samples.get() + start * m_channels, t_samples, first * m_channels * sizeof(std::int16_t));
+    std::memcpy(m_samples.get(), t_samples + first * m_channels, (t_frames - first) * m_channels * sizeof(std::int16_t));
+}
+
+
+void RingBuffer::load(std::size_t t_index, std::size_t t_frames, std::int16_t* t_samples) const noexcept {
+
+    std::size_t start = t_index & (m_capacity - 1);
+    std::size_t first = std::min(t_frames, m_capacity - start);
+
+    std::memcpy(t_samples, m_samples.get() + start * m_channels, first * m_channels * sizeof(std::int16_t));
+    std::memcpy(t_samples + first * m_channels, m_samples.get(), (t_frames - first) * m_channels * sizeof(std::int16_t));
+}
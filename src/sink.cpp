@@ -0,0 +1,319 @@
+#include <sink.hpp>
+#include <log.hpp>
+#include <algorithm>
+
+
+bool NullSink::open(std::uint32_t t_sample_rate, std::uint32_t t_channels) noexcept {
+
+    if (t_sample_rate == 0 || t_channels == 0)
+        return false;
+
+    // a format change keeps counting
+    if (!m_open) {
+        m_frames = 0;
+        m_audio = 0;
+        m_start = std::chrono::steady_clock::now();
+        m_open = true;
+    }
+
+    m_sample_rate = t_sample_rate;
+    m_channels = t_channels;
+
+    return true;
+}
+
+
+std::size_t NullSink::write(std::span<const std::int16_t> t_samples) noexcept {
+
+    if (!m_open)
+        return 0;
+
+    std::size_t frames = t_samples.size() / m_channels;
+
+    m_frames += frames;
+    m_audio += frames * 1000000 / m_sample_rate;
+
+    return frames;
+}
+
+
+void NullSink::close() noexcept {
+
+    if (!m_open)
+        return;
+
+    m_stop = std::chrono::steady_clock::now();
+    m_open = false;
+    m_sample_rate = 0;
+    m_channels = 0;
+}
+
+
+std::uint64_t NullSink::elapsed() const noexcept {
+
+    auto stop = m_open ? std::chrono::steady_clock::now() : m_stop;
+
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(stop - m_start).count());
+}
+
+
+double NullSink::realTimeFactor() const noexcept {
+
+    if (m_audio == 0)
+        return 0.0;
+
+    auto stop = m_open ? std::chrono::steady_clock::now() : m_stop;
+
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(stop - m_start).count()) / static_cast<double>(m_audio);
+}
+
+
+WAVSink::WAVSink(std::string t_path) noexcept : m_path(std::move(t_path)) {}
+
+
+WAVSink::~WAVSink() {
+    close();
+}
+
+
+bool WAVSink::open(std::uint32_t t_sample_rate, std::uint32_t t_channels) noexcept {
+
+    if (t_sample_rate == 0 || t_channels == 0)
+        return false;
+
+    if (m_stream.is_open()) {
+
+        if (t_sample_rate == m_sample_rate && t_channels == m_channels)
+            return true;
+
+        log::warn(fmt::format("Can't change the format of {} to {} Hz, {} channels", m_path, t_sample_rate, t_channels));
+        return false;
+    }
+
+    m_stream.open(m_path, std::ios::binary | std::ios::trunc);
+
+    if (!m_stream) {
+        log::error(fmt::format("Could not open {} for writing", m_path));
+        return false;
+    }
+
+    m_sample_rate = t_sample_rate;
+    m_channels = t_channels;
+    m_bytes = 0;
+
+    // written again with the sizes when the sink is closed
+    writeHeader();
+
+    return m_stream.good();
+}
+
+
+std::size_t WAVSink::write(std::span<const std::int16_t> t_samples) noexcept {
+
+    if (!m_stream.is_open())
+        return 0;
+
+    std::size_t frames = t_samples.size() / m_channels;
+    std::size_t samples = frames * m_channels;
+
+    m_buffer.resize(samples * 2);
+
+    for (std::size_t i = 0; i < samples; ++i) {
+        auto value = static_cast<std::uint16_t>(t_samples[i]);
+        m_buffer[2 * i] = static_cast<char>(value & 0xff);
+        m_buffer[2 * i + 1] = static_cast<char>(value >> 8);
+    }
+
+    m_stream.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+
+    if (!m_stream) {
+        log::error(fmt::format("Could not write to {}", m_path));
+        return 0;
+    }
+
+    m_bytes += m_buffer.size();
+
+    return frames;
+}
+
+
+void WAVSink::close() noexcept {
+
+    if (!m_stream.is_open())
+        return;
+
+    m_stream.seekp(0);
+
+    writeHeader();
+
+    m_stream.close();
+
+    log::debug(fmt::format("Wrote {} bytes of samples to {}", m_bytes, m_path));
+
+    m_sample_rate = 0;
+    m_channels = 0;
+}
+
+
+void WAVSink::writeHeader() noexcept {
+
+    char header[SIZE_OF_HEADER];
+
+    auto write = [&](std::size_t t_position, std::uint32_t t_value, std::size_t t_bytes) {
+        for (std::size_t i = 0; i < t_bytes; ++i)
+            header[t_position + i] = static_cast<char>((t_value >> (8 * i)) & 0xff);
+    };
+
+    // sizes larger than 4 GiB can't be represented, the chunk sizes are clamped
+    auto data = static_cast<std::uint32_t>(std::min<std::uint64_t>(m_bytes, UINT32_MAX - SIZE_OF_HEADER));
+
+    std::copy_n("RIFF", 4, header);
+    write(4, static_cast<std::uint32_t>(SIZE_OF_HEADER - 8) + data, 4);
+    std::copy_n("WAVE", 4, header + 8);
+
+    std::copy_n("fmt ", 4, header + 12);
+    write(16, 16, 4);
+    write(20, 1, 2);
+    write(22, m_channels, 2);
+    write(24, m_sample_rate, 4);
+    write(28, m_sample_rate * m_channels * 2, 4);
+    write(32, m_channels * 2, 2);
+    write(34, 16, 2);
+
+    std::copy_n("data", 4, header + 36);
+    write(40, data, 4);
+
+    m_stream.write(header, SIZE_OF_HEADER);
+}
+
+
+BufferedSink::BufferedSink(AudioSink& t_target, std::size_t t_frames) noexcept
+    : m_target(t_target), m_capacity(std::max(t_frames, BLOCK_FRAMES)) {}
+
+
+BufferedSink::~BufferedSink() {
+    close();
+}
+
+
+bool BufferedSink::open(std::uint32_t t_sample_rate, std::uint32_t t_channels) noexcept {
+
+    if (t_sample_rate == 0 || t_channels == 0)
+        return false;
+
+    bool running = m_output.joinable();
+
+    // the audio of the old format is written before the format changes
+    drain();
+
+    if (!m_target.open(t_sample_rate, t_channels)) {
+
+        // the other sink keeps the old format if it has been open
+        if (running)
+            m_output = std::thread(&BufferedSink::output, this);
+
+        return false;
+    }
+
+    if (!m_buffer || m_buffer->channels() != t_channels)
+        m_buffer = std::make_unique<RingBuffer>(m_capacity, t_channels);
+
+    m_sample_rate = t_sample_rate;
+    m_channels = t_channels;
+
+    m_block.resize(BLOCK_FRAMES * t_channels);
+
+    m_output = std::thread(&BufferedSink::output, this);
+
+    return true;
+}
+
+
+std::size_t BufferedSink::write(std::span<const std::int16_t> t_samples) noexcept {
+
+    if (!m_output.joinable())
+        return 0;
+
+    std::size_t frames = t_samples.size() / m_channels;
+    std::size_t written = 0;
+
+    while (written < frames) {
+
+        // loaded before writing, so that a read in between wakes the wait below right away
+        auto consumed = m_consumed.load(std::memory_order_acquire);
+
+        auto count = m_buffer->write(t_samples.subspan(written * m_channels, (frames - written) * m_channels));
+
+        if (count == 0) {
+            m_consumed.wait(consumed, std::memory_order_acquire);
+            continue;
+        }
+
+        written += count;
+
+        m_produced.fetch_add(1, std::memory_order_release);
+        m_produced.notify_one();
+    }
+
+    return frames;
+}
+
+
+void BufferedSink::close() noexcept {
+
+    drain();
+
+    if (m_sample_rate == 0)
+        return;
+
+    m_target.close();
+
+    m_sample_rate = 0;
+    m_channels = 0;
+}
+
+
+void BufferedSink::output() noexcept {
+
+    while (true) {
+
+        // loaded first, so that a write or a stop after the checks below wakes the wait right away
+        auto produced = m_produced.load(std::memory_order_acquire);
+        bool stop = m_stop.load(std::memory_order_acquire);
+
+        // the frames are passed on in whole blocks, only the rest is passed on in a smaller one when stopping
+        if (stop || m_buffer->available() >= BLOCK_FRAMES) {
+
+            auto frames = m_buffer->read(m_block);
+
+            if (frames == 0)
+                return;
+
+            // the producer can fill the ring again while the frames are written
+            m_consumed.fetch_add(1, std::memory_order_release);
+            m_consumed.notify_one();
+
+            m_target.write(std::span<const std::int16_t>(m_block.data(), frames * m_channels));
+
+            continue;
+        }
+
+        m_produced.wait(produced, std::memory_order_acquire);
+    }
+}
+
+
+void BufferedSink::drain() noexcept {
+
+    if (!m_output.joinable())
+        return;
+
+    m_stop.store(true, std::memory_order_release);
+
+    m_produced.fetch_add(1, std::memory_order_release);
+    m_produced.notify_one();
+
+    m_output.join();
+
+    m_stop.store(false, std::memory_order_relaxed);
+}
@@ -13,14 +13,20 @@ void write_img(Song &song) {
 
     for (const auto& art : song.m_art) {
 
+        auto data = art.data();
+
+        // picture data could not be loaded
+        if (!data)
+            continue;
+
         std::ofstream stream;
         stream.open(song.m_title + ".png", std::ios::binary | std::ios::out);
-        stream.write(art.m_data->data(), static_cast<long>(art.m_data->size()));
+        stream.write(data->data(), static_cast<long>(data->size()));
         stream.close();
 
 
         // size is not what is supposed to be
-        log::debug(fmt::format("Album art has size: {}", art.m_data->size()));
+        log::debug(fmt::format("Album art has size: {}", data->size()));
     }
 }
 
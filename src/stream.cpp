@@ -0,0 +1,320 @@
+#include <stream.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <log.hpp>
+
+
+MP3::Stream::Stream(const Song& t_song) noexcept : m_handler(t_song.m_path) {
+
+    m_pcm.resize(Decoder::MAX_SAMPLES * 2);
+    m_window.reserve(WINDOW_SIZE);
+
+    std::error_code error;
+
+    m_file_size = std::filesystem::file_size(t_song.m_path, error);
+
+    if (error || !m_handler.exists())
+        m_file_size = 0;
+
+    // the file is read with 32 bit offsets
+    if (m_file_size > UINT32_MAX) {
+        log::warn(fmt::format("Only the first 4 GiB of file {} are played", t_song.m_path));
+        m_file_size = UINT32_MAX;
+    }
+
+    m_position = std::min<std::uint64_t>(t_song.m_audio_start, m_file_size);
+
+    std::optional<FrameHeader> header;
+
+    if (sync())
+        header = parseHeader(input(m_position));
+
+    if (!header) {
+        log::warn(fmt::format("No audio data in file {}", t_song.m_path));
+        return;
+    }
+
+    m_sample_rate = header->sample_rate;
+    m_channels = header->channels();
+
+    // the first frame only holds the VBR header if there is one
+    if (auto vbr = parseVBRHeader(input(m_position))) {
+
+        m_position += vbr->header_size;
+
+        if (vbr->delay != 0 || vbr->padding != 0) {
+
+            m_delay = vbr->delay + DECODER_DELAY;
+            m_total = vbr->samples();
+
+            log::debug(fmt::format("Trimming {} samples of delay and {} samples of padding of {}", vbr->delay, vbr->padding, t_song.m_path));
+        }
+    }
+
+    m_first = m_position;
+    m_skip = m_delay;
+    m_remaining = m_total;
+    m_lead = m_silence = t_song.m_delay * m_sample_rate / 1000;
+
+    decode();
+}
+
+
+std::size_t MP3::Stream::read(std::span<std::int16_t> t_pcm) noexcept {
+
+    // the frames that have been decoded ahead of time come first
+    std::size_t ahead = std::min(m_ahead.size() - m_ahead_start, t_pcm.size() - t_pcm.size() % std::max<std::size_t>(m_channels, 1));
+
+    std::copy_n(m_ahead.begin() + static_cast<std::ptrdiff_t>(m_ahead_start), ahead, t_pcm.begin());
+
+    m_ahead_start += ahead;
+
+    if (m_ahead_start == m_ahead.size()) {
+        m_ahead.clear();
+        m_ahead_start = 0;
+    }
+
+    return ahead / std::max<std::size_t>(m_channels, 1) + decodeInto(t_pcm.subspan(ahead));
+}
+
+
+std::size_t MP3::Stream::prefetch(std::size_t t_frames) noexcept {
+
+    std::size_t size = m_ahead.size();
+
+    m_ahead.resize(size + t_frames * m_channels);
+
+    std::size_t frames = decodeInto(std::span<std::int16_t>(m_ahead).subspan(size));
+
+    m_ahead.resize(size + frames * m_channels);
+
+    return frames;
+}
+
+
+bool MP3::Stream::seek(std::uint64_t t_ms) noexcept {
+
+    if (!valid())
+        return false;
+
+    // the index is built window by window, frames that start near the end of a window are scanned
+    // again with the next one, as they might be garbage that only looks valid because the window ends
+    if (m_index.empty()) {
+
+        FrameIndex index;
+
+        for (std::uint64_t position = m_first; position < m_file_size; ) {
+
+            auto data = input(position);
+            std::uint64_t limit = position + (position + data.size() >= m_file_size ? data.size() : data.size() - LOOKAHEAD);
+
+            auto part = FrameIndex::scan(data, position);
+            std::size_t frames = part.frames();
+
+            while (frames > 0 && part.offset(frames - 1) > limit)
+                --frames;
+
+            if (frames == 0) {
+                position = std::max(limit, position + 1);
+                continue;
+            }
+
+            index.append(part, frames);
+            position = index.end();
+        }
+
+        m_index = std::move(index);
+    }
+
+    if (m_index.empty() || m_index.sampleRate() != m_sample_rate)
+        return false;
+
+    std::uint64_t target = t_ms * m_sample_rate / 1000;
+
+    m_ahead.clear();
+    m_ahead_start = 0;
+    m_pcm_start = m_pcm_end = 0;
+
+    // seeking into the silence in front of the audio
+    m_silence = target < m_lead ? m_lead - target : 0;
+
+    target = target > m_lead ? target - m_lead : 0;
+
+    m_remaining = m_total == UINT64_MAX ? UINT64_MAX : m_total - std::min(target, m_total);
+
+    // the position in the decoded samples, which include the delay
+    std::uint64_t sample = target + m_delay;
+    std::size_t frame = sample / m_index.samplesPerFrame();
+
+    if (frame >= m_index.frames()) {
+        m_position = m_file_size;
+        return true;
+    }
+
+    // the frame before fills the overlap of the filterbanks, so it has to be decoded completely as well,
+    // the main data of the frames before it has to be in the bit reservoir for that
+    std::size_t start = frame > 0 ? frame - 1 : 0;
+    std::size_t reservoir = 0;
+    auto header = parseHeader(input(m_index.offset(0)));
+
+    std::size_t side = SIZE_OF_HEADER + (header->crc ? 2 : 0) + sideInformationSize(*header);
+
+    while (start > 0 && reservoir < Decoder::MAX_MAIN_DATA_BEGIN) {
+        --start;
+        reservoir += m_index.size(start) > side ? m_index.size(start) - side : 0;
+    }
+
+    // and one more frame as a margin
+    if (start > 0)
+        --start;
+
+    m_decoder.reset();
+
+    m_position = m_index.offset(start);
+    m_skip = sample - std::uint64_t{start} * m_index.samplesPerFrame();
+
+    log::debug(fmt::format("Seeking to {} ms, frame {}, decoding from frame {}", t_ms, frame, start));
+
+    decode();
+
+    return true;
+}
+
+
+std::uint64_t MP3::Stream::remaining() const noexcept {
+
+    std::uint64_t buffered = (m_ahead.size() - m_ahead_start) / std::max<std::size_t>(m_channels, 1) + m_silence + (m_pcm_end - m_pcm_start);
+
+    if (m_remaining != UINT64_MAX)
+        return buffered + m_remaining;
+
+    if (m_frame_size == 0)
+        return buffered;
+
+    return buffered + (m_file_size - std::min(m_position, m_file_size)) / m_frame_size * m_frame_samples;
+}
+
+
+std::span<const char> MP3::Stream::input(std::uint64_t t_position) noexcept {
+
+    if (t_position >= m_file_size)
+        return {};
+
+    std::uint64_t end = m_window_start + m_window.size();
+
+    if (t_position < m_window_start || std::min(t_position + LOOKAHEAD, m_file_size) > end) {
+
+        // the capacity has been reserved, so this doesn't allocate
+        m_window.resize(std::min<std::uint64_t>(WINDOW_SIZE, m_file_size - t_position));
+
+        m_handler.readBytes(m_window.data(), static_cast<std::uint32_t>(t_position), static_cast<std::uint32_t>(m_window.size()));
+
+        m_window_start = t_position;
+    }
+
+    return std::span<const char>(m_window).subspan(t_position - m_window_start);
+}
+
+
+bool MP3::Stream::sync() noexcept {
+
+    while (m_position < m_file_size) {
+
+        auto data = input(m_position);
+
+        // a frame near the end of the window might only look valid because the window ends after it,
+        // it is checked again once the window has been refilled
+        std::size_t limit = m_position + data.size() >= m_file_size ? data.size() : data.size() - LOOKAHEAD;
+        std::size_t next = findFrame(data, 0);
+
+        if (next < data.size() && next <= limit) {
+            m_position += next;
+            return true;
+        }
+
+        m_position += std::max<std::size_t>(limit, 1);
+    }
+
+    return false;
+}
+
+
+std::size_t MP3::Stream::decodeInto(std::span<std::int16_t> t_pcm) noexcept {
+
+    std::size_t capacity = m_channels == 0 ? 0 : t_pcm.size() / m_channels;
+    std::size_t frames = 0;
+
+    while (frames < capacity) {
+
+        if (m_silence != 0) {
+
+            std::size_t count = static_cast<std::size_t>(std::min<std::uint64_t>(m_silence, capacity - frames));
+
+            std::fill_n(t_pcm.begin() + static_cast<std::ptrdiff_t>(frames * m_channels), count * m_channels, std::int16_t{0});
+
+            m_silence -= count;
+            frames += count;
+
+            continue;
+        }
+
+        if (m_pcm_start == m_pcm_end && !decode())
+            break;
+
+        std::size_t count = std::min(m_pcm_end - m_pcm_start, capacity - frames);
+
+        std::memcpy(t_pcm.data() + frames * m_channels, m_pcm.data() + m_pcm_start * m_channels, count * m_channels * sizeof(std::int16_t));
+
+        m_pcm_start += count;
+        frames += count;
+    }
+
+    return frames;
+}
+
+
+bool MP3::Stream::decode() noexcept {
+
+    while (m_remaining != 0 && m_position < m_file_size) {
+
+        auto data = input(m_position);
+        auto header = parseHeader(data);
+
+        if (!header || header->size > data.size()) {
+
+            ++m_position;
+            sync();
+
+            continue;
+        }
+
+        std::size_t samples = m_decoder.decode(data.first(header->size), m_pcm);
+
+        m_position += header->size;
+
+        m_frame_size = header->size;
+        m_frame_samples = header->samples;
+
+        if (samples == 0 || m_decoder.sampleRate() != m_sample_rate || m_decoder.channels() != m_channels)
+            continue;
+
+        // dropping the delay at the start and the padding at the end
+        std::size_t skip = static_cast<std::size_t>(std::min<std::uint64_t>(m_skip, samples));
+
+        m_skip -= skip;
+
+        m_pcm_start = skip;
+        m_pcm_end = skip + static_cast<std::size_t>(std::min<std::uint64_t>(m_remaining, samples - skip));
+
+        if (m_remaining != UINT64_MAX)
+            m_remaining -= m_pcm_end - m_pcm_start;
+
+        if (m_pcm_start != m_pcm_end)
+            return true;
+    }
+
+    m_pcm_start = m_pcm_end = 0;
+
+    return false;
+}
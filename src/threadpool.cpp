@@ -0,0 +1,137 @@
+#include <threadpool.hpp>
+#include <log.hpp>
+
+
+ThreadPool::ThreadPool(std::size_t t_threads) {
+
+    if (t_threads == 0)
+        t_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    log::info(fmt::format("Starting thread pool with {} workers", t_threads));
+
+    m_queues.reserve(t_threads);
+
+    for (std::size_t i = 0; i < t_threads; ++i)
+        m_queues.push_back(std::make_unique<Queue>());
+
+    m_threads.reserve(t_threads);
+
+    for (std::size_t i = 0; i < t_threads; ++i)
+        m_threads.emplace_back(&ThreadPool::work, this, i);
+}
+
+
+void ThreadPool::submit(std::function<void()> t_task) {
+
+    auto& queue = *m_queues[m_next++ % m_queues.size()];
+
+    m_pending++;
+
+    // counted under the lock of the queue, which is also held when the task is taken,
+    // so the counter can't drop below 0 and it never counts a task that can't be taken yet
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(t_task));
+        m_queued++;
+    }
+
+    // taking the lock once makes sure that no worker is in between checking
+    // for work and going to sleep, so the notification can't get lost
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+
+    m_work_available.notify_one();
+}
+
+
+void ThreadPool::wait() {
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_done.wait(lock, [this] { return m_pending == 0; });
+}
+
+
+bool ThreadPool::take(std::size_t t_index, std::function<void()>& t_task) {
+
+    // own queue first, newest task first as its data is most likely still cached
+    {
+        auto& queue = *m_queues[t_index];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (!queue.tasks.empty()) {
+            t_task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            m_queued--;
+            return true;
+        }
+    }
+
+    // stealing the oldest task of another worker
+    for (std::size_t i = 1; i < m_queues.size(); ++i) {
+
+        auto& queue = *m_queues[(t_index + i) % m_queues.size()];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (!queue.tasks.empty()) {
+            t_task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            m_queued--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void ThreadPool::work(std::size_t t_index) {
+
+    std::function<void()> task;
+
+    while (true) {
+
+        if (take(t_index, task)) {
+
+            task();
+
+            if (--m_pending == 0) {
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                }
+
+                m_done.notify_all();
+            }
+        }
+
+        else {
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_work_available.wait(lock, [this] { return m_stop || m_queued > 0; });
+
+            if (m_stop && m_queued == 0)
+                return;
+        }
+    }
+}
+
+
+ThreadPool::~ThreadPool() {
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_work_available.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+
+    log::info("Stopped thread pool");
+}
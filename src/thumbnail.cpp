@@ -0,0 +1,366 @@
+#include <thumbnail.hpp>
+#include <algorithm>
+#include <artstore.hpp>
+#include <cache.hpp>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <log.hpp>
+#include <jpeglib.h>
+#include <png.h>
+
+
+namespace {
+
+    // libjpeg reports fatal errors through error_exit, which must not return
+    struct JPEGError {
+        jpeg_error_mgr manager;
+        std::jmp_buf jump;
+    };
+
+
+    void jpegErrorExit(j_common_ptr t_info) {
+
+        char message[JMSG_LENGTH_MAX];
+
+        (*t_info->err->format_message)(t_info, message);
+
+        log::error(fmt::format("Could not decode JPEG image: {}", message));
+
+        std::longjmp(reinterpret_cast<JPEGError*>(t_info->err)->jump, 1);
+    }
+
+
+    void jpegOutputMessage(j_common_ptr) {}
+
+
+    std::optional<Image> decodeJPEG(std::span<const char> t_data) {
+
+        jpeg_decompress_struct info;
+        JPEGError error;
+
+        // the image is only used if decoding did not jump back to setjmp
+        Image image{0, 0, RGB888, {}};
+
+        info.err = jpeg_std_error(&error.manager);
+        error.manager.error_exit = jpegErrorExit;
+        error.manager.output_message = jpegOutputMessage;
+
+        if (setjmp(error.jump)) {
+            jpeg_destroy_decompress(&info);
+            return {};
+        }
+
+        jpeg_create_decompress(&info);
+        jpeg_mem_src(&info, reinterpret_cast<const unsigned char*>(t_data.data()), t_data.size());
+
+        if (jpeg_read_header(&info, TRUE) != JPEG_HEADER_OK) {
+            jpeg_destroy_decompress(&info);
+            return {};
+        }
+
+        info.out_color_space = JCS_RGB;
+
+        // decoding at 1/2, 1/4 or 1/8 scale is a lot faster, as long as the result is still larger than every thumbnail
+        unsigned int largest = ThumbnailCache::SIZES.back();
+        unsigned int smaller = std::min(info.image_width, info.image_height);
+
+        info.scale_num = 1;
+        info.scale_denom = 1;
+
+        while (info.scale_denom < 8 && smaller / (info.scale_denom * 2) >= largest)
+            info.scale_denom *= 2;
+
+        jpeg_start_decompress(&info);
+
+        if (info.output_components != 3 || info.output_width > UINT16_MAX || info.output_height > UINT16_MAX) {
+            jpeg_destroy_decompress(&info);
+            return {};
+        }
+
+        image.width = static_cast<std::uint16_t>(info.output_width);
+        image.height = static_cast<std::uint16_t>(info.output_height);
+        image.pixels.resize(static_cast<std::size_t>(image.width) * image.height * RGB888);
+
+        while (info.output_scanline < info.output_height) {
+
+            JSAMPROW row = image.pixels.data() + static_cast<std::size_t>(info.output_scanline) * image.width * RGB888;
+
+            jpeg_read_scanlines(&info, &row, 1);
+        }
+
+        jpeg_finish_decompress(&info);
+        jpeg_destroy_decompress(&info);
+
+        return image;
+    }
+
+
+    std::optional<Image> decodePNG(std::span<const char> t_data) {
+
+        png_image png;
+
+        std::memset(&png, 0, sizeof(png));
+        png.version = PNG_IMAGE_VERSION;
+
+        if (!png_image_begin_read_from_memory(&png, t_data.data(), t_data.size())) {
+            log::error(fmt::format("Could not decode PNG image: {}", png.message));
+            return {};
+        }
+
+        if (png.width > UINT16_MAX || png.height > UINT16_MAX) {
+            png_image_free(&png);
+            return {};
+        }
+
+        png.format = PNG_FORMAT_RGB;
+
+        Image image{static_cast<std::uint16_t>(png.width), static_cast<std::uint16_t>(png.height), RGB888, {}};
+
+        image.pixels.resize(PNG_IMAGE_SIZE(png));
+
+        if (!png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr)) {
+            log::error(fmt::format("Could not decode PNG image: {}", png.message));
+            return {};
+        }
+
+        return image;
+    }
+}
+
+
+ThumbnailCache::ThumbnailCache(std::string t_directory) : m_directory(std::move(t_directory)) {
+
+    std::error_code error;
+
+    std::filesystem::create_directories(m_directory, error);
+
+    if (error)
+        log::error(fmt::format("Could not create thumbnail directory {}: {}", m_directory, error.message()));
+}
+
+
+std::string ThumbnailCache::defaultDirectory() {
+
+    return (MetadataCache::cacheDirectory() / "thumbnails").string();
+}
+
+
+std::optional<Image> ThumbnailCache::get(const ID3::Picture& t_picture, std::uint16_t t_size, PixelFormat t_format) const {
+
+    if (std::find(SIZES.begin(), SIZES.end(), t_size) == SIZES.end()) {
+        log::error(fmt::format("Unsupported thumbnail size {}", t_size));
+        return {};
+    }
+
+    // the hash is only unknown for pictures that are in memory anyway
+    auto data = t_picture.m_hash != 0 ? nullptr : t_picture.data();
+
+    std::uint64_t hash = t_picture.m_hash;
+
+    if (hash == 0) {
+
+        if (!data)
+            return {};
+
+        hash = ID3::ArtStore::hash(*data);
+    }
+
+    if (auto cached = load(path(hash, t_size, t_format)))
+        return cached;
+
+    if (!data && !(data = t_picture.data()))
+        return {};
+
+    auto decoded = decode(*data);
+
+    if (!decoded)
+        return {};
+
+    log::debug(fmt::format("Creating thumbnails for {}x{} picture {:016x}", decoded->width, decoded->height, hash));
+
+    std::optional<Image> result;
+
+    // creating every size from the next larger one, which is as good as from the original with area averaging
+    // for sizes that divide each other and a lot faster
+    Image source = std::move(*decoded);
+
+    for (auto size = SIZES.rbegin(); size != SIZES.rend(); ++size) {
+
+        source = downscale(source, *size);
+
+        Image rgb565 = toRGB565(source);
+
+        store(path(hash, *size, RGB888), source);
+        store(path(hash, *size, RGB565), rgb565);
+
+        if (*size == t_size)
+            result = t_format == RGB565 ? std::move(rgb565) : source;
+    }
+
+    return result;
+}
+
+
+std::optional<Image> ThumbnailCache::decode(std::span<const char> t_data) {
+
+    static constexpr unsigned char JPEG[] = {0xff, 0xd8, 0xff};
+    static constexpr unsigned char PNG[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+    if (t_data.size() >= sizeof(JPEG) && std::memcmp(t_data.data(), JPEG, sizeof(JPEG)) == 0)
+        return decodeJPEG(t_data);
+
+    if (t_data.size() >= sizeof(PNG) && std::memcmp(t_data.data(), PNG, sizeof(PNG)) == 0)
+        return decodePNG(t_data);
+
+    log::warn("Unsupported picture format, only JPEG and PNG can be decoded");
+
+    return {};
+}
+
+
+Image ThumbnailCache::downscale(const Image& t_image, std::uint16_t t_size) {
+
+    if (t_image.width <= t_size && t_image.height <= t_size)
+        return t_image;
+
+    std::size_t larger = std::max(t_image.width, t_image.height);
+
+    auto width = static_cast<std::uint16_t>(std::max<std::size_t>(1, t_image.width * t_size / larger));
+    auto height = static_cast<std::uint16_t>(std::max<std::size_t>(1, t_image.height * t_size / larger));
+
+    Image result{width, height, RGB888, std::vector<std::uint8_t>(static_cast<std::size_t>(width) * height * RGB888)};
+
+    for (std::size_t y = 0; y < height; ++y) {
+
+        std::size_t top = y * t_image.height / height;
+        std::size_t bottom = std::max(top + 1, (y + 1) * t_image.height / height);
+
+        for (std::size_t x = 0; x < width; ++x) {
+
+            std::size_t left = x * t_image.width / width;
+            std::size_t right = std::max(left + 1, (x + 1) * t_image.width / width);
+
+            std::uint32_t sum[3] = {0, 0, 0};
+
+            for (std::size_t row = top; row < bottom; ++row) {
+
+                const std::uint8_t* pixel = t_image.pixels.data() + (row * t_image.width + left) * RGB888;
+
+                for (std::size_t column = left; column < right; ++column, pixel += RGB888) {
+                    sum[0] += pixel[0];
+                    sum[1] += pixel[1];
+                    sum[2] += pixel[2];
+                }
+            }
+
+            auto count = static_cast<std::uint32_t>((bottom - top) * (right - left));
+            std::uint8_t* target = result.pixels.data() + (y * width + x) * RGB888;
+
+            for (std::size_t channel = 0; channel < 3; ++channel)
+                target[channel] = static_cast<std::uint8_t>((sum[channel] + count / 2) / count);
+        }
+    }
+
+    return result;
+}
+
+
+Image ThumbnailCache::toRGB565(const Image& t_image) {
+
+    std::size_t pixels = static_cast<std::size_t>(t_image.width) * t_image.height;
+
+    Image result{t_image.width, t_image.height, RGB565, std::vector<std::uint8_t>(pixels * RGB565)};
+
+    for (std::size_t i = 0; i < pixels; ++i) {
+
+        const std::uint8_t* pixel = t_image.pixels.data() + i * RGB888;
+
+        auto value = static_cast<std::uint16_t>(((pixel[0] >> 3) << 11) | ((pixel[1] >> 2) << 5) | (pixel[2] >> 3));
+
+        result.pixels[i * RGB565] = static_cast<std::uint8_t>(value & 0xff);
+        result.pixels[i * RGB565 + 1] = static_cast<std::uint8_t>(value >> 8);
+    }
+
+    return result;
+}
+
+
+std::string ThumbnailCache::path(std::uint64_t t_hash, std::uint16_t t_size, PixelFormat t_format) const {
+
+    return (std::filesystem::path(m_directory) / fmt::format("{:016x}_{}.{}", t_hash, t_size, t_format == RGB565 ? "rgb565" : "rgb888")).string();
+}
+
+
+std::optional<Image> ThumbnailCache::load(const std::string& t_path) {
+
+    std::ifstream stream(t_path, std::ios::binary | std::ios::in);
+
+    if (!stream)
+        return {};
+
+    char header[SIZE_OF_HEADER];
+
+    if (!stream.read(header, SIZE_OF_HEADER) || std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0) {
+        log::warn(fmt::format("Ignoring invalid thumbnail {}", t_path));
+        return {};
+    }
+
+    Image image{0, 0, RGB888, {}};
+
+    std::memcpy(&image.width, header + 4, sizeof(image.width));
+    std::memcpy(&image.height, header + 6, sizeof(image.height));
+
+    if (header[8] != RGB565 && header[8] != RGB888) {
+        log::warn(fmt::format("Ignoring invalid thumbnail {}", t_path));
+        return {};
+    }
+
+    image.format = static_cast<PixelFormat>(header[8]);
+    image.pixels.resize(static_cast<std::size_t>(image.width) * image.height * static_cast<std::size_t>(image.format));
+
+    if (!stream.read(reinterpret_cast<char*>(image.pixels.data()), static_cast<long>(image.pixels.size()))) {
+        log::warn(fmt::format("Ignoring truncated thumbnail {}", t_path));
+        return {};
+    }
+
+    return image;
+}
+
+
+bool ThumbnailCache::store(const std::string& t_path, const Image& t_image) {
+
+    char header[SIZE_OF_HEADER];
+
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    std::memcpy(header + 4, &t_image.width, sizeof(t_image.width));
+    std::memcpy(header + 6, &t_image.height, sizeof(t_image.height));
+    header[8] = static_cast<char>(t_image.format);
+
+    std::string temporary = t_path + ".tmp";
+
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::out | std::ios::trunc);
+
+        stream.write(header, SIZE_OF_HEADER);
+        stream.write(reinterpret_cast<const char*>(t_image.pixels.data()), static_cast<long>(t_image.pixels.size()));
+
+        if (!stream) {
+            log::error(fmt::format("Could not write thumbnail to {}", temporary));
+            return false;
+        }
+    }
+
+    std::error_code error;
+
+    std::filesystem::rename(temporary, t_path, error);
+
+    if (error) {
+        log::error(fmt::format("Could not replace {}: {}", t_path, error.message()));
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,185 @@
+#include <unicode.hpp>
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define UNICODE_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define UNICODE_NEON
+#endif
+
+
+namespace {
+
+    // the number of code units that are transcoded at once
+    constexpr std::size_t BLOCK = 8;
+
+
+    /**
+     * @return the code unit at t_data
+     */
+    inline std::uint32_t unit(const char* t_data, bool t_big_endian) noexcept {
+
+        std::uint32_t first = static_cast<std::uint8_t>(t_data[0]);
+        std::uint32_t second = static_cast<std::uint8_t>(t_data[1]);
+
+        return t_big_endian ? (first << 8) | second : (second << 8) | first;
+    }
+
+
+    /**
+     * Encodes a code point as UTF-8.
+     *
+     * @return the number of bytes written
+     */
+    inline std::size_t encode(std::uint32_t t_code, char* t_output) noexcept {
+
+        if (t_code < 0x80) {
+            t_output[0] = static_cast<char>(t_code);
+            return 1;
+        }
+
+        if (t_code < 0x800) {
+            t_output[0] = static_cast<char>(0xc0 | (t_code >> 6));
+            t_output[1] = static_cast<char>(0x80 | (t_code & 0x3f));
+            return 2;
+        }
+
+        if (t_code < 0x10000) {
+            t_output[0] = static_cast<char>(0xe0 | (t_code >> 12));
+            t_output[1] = static_cast<char>(0x80 | ((t_code >> 6) & 0x3f));
+            t_output[2] = static_cast<char>(0x80 | (t_code & 0x3f));
+            return 3;
+        }
+
+        t_output[0] = static_cast<char>(0xf0 | (t_code >> 18));
+        t_output[1] = static_cast<char>(0x80 | ((t_code >> 12) & 0x3f));
+        t_output[2] = static_cast<char>(0x80 | ((t_code >> 6) & 0x3f));
+        t_output[3] = static_cast<char>(0x80 | (t_code & 0x3f));
+        return 4;
+    }
+
+
+    /**
+     * Transcodes BLOCK code units if all of them are ASCII characters, which is the case for
+     * most of the text in tags.
+     *
+     * @return true if the code units have been transcoded, false if they have to be transcoded one by one
+     */
+    inline bool transcodeASCII([[maybe_unused]] const char* t_data, [[maybe_unused]] bool t_big_endian, [[maybe_unused]] char* t_output) noexcept {
+
+#if defined(UNICODE_SSE2)
+        __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_data));
+
+        if (t_big_endian)
+            units = _mm_or_si128(_mm_slli_epi16(units, 8), _mm_srli_epi16(units, 8));
+
+        // none of the upper 9 bits of a code unit are set for ASCII characters
+        __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16(static_cast<std::int16_t>(0xff80))), _mm_setzero_si128());
+
+        if (_mm_movemask_epi8(ascii) != 0xffff)
+            return false;
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(t_output), _mm_packus_epi16(units, units));
+
+        return true;
+#elif defined(UNICODE_NEON)
+        uint8x16_t bytes = vld1q_u8(reinterpret_cast<const std::uint8_t*>(t_data));
+
+        if (t_big_endian)
+            bytes = vrev16q_u8(bytes);
+
+        uint16x8_t units = vreinterpretq_u16_u8(bytes);
+        uint64x2_t high = vreinterpretq_u64_u16(vandq_u16(units, vdupq_n_u16(0xff80)));
+
+        if ((vgetq_lane_u64(high, 0) | vgetq_lane_u64(high, 1)) != 0)
+            return false;
+
+        vst1_u8(reinterpret_cast<std::uint8_t*>(t_output), vmovn_u16(units));
+
+        return true;
+#else
+        return false;
+#endif
+    }
+}
+
+
+std::size_t Unicode::findTerminator(std::span<const char> t_data) noexcept {
+
+    std::size_t size = t_data.size() - t_data.size() % 2;
+    std::size_t position = 0;
+
+#if defined(UNICODE_SSE2)
+    for (; position + 2 * BLOCK <= size; position += 2 * BLOCK) {
+
+        __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t_data.data() + position));
+
+        // both bytes of a 0x0000 code unit are set in the mask
+        auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi16(units, _mm_setzero_si128())));
+
+        if (mask != 0)
+            return position + static_cast<std::size_t>(__builtin_ctz(mask));
+    }
+#elif defined(UNICODE_NEON)
+    for (; position + 2 * BLOCK <= size; position += 2 * BLOCK) {
+
+        uint16x8_t units = vreinterpretq_u16_u8(vld1q_u8(reinterpret_cast<const std::uint8_t*>(t_data.data() + position)));
+        uint64x2_t zero = vreinterpretq_u64_u16(vceqq_u16(units, vdupq_n_u16(0)));
+
+        // the terminator is in this block, it is found by the loop below
+        if ((vgetq_lane_u64(zero, 0) | vgetq_lane_u64(zero, 1)) != 0)
+            break;
+    }
+#endif
+
+    for (; position < size; position += 2)
+        if (t_data[position] == 0x00 && t_data[position + 1] == 0x00)
+            return position;
+
+    return size;
+}
+
+
+std::size_t Unicode::utf16ToUTF8(std::span<const char> t_data, bool t_big_endian, char t_output[]) noexcept {
+
+    std::size_t units = t_data.size() / 2;
+    std::size_t unit_index = 0;
+    std::size_t size = 0;
+
+    while (unit_index < units) {
+
+        if (unit_index + BLOCK <= units && transcodeASCII(t_data.data() + 2 * unit_index, t_big_endian, t_output + size)) {
+            unit_index += BLOCK;
+            size += BLOCK;
+            continue;
+        }
+
+        // transcoding the block one code point at a time, a surrogate pair may end one code unit after the block
+        for (std::size_t end = std::min(unit_index + BLOCK, units); unit_index < end; ) {
+
+            std::uint32_t code = unit(t_data.data() + 2 * unit_index++, t_big_endian);
+
+            if (code >= 0xd800 && code < 0xe000) {
+
+                std::uint32_t low = unit_index < units ? unit(t_data.data() + 2 * unit_index, t_big_endian) : 0;
+
+                // a high surrogate followed by a low surrogate
+                if (code < 0xdc00 && low >= 0xdc00 && low < 0xe000) {
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    ++unit_index;
+                }
+
+                else {
+                    code = 0xfffd;
+                }
+            }
+
+            size += encode(code, t_output + size);
+        }
+    }
+
+    return size;
+}
@@ -0,0 +1,230 @@
+#include <watcher.hpp>
+#include <algorithm>
+#include <id3.hpp>
+#include <library.hpp>
+#include <poll.h>
+#include <unistd.h>
+
+
+namespace {
+
+    // returns the first song whose path is not less than t_path
+    std::vector<Song>::iterator find(std::vector<Song>& t_songs, const std::string& t_path) {
+
+        return std::lower_bound(t_songs.begin(), t_songs.end(), t_path,
+                                [](const Song& song, const std::string& path) { return song.m_path < path; });
+    }
+}
+
+
+Watcher::Watcher(std::vector<std::string> t_roots, MetadataCache* t_cache) : m_roots(std::move(t_roots)), m_cache(t_cache) {
+
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (m_fd < 0) {
+        log::error("Could not initialize inotify");
+        return;
+    }
+
+    for (const auto& root : m_roots)
+        watch(root);
+}
+
+
+void Watcher::watch(const std::string& t_directory) {
+
+    int wd = inotify_add_watch(m_fd, t_directory.c_str(), EVENTS | IN_ONLYDIR);
+
+    if (wd < 0) {
+        log::warn(fmt::format("Could not watch directory {}", t_directory));
+        return;
+    }
+
+    m_directories[wd] = t_directory;
+
+    log::debug(fmt::format("Watching directory {}", t_directory));
+
+    std::error_code error;
+
+    for (const auto& entry : std::filesystem::directory_iterator(t_directory, std::filesystem::directory_options::skip_permission_denied, error)) {
+        if (entry.is_directory(error) && !entry.is_symlink(error))
+            watch(entry.path().string());
+    }
+}
+
+
+void Watcher::unwatch(const std::string& t_directory) {
+
+    auto prefix = t_directory + "/";
+
+    std::erase_if(m_directories, [this, &t_directory, &prefix](const auto& entry) {
+
+        if (entry.second != t_directory && !entry.second.starts_with(prefix))
+            return false;
+
+        inotify_rm_watch(m_fd, entry.first);
+
+        return true;
+    });
+}
+
+
+void Watcher::update(std::vector<Song>& t_songs, const std::string& t_path) {
+
+    Song song(t_path);
+
+    auto stamp = MetadataCache::stamp(t_path);
+
+    ID3::readID3(song);
+
+    if (m_cache != nullptr && stamp)
+        m_cache->store(song, *stamp);
+
+    auto position = find(t_songs, t_path);
+
+    if (position != t_songs.end() && position->m_path == t_path) {
+        log::info(fmt::format("Updating song {}", t_path));
+        *position = std::move(song);
+    }
+
+    else {
+        log::info(fmt::format("Adding song {}", t_path));
+        t_songs.insert(position, std::move(song));
+    }
+}
+
+
+std::size_t Watcher::remove(std::vector<Song>& t_songs, const std::string& t_path, bool t_directory) {
+
+    if (!t_directory) {
+
+        auto position = find(t_songs, t_path);
+
+        if (position == t_songs.end() || position->m_path != t_path)
+            return 0;
+
+        log::info(fmt::format("Removing song {}", t_path));
+
+        t_songs.erase(position);
+
+        return 1;
+    }
+
+    // all songs in the directory are next to each other as the list is sorted
+    auto prefix = t_path + "/";
+
+    auto first = find(t_songs, prefix);
+    auto last = std::find_if(first, t_songs.end(), [&prefix](const Song& song) { return !song.m_path.starts_with(prefix); });
+
+    auto removed = static_cast<std::size_t>(last - first);
+
+    log::info(fmt::format("Removing {} songs in directory {}", removed, t_path));
+
+    t_songs.erase(first, last);
+
+    return removed;
+}
+
+
+std::size_t Watcher::poll(std::vector<Song>& t_songs, int t_timeout) {
+
+    if (!valid())
+        return 0;
+
+    pollfd descriptor{m_fd, POLLIN, 0};
+
+    if (::poll(&descriptor, 1, t_timeout) <= 0)
+        return 0;
+
+    std::size_t changes = 0;
+    bool overflow = false;
+
+    alignas(inotify_event) char buffer[4096];
+
+    ssize_t length;
+
+    while ((length = read(m_fd, buffer, sizeof(buffer))) > 0) {
+
+        for (char* pointer = buffer; pointer < buffer + length; ) {
+
+            const auto* event = reinterpret_cast<const inotify_event*>(pointer);
+
+            pointer += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+
+            if (event->mask & IN_IGNORED) {
+                m_directories.erase(event->wd);
+                continue;
+            }
+
+            auto directory = m_directories.find(event->wd);
+
+            if (directory == m_directories.end() || event->len == 0)
+                continue;
+
+            auto path = directory->second + "/" + event->name;
+            bool is_directory = event->mask & IN_ISDIR;
+
+            // new directories have to be watched, and the files in them have
+            // to be added as there are no events for files that are moved in along with a directory
+            if (is_directory && event->mask & (IN_CREATE | IN_MOVED_TO)) {
+
+                watch(path);
+
+                for (const auto& file : Library::findFiles(path)) {
+                    update(t_songs, file);
+                    changes++;
+                }
+            }
+
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+
+                // the watches of a directory that has been moved away would
+                // report events with the old path, deleted directories are cleaned up by IN_IGNORED
+                if (is_directory && event->mask & IN_MOVED_FROM)
+                    unwatch(path);
+
+                changes += remove(t_songs, path, is_directory);
+            }
+
+            // files are parsed once they have been written completely (or moved in)
+            else if (!is_directory && event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO) && Library::isMP3(path)) {
+
+                update(t_songs, path);
+                changes++;
+            }
+        }
+    }
+
+    // the kernel dropped events, the only way to be sure is to scan everything again
+    if (overflow) {
+
+        log::warn("inotify event queue overflowed, rescanning the library");
+
+        std::vector<Song> songs;
+
+        for (const auto& root : m_roots) {
+            auto found = Library::scan(root, 0, m_cache);
+            std::move(found.begin(), found.end(), std::back_inserter(songs));
+        }
+
+        std::sort(songs.begin(), songs.end(), [](const Song& a, const Song& b) { return a.m_path < b.m_path; });
+
+        changes += songs.size();
+
+        t_songs = std::move(songs);
+    }
+
+    return changes;
+}
+
+
+Watcher::~Watcher() {
+
+    if (m_fd >= 0)
+        close(m_fd);
+}
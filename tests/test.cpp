@@ -2,7 +2,23 @@
 #define CATCH_CONFIG_MAIN
 
 #include <catch2/catch.hpp>
+#include <artstore.hpp>
+#include <cache.hpp>
+#include <decoder.hpp>
+#include <huffman.hpp>
 #include <id3.hpp>
+#include <library.hpp>
+#include <mp3.hpp>
+#include <player.hpp>
+#include <png.h>
+#include <random>
+#include <ringbuffer.hpp>
+#include <sink.hpp>
+#include <threadpool.hpp>
+#include <thumbnail.hpp>
+#include <unicode.hpp>
+#include <watcher.hpp>
+#include <zlib.h>
 
 
 TEST_CASE("Testing convert_bytes from id3.hpp", "[ID3::convert_bytes]") {
@@ -93,105 +109,102 @@ TEST_CASE("Testing decode_text_retain_position from id3.hpp", "[ID3::decode_text
     }
 
 
-    // 'aA~Ö' starting at position 0, not null terminated TODO
-    std::vector<char> UTF16_1 = {0x61, 0x41, 0x7e, (char)0xc3, (char)0x96};
+    // 'aA~Ö' little endian starting at position 0, not null terminated
+    std::vector<char> UTF16_1 = {(char)0xff, (char)0xfe, 0x61, 0x00, 0x41, 0x00, 0x7e, 0x00, (char)0xd6, 0x00};
 
-    // 'aA~' starting at position 1, not null terminated TODO
-    std::vector<char> UTF16_2 = {0x00, 0x61, 0x41, 0x7e};
+    // 'aA~' big endian starting at position 1, not null terminated
+    std::vector<char> UTF16_2 = {0x00, (char)0xfe, (char)0xff, 0x00, 0x61, 0x00, 0x41, 0x00, 0x7e};
 
-    // 'a', starting at position 2, null terminated TODO
-    std::vector<char> UTF16_3 = {0x00, 0x00, 0x61, 0x00, 0x00};
+    // 'a' little endian, starting at position 2, null terminated
+    std::vector<char> UTF16_3 = {0x00, 0x00, (char)0xff, (char)0xfe, 0x61, 0x00, 0x00, 0x00, 0x61, 0x00};
 
-    // 'A' starting at position 2, null terminated TODO
-    std::vector<char> UTF16_4 = {0x00, 0x61, 0x41, 0x00, 0x7e};
+    // '€𝄞' (U+20AC, U+1D11E as a surrogate pair) big endian starting at position 1, null terminated
+    std::vector<char> UTF16_4 = {0x00, (char)0xfe, (char)0xff, 0x20, (char)0xac, (char)0xd8, 0x34, (char)0xdd, 0x1e, 0x00, 0x00, 0x7e};
 
-    // 'Ö', not null terminated TODO
-    std::vector<char> UTF16_5 = {(char)0xc3, (char)0x96};
+    // BOM missing
+    std::vector<char> UTF16_5 = {0x61, 0x00, 0x00, 0x00};
 
 
     SECTION("Testing UTF-16 with BOM implementation") {
-        // TODO
 
         auto container1 = ID3::decode_text_retain_position(UTF16, UTF16_1, 0);
 
-        REQUIRE(container1.position == 4);
+        REQUIRE(container1.position == 10);
         REQUIRE(container1.text == "aA~Ö");
         REQUIRE(container1.error == false);
 
         auto container2 = ID3::decode_text_retain_position(UTF16, UTF16_2, 1);
 
-        REQUIRE(container1.position == 4);
-        REQUIRE(container1.text == "aA~");
-        REQUIRE(container1.error == false);
+        REQUIRE(container2.position == 9);
+        REQUIRE(container2.text == "aA~");
+        REQUIRE(container2.error == false);
 
         auto container3 = ID3::decode_text_retain_position(UTF16, UTF16_3, 2);
 
-        REQUIRE(container1.position == 4);
-        REQUIRE(container1.text == "a");
-        REQUIRE(container1.error == false);
+        REQUIRE(container3.position == 8);
+        REQUIRE(container3.text == "a");
+        REQUIRE(container3.error == false);
 
-        auto container4 = ID3::decode_text_retain_position(UTF16, UTF16_4, 2);
+        auto container4 = ID3::decode_text_retain_position(UTF16, UTF16_4, 1);
 
-        REQUIRE(container1.position == 4);
-        REQUIRE(container1.text == "A");
-        REQUIRE(container1.error == false);
+        REQUIRE(container4.position == 11);
+        REQUIRE(container4.text == "€𝄞");
+        REQUIRE(container4.error == false);
 
         auto container5 = ID3::decode_text_retain_position(UTF16, UTF16_5, 0);
 
-        REQUIRE(container1.position == 1);
-        REQUIRE(container1.text == "Ö");
-        REQUIRE(container1.error == false);
+        REQUIRE(container5.position == 0);
+        REQUIRE(container5.error == true);
     }
 
 
-    // 'aA~Ö' starting at position 0, not null terminated TODO
-    std::vector<char> UTF16B_1 = {0x61, 0x41, 0x7e, (char)0xc3, (char)0x96};
+    // 'aA~Ö' starting at position 0, not null terminated
+    std::vector<char> UTF16B_1 = {0x00, 0x61, 0x00, 0x41, 0x00, 0x7e, 0x00, (char)0xd6};
 
-    // 'aA~' starting at position 1, not null terminated TODO
-    std::vector<char> UTF16B_2 = {0x00, 0x61, 0x41, 0x7e};
+    // 'aA~' starting at position 1, not null terminated, with a trailing byte
+    std::vector<char> UTF16B_2 = {0x00, 0x00, 0x61, 0x00, 0x41, 0x00, 0x7e, 0x00};
 
-    // 'a', starting at position 2, null terminated TODO
-    std::vector<char> UTF16B_3 = {0x00, 0x00, 0x61, 0x00, 0x00};
+    // 'a', starting at position 2, null terminated
+    std::vector<char> UTF16B_3 = {0x00, 0x00, 0x00, 0x61, 0x00, 0x00, 0x00, 0x61};
 
-    // 'A' starting at position 2, null terminated TODO
-    std::vector<char> UTF16B_4 = {0x00, 0x61, 0x41, 0x00, 0x7e};
+    // a high surrogate that is not followed by a low surrogate, replaced by U+FFFD, null terminated
+    std::vector<char> UTF16B_4 = {(char)0xd8, 0x34, 0x00, 0x41, 0x00, 0x00};
 
-    // 'Ö', not null terminated TODO
-    std::vector<char> UTF16B_5 = {(char)0xc3, (char)0x96};
+    // empty, null terminated
+    std::vector<char> UTF16B_5 = {0x00, 0x00, 0x00, 0x41};
 
 
     SECTION("Testing UTF-16B implementation") {
-        // TODO
 
         auto container1 = ID3::decode_text_retain_position(UTF16B, UTF16B_1, 0);
 
-        REQUIRE(container1.position == 4);
+        REQUIRE(container1.position == 8);
         REQUIRE(container1.text == "aA~Ö");
         REQUIRE(container1.error == false);
 
         auto container2 = ID3::decode_text_retain_position(UTF16B, UTF16B_2, 1);
 
-        REQUIRE(container1.position == 4);
-        REQUIRE(container1.text == "aA~");
-        REQUIRE(container1.error == false);
+        REQUIRE(container2.position == 8);
+        REQUIRE(container2.text == "aA~");
+        REQUIRE(container2.error == false);
 
         auto container3 = ID3::decode_text_retain_position(UTF16B, UTF16B_3, 2);
 
-        REQUIRE(container1.position == 4);
-        REQUIRE(container1.text == "a");
-        REQUIRE(container1.error == false);
+        REQUIRE(container3.position == 6);
+        REQUIRE(container3.text == "a");
+        REQUIRE(container3.error == false);
 
-        auto container4 = ID3::decode_text_retain_position(UTF16B, UTF16B_4, 2);
+        auto container4 = ID3::decode_text_retain_position(UTF16B, UTF16B_4, 0);
 
-        REQUIRE(container1.position == 4);
-        REQUIRE(container1.text == "A");
-        REQUIRE(container1.error == false);
+        REQUIRE(container4.position == 6);
+        REQUIRE(container4.text == "\xef\xbf\xbd" "A");
+        REQUIRE(container4.error == false);
 
         auto container5 = ID3::decode_text_retain_position(UTF16B, UTF16B_5, 0);
 
-        REQUIRE(container1.position == 1);
-        REQUIRE(container1.text == "Ö");
-        REQUIRE(container1.error == false);
+        REQUIRE(container5.position == 2);
+        REQUIRE(container5.text.empty());
+        REQUIRE(container5.error == false);
     }
 
 
@@ -294,6 +307,2180 @@ TEST_CASE("Testing the synchronize function from id3.hpp", "[ID3::synchronize]")
         REQUIRE(test_data_3.size() == 4);
     }
 
+
+    SECTION("Testing synchronizing into another buffer") {
+
+        std::vector<char> input = {0x01, (char)0xff, 0x00, (char)0xff, (char)0xff, 0x00, 0x00, (char)0xff};
+        std::vector<char> output(input.size());
+
+        REQUIRE(ID3::synchronize(input, output.data()) == 6);
+        REQUIRE(std::equal(output.begin(), output.begin() + 6, std::vector<char>{0x01, (char)0xff, (char)0xff, (char)0xff, 0x00, (char)0xff}.begin()));
+        REQUIRE(input.size() == 8);
+    }
+
+
+    SECTION("Testing large buffers") {
+
+        std::mt19937 random(7);
+        std::vector<char> synchronized(100000);
+
+        for (auto& byte : synchronized)
+            byte = random() % 4 == 0 ? (char)0xff : static_cast<char>(random() % 3);
+
+        // unsynchronization, a 0x00 byte after every 0xff byte followed by 0x00 or a byte >= 0xe0
+        std::vector<char> data;
+
+        for (std::size_t i = 0; i < synchronized.size(); ++i) {
+
+            data.push_back(synchronized[i]);
+
+            if (synchronized[i] == (char)0xff && (i + 1 == synchronized.size() || synchronized[i + 1] == 0x00 || (unsigned char)synchronized[i + 1] >= 0xe0))
+                data.push_back(0x00);
+        }
+
+        ID3::synchronize(data);
+
+        REQUIRE(data == synchronized);
+    }
+
+}
+
+
+TEST_CASE("Testing the parseTag function from id3.hpp", "[ID3::parseTag]") {
+
+    // appends a frame with a non syncsafe size (ID3v2.3) to the tag buffer
+    auto append_frame = [](std::vector<char>& t_tag, const std::string& t_id, const std::vector<char>& t_data, char t_format_flags = 0x00) {
+
+        t_tag.insert(t_tag.end(), t_id.begin(), t_id.end());
+
+        auto size = static_cast<std::uint32_t>(t_data.size());
+
+        t_tag.push_back(static_cast<char>(size >> 24));
+        t_tag.push_back(static_cast<char>(size >> 16));
+        t_tag.push_back(static_cast<char>(size >> 8));
+        t_tag.push_back(static_cast<char>(size));
+        t_tag.push_back(0x00);
+        t_tag.push_back(t_format_flags);
+
+        t_tag.insert(t_tag.end(), t_data.begin(), t_data.end());
+    };
+
+    std::vector<char> tag{};
+
+    append_frame(tag, "TIT2", {0x00, 'T', 'i', 't', 'l', 'e', 0x00});
+    append_frame(tag, "TPE1", {0x03, 'A', 'r', 't', 'i', 's', 't'});
+    append_frame(tag, "XXXX", {0x01, 0x02, 0x03});
+    append_frame(tag, "PCNT", {0x00, 0x00, 0x01, 0x00});
+
+    SECTION("Testing a tag with frames and padding") {
+
+        std::vector<char> padded = tag;
+        padded.resize(padded.size() + 32, 0x00);
+
+        Song song("test.mp3");
+        ID3::parseTag(padded, 3, 0x00, song);
+
+        REQUIRE(song.m_title == "Title");
+        REQUIRE(song.m_artist == "Artist");
+        REQUIRE(song.m_album == "Unknown Album");
+        REQUIRE(song.m_play_counter == 256);
+
+        // 3 frames with a header of 10 bytes each before the PCNT frame, offset by the tag header
+        REQUIRE(song.m_counter_offset == ID3::SIZE_OF_HEADER + 3 * ID3::SIZE_OF_HEADER + 7 + 7 + 3);
+    }
+
+    SECTION("Testing a tag parsed with a context") {
+
+        ID3::ParseContext context;
+
+        Song song("test.mp3");
+        ID3::parseTag(tag, 3, 0x00, song, context);
+
+        REQUIRE(song.m_title == "Title");
+        REQUIRE(song.m_artist == "Artist");
+
+        // the decoded strings are taken from the arena
+        std::vector<char> text = {0x00, 'T', 'e', 'x', 't', 0x00};
+        auto decoded = ID3::decode_text(0x00, text, 1, context.arena());
+
+        REQUIRE(decoded == "Text");
+        REQUIRE(decoded.get_allocator().resource() == context.arena());
+
+        // the scratch buffer reallocates, it doesn't leave its old blocks in the arena
+        REQUIRE(context.scratch().get_allocator().resource() != context.arena());
+    }
+
+    SECTION("Testing the frame handlers") {
+
+        REQUIRE(ID3::fourCC("TIT2") == 0x54495432);
+        REQUIRE(ID3::fourCC("TIT") == 0);
+        REQUIRE(ID3::frameHandler(ID3::fourCC("TIT2")) != nullptr);
+        REQUIRE(ID3::frameHandler(ID3::fourCC("XXXX")) == nullptr);
+
+        // a frame that is not supported can be parsed by a registered handler
+        REQUIRE(ID3::registerFrameHandler(ID3::fourCC("XXXX"), [](const ID3::FrameData& t_frame, std::span<const char>, Song& t_song,
+                                                                  const ID3::ParseOptions&, ID3::ParseContext&) noexcept {
+            t_song.m_album = std::string(t_frame.data().begin(), t_frame.data().end());
+        }));
+
+        Song song("test.mp3");
+        ID3::parseTag(tag, 3, 0x00, song);
+
+        REQUIRE(song.m_album == std::string{0x01, 0x02, 0x03});
+        REQUIRE(song.m_play_counter == 256);
+
+        // skipping the frame again
+        REQUIRE(ID3::registerFrameHandler(ID3::fourCC("XXXX"), nullptr));
+        REQUIRE(ID3::frameHandler(ID3::fourCC("XXXX")) == nullptr);
+        REQUIRE_FALSE(ID3::registerFrameHandler(0, nullptr));
+
+        // a TDRC frame after a TDRL frame is ignored, but the frames after it are still parsed
+        std::vector<char> dates{};
+
+        append_frame(dates, "TDRL", {0x00, '2', '0', '2', '0'});
+        append_frame(dates, "TDRC", {0x00, '1', '9', '9', '9'});
+        append_frame(dates, "TIT2", {0x00, 'T', 'i', 't', 'l', 'e'});
+
+        Song dated("test.mp3");
+        ID3::parseTag(dates, 3, 0x00, dated);
+
+        REQUIRE(dated.m_release == "2020");
+        REQUIRE(dated.m_title == "Title");
+    }
+
+    SECTION("Testing unsynchronised tags") {
+
+        // the whole ID3v2.3 tag is unsynchronised, the size of a frame is the one after synchronization
+        std::vector<char> v3{};
+
+        append_frame(v3, "TIT2", {0x00, 'T', 'i', 't', 'l', 'e', 0x00});
+        append_frame(v3, "PCNT", {0x00, (char)0xff, 0x00, 0x01});
+
+        v3.insert(v3.end() - 2, 0x00);
+
+        Song song_v3("test.mp3");
+        ID3::parseTag(v3, 3, 0x80, song_v3);
+
+        REQUIRE(song_v3.m_title == "Title");
+        REQUIRE(song_v3.m_play_counter == 0x00ff0001);
+
+        // the offset is unknown as the tag has been altered
+        REQUIRE(song_v3.m_counter_offset == 0);
+
+        // the frames of an ID3v2.4 tag are unsynchronised one by one, the size of a frame is the one before synchronization
+        std::vector<char> v4{};
+
+        append_frame(v4, "PCNT", {0x00, (char)0xff, 0x00, 0x00, 0x01});
+
+        Song song_v4("test.mp3");
+        ID3::parseTag(v4, 4, 0x80, song_v4);
+
+        REQUIRE(song_v4.m_play_counter == 0x00ff0001);
+    }
+
+    SECTION("Testing compressed frames") {
+
+        // zlib compressed data preceded by the data length indicator
+        auto compressed = [](const std::string& t_text) {
+
+            std::string text = '\x03' + t_text + '\0';
+            std::vector<char> frame = {0x00, 0x00, 0x00, static_cast<char>(text.size())};
+
+            uLongf size = compressBound(text.size());
+
+            frame.resize(frame.size() + size);
+
+            compress(reinterpret_cast<Bytef*>(frame.data() + 4), &size, reinterpret_cast<const Bytef*>(text.data()), text.size());
+
+            frame.resize(4 + size);
+
+            return frame;
+        };
+
+        std::vector<char> v4{};
+
+        append_frame(v4, "TIT2", compressed(std::string(100, 'a')), 0x09);
+        append_frame(v4, "TPE1", compressed("Artist"), 0x09);
+
+        // a group identifier in front of the data length indicator, unsynchronised after compression
+        auto album = compressed("Album");
+
+        album.insert(album.begin(), 0x42);
+
+        for (std::size_t i = album.size(); i-- > 0; )
+            if (album[i] == (char)0xff)
+                album.insert(album.begin() + static_cast<std::ptrdiff_t>(i) + 1, 0x00);
+
+        append_frame(v4, "TALB", album, 0x4b);
+
+        // the data length indicator is missing
+        append_frame(v4, "TCOM", {0x00, 0x01, 0x02}, 0x08);
+
+        Song song("test.mp3");
+        ID3::parseTag(v4, 4, 0x00, song);
+
+        REQUIRE(song.m_title == std::string(100, 'a'));
+        REQUIRE(song.m_artist == "Artist");
+        REQUIRE(song.m_album == "Album");
+    }
+
+    SECTION("Testing frames that fail to decompress") {
+
+        std::vector<char> v4{};
+
+        // not zlib data
+        append_frame(v4, "TIT2", {0x00, 0x00, 0x00, 0x05, 0x03, 'T', 'e', 'x', 't'}, 0x09);
+
+        // the data length indicator is too small for the data
+        std::string text = "\x03" + std::string(64, 'a');
+        std::vector<char> truncated = {0x00, 0x00, 0x00, 0x10};
+
+        uLongf size = compressBound(text.size());
+
+        truncated.resize(truncated.size() + size);
+        compress(reinterpret_cast<Bytef*>(truncated.data() + 4), &size, reinterpret_cast<const Bytef*>(text.data()), text.size());
+        truncated.resize(4 + size);
+
+        append_frame(v4, "TPE1", truncated, 0x09);
+
+        // a picture without a data length indicator
+        append_frame(v4, "APIC", {0x00, 'i', 'm', 'a', 'g', 'e', '/', 'p', 'n', 'g', 0x00, 0x03, 0x00, 0x01, 0x02}, 0x08);
+
+        append_frame(v4, "TALB", {0x03, 'A', 'l', 'b', 'u', 'm'});
+
+        Song song("test.mp3");
+        ID3::parseTag(v4, 4, 0x00, song);
+
+        REQUIRE(song.m_title == "Unknown Title");
+        REQUIRE(song.m_artist == "Unknown Artist");
+        REQUIRE(song.m_art.empty());
+        REQUIRE(song.m_album == "Album");
+    }
+
+    SECTION("Testing a frame that is larger than the tag") {
+
+        std::vector<char> truncated = tag;
+        truncated.resize(truncated.size() - 2);
+
+        Song song("test.mp3");
+        ID3::parseTag(truncated, 3, 0x00, song);
+
+        REQUIRE(song.m_title == "Title");
+        REQUIRE(song.m_play_counter == 0);
+    }
+}
+
+
+TEST_CASE("Testing the memory mapped mode of the Filehandler", "[Filehandler]") {
+
+    auto path = (std::filesystem::temp_directory_path() / "filehandler_test.bin").string();
+
+    {
+        std::ofstream stream(path, std::ios::binary | std::ios::out);
+        stream << "first line\nsecond line\n";
+    }
+
+    Filehandler streamed(path);
+    Filehandler mapped(path, true);
+
+    REQUIRE_FALSE(streamed.isMapped());
+    REQUIRE(mapped.isMapped());
+    REQUIRE(mapped.bytes().size() == 23);
+
+    SECTION("Testing readBytes in both modes") {
+
+        char buffer_1[6]{};
+        char buffer_2[6]{};
+
+        streamed.readBytes(buffer_1, 11, 6);
+        mapped.readBytes(buffer_2, 11, 6);
+
+        REQUIRE(std::string(buffer_1, 6) == "second");
+        REQUIRE(std::string(buffer_2, 6) == "second");
+    }
+
+    SECTION("Testing reads past the end of a mapped file") {
+
+        char buffer[4] = {'x', 'x', 'x', 'x'};
+
+        mapped.readBytes(buffer, 21, 4);
+
+        REQUIRE(buffer[0] == 'e');
+        REQUIRE(buffer[1] == '\n');
+        REQUIRE(buffer[2] == 'x');
+    }
+
+    SECTION("Testing reading lines from a mapped file") {
+
+        auto lines = mapped.read();
+
+        REQUIRE(lines->size() == 2);
+        REQUIRE(lines->at(1) == "second line");
+    }
+
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE("Testing the ThreadPool", "[ThreadPool]") {
+
+    ThreadPool pool(4);
+
+    REQUIRE(pool.size() == 4);
+
+    SECTION("Testing that every task is executed exactly once") {
+
+        std::vector<std::atomic<int>> counters(1000);
+
+        for (auto& counter : counters)
+            pool.submit([&counter] { counter++; });
+
+        pool.wait();
+
+        REQUIRE(std::all_of(counters.begin(), counters.end(), [](auto& counter) { return counter == 1; }));
+    }
+
+    SECTION("Testing waiting without any tasks") {
+        pool.wait();
+        REQUIRE(pool.size() == 4);
+    }
+}
+
+
+TEST_CASE("Testing the library scan from library.hpp", "[Library::scan]") {
+
+    auto root = std::filesystem::temp_directory_path() / "library_test";
+
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root / "album");
+
+    // ID3v2.4 tag with a single TIT2 frame
+    auto write_song = [](const std::filesystem::path& t_path, char t_title) {
+        std::ofstream stream(t_path, std::ios::binary | std::ios::out);
+        const char tag[] = {'I', 'D', '3', 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0d,
+                            'T', 'I', 'T', '2', 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, t_title, 0x00};
+        stream.write(tag, sizeof(tag));
+    };
+
+    write_song(root / "b.mp3", 'B');
+    write_song(root / "album" / "a.MP3", 'A');
+    write_song(root / "notes.txt", 'N');
+
+    REQUIRE(Library::isMP3("song.Mp3"));
+    REQUIRE_FALSE(Library::isMP3("song.mp4"));
+    REQUIRE_FALSE(Library::isMP3("mp3"));
+
+    auto songs = Library::scan(root.string(), 2);
+
+    REQUIRE(songs.size() == 2);
+    REQUIRE(songs[0].m_title == "A");
+    REQUIRE(songs[1].m_title == "B");
+    REQUIRE(songs[1].m_audio_start == 23);
+
+    std::filesystem::remove_all(root);
+}
+
+
+TEST_CASE("Testing the MetadataCache", "[MetadataCache]") {
+
+    auto root = std::filesystem::temp_directory_path() / "cache_test";
+
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    auto song_path = (root / "song.mp3").string();
+    auto cache_path = (root / "library.cache").string();
+
+    std::ofstream(song_path, std::ios::binary | std::ios::out) << "not really an mp3 file";
+
+    Song song(song_path);
+    song.m_title = "Title";
+    song.m_artist = "Artist";
+    song.m_audio_start = 1234;
+    song.m_play_counter = 7;
+    song.m_art.emplace_back(nullptr, "image/jpeg", ID3::COVER_FRONT);
+    song.m_art.back().m_offset = 100;
+    song.m_art.back().m_size = 200;
+    song.m_art.back().m_hash = 0x1234;
+
+    auto stamp = MetadataCache::stamp(song_path);
+
+    REQUIRE(stamp);
+    REQUIRE(stamp->size == 22);
+
+    SECTION("Testing serialization of an entry") {
+
+        std::vector<char> buffer;
+        MetadataCache::serialize(song, *stamp, buffer);
+
+        std::size_t position = 0;
+        auto entry = MetadataCache::deserialize(buffer, position);
+
+        REQUIRE(entry);
+        REQUIRE(position == buffer.size());
+        REQUIRE(entry->second == *stamp);
+        REQUIRE(entry->first.m_path == song_path);
+        REQUIRE(entry->first.m_title == "Title");
+        REQUIRE(entry->first.m_audio_start == 1234);
+        REQUIRE(entry->first.m_play_counter == 7);
+        REQUIRE(entry->first.m_art.size() == 1);
+        REQUIRE(entry->first.m_art[0].m_offset == 100);
+        REQUIRE(entry->first.m_art[0].m_size == 200);
+        REQUIRE(entry->first.m_art[0].m_hash == 0x1234);
+        REQUIRE(entry->first.m_art[0].m_mime_type == "image/jpeg");
+
+        position = 0;
+        buffer.pop_back();
+
+        REQUIRE_FALSE(MetadataCache::deserialize(buffer, position));
+    }
+
+    SECTION("Testing saving and loading the cache") {
+
+        {
+            MetadataCache cache(cache_path);
+            REQUIRE(cache.size() == 0);
+
+            cache.store(song, *stamp);
+            REQUIRE(cache.save());
+        }
+
+        MetadataCache cache(cache_path);
+
+        REQUIRE(cache.size() == 1);
+        REQUIRE(cache.lookup(song_path, *stamp)->m_artist == "Artist");
+
+        // a different size or modification time means the file has changed
+        REQUIRE_FALSE(cache.lookup(song_path, FileStamp{stamp->size + 1, stamp->mtime}));
+        REQUIRE_FALSE(cache.lookup(song_path, FileStamp{stamp->size, stamp->mtime + 1}));
+    }
+
+    SECTION("Testing pictures of unsynchronised frames") {
+
+        auto picture_path = (root / "unsynchronised.mp3").string();
+
+        // unsynchronised ID3v2.3 tag with one APIC frame, a 0x00 byte has been inserted after the 0xff byte of the picture
+        const char file[] = {'I', 'D', '3', 0x03, 0x00, static_cast<char>(0x80), 0x00, 0x00, 0x00, 0x1d,
+                             'A', 'P', 'I', 'C', 0x00, 0x00, 0x00, 0x12, 0x00, 0x00,
+                             0x00, 'i', 'm', 'a', 'g', 'e', '/', 'p', 'n', 'g', 0x00, 0x03, 'x', 0x00,
+                             static_cast<char>(0xff), 0x00, 0x00, 0x01, 0x02};
+
+        std::ofstream(picture_path, std::ios::binary | std::ios::out).write(file, sizeof(file));
+
+        std::vector<char> buffer;
+
+        {
+            Song parsed(picture_path);
+            ID3::readID3(parsed);
+
+            REQUIRE(parsed.m_art.size() == 1);
+            REQUIRE(parsed.m_art[0].m_offset == 0);
+
+            MetadataCache::serialize(parsed, *MetadataCache::stamp(picture_path), buffer);
+        }
+
+        std::size_t position = 0;
+        auto entry = MetadataCache::deserialize(buffer, position);
+
+        REQUIRE(entry);
+        REQUIRE(entry->first.m_art.size() == 1);
+
+        // the picture data is not in the ArtStore anymore, the tag is parsed again
+        auto& art = entry->first.m_art[0];
+
+        REQUIRE_FALSE(art.isLoaded());
+
+        auto data = art.data();
+
+        REQUIRE(data);
+        REQUIRE(*data == std::vector<char>{static_cast<char>(0xff), 0x00, 0x01, 0x02});
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+
+TEST_CASE("Testing the Watcher", "[Watcher]") {
+
+    auto root = std::filesystem::temp_directory_path() / "watcher_test";
+
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root);
+
+    Watcher watcher({root.string()});
+
+    REQUIRE(watcher.valid());
+
+    std::vector<Song> songs;
+
+    // creating a file and a directory with a file in it
+    std::ofstream(root / "b.mp3", std::ios::binary | std::ios::out) << "ID3";
+    std::ofstream(root / "notes.txt", std::ios::binary | std::ios::out) << "text";
+    std::filesystem::create_directories(root / "album");
+    std::ofstream(root / "album" / "a.mp3", std::ios::binary | std::ios::out) << "ID3";
+
+    // waiting until there are no more events
+    while (watcher.poll(songs, 200) > 0) {}
+
+    REQUIRE(songs.size() == 2);
+    REQUIRE(songs[0].m_path == (root / "album" / "a.mp3").string());
+    REQUIRE(songs[1].m_path == (root / "b.mp3").string());
+
+    std::filesystem::remove(root / "b.mp3");
+    std::filesystem::rename(root / "album", std::filesystem::temp_directory_path() / "watcher_test_album");
+
+    while (watcher.poll(songs, 200) > 0) {}
+
+    REQUIRE(songs.empty());
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "watcher_test_album");
+    std::filesystem::remove_all(root);
+}
+
+
+TEST_CASE("Testing lazily loaded pictures", "[ID3::Picture]") {
+
+    auto path = (std::filesystem::temp_directory_path() / "picture_test.mp3").string();
+
+    // ID3v2.3 tag with one APIC frame with 4 bytes of picture data
+    const char file[] = {'I', 'D', '3', 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1c,
+                         'A', 'P', 'I', 'C', 0x00, 0x00, 0x00, 0x12, 0x00, 0x00,
+                         0x00, 'i', 'm', 'a', 'g', 'e', '/', 'p', 'n', 'g', 0x00, 0x03, 'x', 0x00,
+                         0x01, 0x02, 0x03, 0x04};
+
+    std::ofstream(path, std::ios::binary | std::ios::out).write(file, sizeof(file));
+
+    SECTION("Testing lazy loading") {
+
+        Song song(path);
+        ID3::readID3(song);
+
+        REQUIRE(song.m_art.size() == 1);
+
+        auto& art = song.m_art[0];
+
+        REQUIRE_FALSE(art.isLoaded());
+        REQUIRE(art.m_pic_type == ID3::COVER_FRONT);
+        REQUIRE(art.m_mime_type == "image/png");
+        REQUIRE(art.m_offset == 34);
+        REQUIRE(art.m_size == 4);
+
+        auto data = art.data();
+
+        REQUIRE(art.isLoaded());
+        REQUIRE(*data == std::vector<char>{0x01, 0x02, 0x03, 0x04});
+
+        art.unload();
+
+        REQUIRE_FALSE(art.isLoaded());
+    }
+
+    SECTION("Testing eager loading") {
+
+        Song song(path);
+        ID3::readID3(song, {.lazy_art = false});
+
+        REQUIRE(song.m_art.size() == 1);
+        REQUIRE(song.m_art[0].isLoaded());
+        REQUIRE(*song.m_art[0].m_data == std::vector<char>{0x01, 0x02, 0x03, 0x04});
+    }
+
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE("Testing the ArtStore", "[ID3::ArtStore]") {
+
+    auto& store = ID3::ArtStore::instance();
+
+    std::vector<char> cover_1(1000, 0x42);
+    std::vector<char> cover_2(1000, 0x42);
+    std::vector<char> cover_3(999, 0x42);
+
+    SECTION("Testing hashes") {
+
+        REQUIRE(ID3::ArtStore::hash(cover_1) == ID3::ArtStore::hash(cover_2));
+        REQUIRE(ID3::ArtStore::hash(cover_1) != ID3::ArtStore::hash(cover_3));
+        REQUIRE(ID3::ArtStore::hash({}) != 0);
+
+        cover_2[500] = 0x43;
+
+        REQUIRE(ID3::ArtStore::hash(cover_1) != ID3::ArtStore::hash(cover_2));
+    }
+
+    SECTION("Testing that identical pictures share a buffer") {
+
+        auto hash = ID3::ArtStore::hash(cover_1);
+
+        auto buffer_1 = store.intern(hash, cover_1);
+        auto buffer_2 = store.intern(hash, cover_2);
+
+        REQUIRE(buffer_1 == buffer_2);
+        REQUIRE(*buffer_1 == cover_1);
+        REQUIRE(store.find(hash, cover_1.size()) == buffer_1);
+
+        // the same hash with different content must not be shared
+        auto buffer_3 = store.intern(hash, cover_3);
+
+        REQUIRE(buffer_3 != buffer_1);
+        REQUIRE(*buffer_3 == cover_3);
+
+        // the buffer is freed along with the last picture that uses it
+        buffer_1.reset();
+        buffer_2.reset();
+
+        REQUIRE(store.find(hash, cover_1.size()) == nullptr);
+    }
+}
+
+
+TEST_CASE("Testing the ThumbnailCache", "[ThumbnailCache]") {
+
+    auto root = std::filesystem::temp_directory_path() / "thumbnail_test";
+
+    std::filesystem::remove_all(root);
+
+    // 512x256 image, the left half red and the right half blue
+    Image image{512, 256, RGB888, std::vector<std::uint8_t>(512 * 256 * 3, 0)};
+
+    for (std::size_t y = 0; y < 256; ++y)
+        for (std::size_t x = 0; x < 512; ++x)
+            image.pixels[(y * 512 + x) * 3 + (x < 256 ? 0 : 2)] = 0xff;
+
+    SECTION("Testing downscaling") {
+
+        auto small = ThumbnailCache::downscale(image, 64);
+
+        REQUIRE(small.width == 64);
+        REQUIRE(small.height == 32);
+        REQUIRE(small.pixels.size() == 64 * 32 * 3);
+        REQUIRE(small.pixels[0] == 0xff);
+        REQUIRE(small.pixels[2] == 0x00);
+        REQUIRE(small.pixels[63 * 3] == 0x00);
+        REQUIRE(small.pixels[63 * 3 + 2] == 0xff);
+
+        auto rgb565 = ThumbnailCache::toRGB565(small);
+
+        REQUIRE(rgb565.format == RGB565);
+        REQUIRE(rgb565.pixels.size() == 64 * 32 * 2);
+        REQUIRE(rgb565.pixels[0] == 0x00);
+        REQUIRE(rgb565.pixels[1] == 0xf8);
+        REQUIRE(rgb565.pixels[63 * 2] == 0x1f);
+        REQUIRE(rgb565.pixels[63 * 2 + 1] == 0x00);
+
+        // images that already fit are not scaled up
+        REQUIRE(ThumbnailCache::downscale(small, 128).width == 64);
+    }
+
+    SECTION("Testing thumbnails of a PNG picture") {
+
+        png_image png;
+        std::memset(&png, 0, sizeof(png));
+        png.version = PNG_IMAGE_VERSION;
+        png.width = image.width;
+        png.height = image.height;
+        png.format = PNG_FORMAT_RGB;
+
+        png_alloc_size_t size = 0;
+
+        REQUIRE(png_image_write_to_memory(&png, nullptr, &size, 0, image.pixels.data(), 0, nullptr));
+
+        auto data = std::make_shared<std::vector<char>>(size);
+
+        REQUIRE(png_image_write_to_memory(&png, data->data(), &size, 0, image.pixels.data(), 0, nullptr));
+
+        ID3::Picture picture(data, "image/png", ID3::COVER_FRONT);
+
+        ThumbnailCache cache(root.string());
+
+        REQUIRE_FALSE(cache.get(picture, 100, RGB888));
+
+        auto thumbnail = cache.get(picture, 128, RGB565);
+
+        REQUIRE(thumbnail);
+        REQUIRE(thumbnail->width == 128);
+        REQUIRE(thumbnail->height == 64);
+        REQUIRE(thumbnail->format == RGB565);
+        REQUIRE(thumbnail->pixels.size() == 128 * 64 * 2);
+
+        // every size is created in both formats at once
+        REQUIRE(std::distance(std::filesystem::directory_iterator(root), std::filesystem::directory_iterator()) == 6);
+
+        // the picture is not decoded again
+        picture.m_hash = ID3::ArtStore::hash(*data);
+        picture.m_data.reset();
+
+        auto cached = cache.get(picture, 256, RGB888);
+
+        REQUIRE(cached);
+        REQUIRE(cached->width == 256);
+        REQUIRE(cached->height == 128);
+        REQUIRE(cached->pixels[0] == 0xff);
+        REQUIRE(cached->pixels[255 * 3 + 2] == 0xff);
+    }
+
+    SECTION("Testing undecodable pictures") {
+
+        ID3::Picture picture(std::make_shared<std::vector<char>>(100, 0x42), "image/jpeg", ID3::COVER_FRONT);
+
+        ThumbnailCache cache(root.string());
+
+        REQUIRE_FALSE(cache.get(picture, 64, RGB888));
+    }
+
+    std::filesystem::remove_all(root);
+}
+
+
+TEST_CASE("Testing the frame scanner from mp3.hpp", "[MP3::FrameIndex]") {
+
+    // MPEG 1 layer 3, 44.1 kHz, joint stereo, 128 kbit/s (417 bytes), padded (418 bytes) and 192 kbit/s (626 bytes)
+    const std::array<std::array<char, 4>, 3> headers = {{
+        {'\xff', '\xfb', '\x90', '\x64'},
+        {'\xff', '\xfb', '\x92', '\x64'},
+        {'\xff', '\xfb', '\xb0', '\x64'}
+    }};
+
+    std::vector<char> data{'a', 'b', 'c'};
+    std::vector<std::uint64_t> offsets;
+
+    auto append = [&](std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto& header = headers[i % headers.size()];
+            offsets.push_back(1000 + data.size());
+            data.insert(data.end(), header.begin(), header.end());
+            data.resize(data.size() + (i % 3 == 0 ? 413 : i % 3 == 1 ? 414 : 622), '\x00');
+        }
+    };
+
+    SECTION("Testing frame headers") {
+
+        auto header = MP3::parseHeader(headers[2]);
+
+        REQUIRE(header);
+        REQUIRE(header->version == MP3::MPEG_1);
+        REQUIRE(header->layer == 3);
+        REQUIRE_FALSE(header->crc);
+        REQUIRE(header->bitrate == 192);
+        REQUIRE(header->sample_rate == 44100);
+        REQUIRE(header->channel_mode == MP3::JOINT_STEREO);
+        REQUIRE(header->channels() == 2);
+        REQUIRE(header->size == 626);
+        REQUIRE(header->samples == 1152);
+
+        // MPEG 2 layer 3, 22.05 kHz, mono, 80 kbit/s with CRC
+        header = MP3::parseHeader(std::array<char, 4>{'\xff', '\xf2', '\x90', '\xc4'});
+
+        REQUIRE(header);
+        REQUIRE(header->version == MP3::MPEG_2);
+        REQUIRE(header->crc);
+        REQUIRE(header->bitrate == 80);
+        REQUIRE(header->sample_rate == 22050);
+        REQUIRE(header->channels() == 1);
+        REQUIRE(header->size == 261);
+        REQUIRE(header->samples == 576);
+
+        // free format, reserved sample rate and reserved version
+        REQUIRE_FALSE(MP3::parseHeader(std::array<char, 4>{'\xff', '\xfb', '\x00', '\x64'}));
+        REQUIRE_FALSE(MP3::parseHeader(std::array<char, 4>{'\xff', '\xfb', '\x9c', '\x64'}));
+        REQUIRE_FALSE(MP3::parseHeader(std::array<char, 4>{'\xff', '\xeb', '\x90', '\x64'}));
+        REQUIRE_FALSE(MP3::parseHeader(std::array<char, 3>{'\xff', '\xfb', '\x90'}));
+    }
+
+    SECTION("Testing the index") {
+
+        append(100);
+
+        // garbage including a sync word that is not followed by another frame
+        data.insert(data.end(), {'\xff', '\xfb', '\x90', '\x64', 'x', '\xff', 'y', 'z'});
+
+        append(100);
+
+        // ID3v1 tag
+        data.insert(data.end(), {'T', 'A', 'G'});
+        data.resize(data.size() + 125, ' ');
+
+        auto index = MP3::FrameIndex::scan(data, 1000);
+
+        REQUIRE(index.frames() == 200);
+        REQUIRE(index.sampleRate() == 44100);
+        REQUIRE(index.samplesPerFrame() == 1152);
+        REQUIRE(index.samples() == 200 * 1152);
+        REQUIRE(index.duration() == 5224);
+
+        for (std::size_t frame = 0; frame < index.frames(); ++frame)
+            REQUIRE(index.offset(frame) == offsets[frame]);
+
+        REQUIRE(index.size(0) == 417);
+        REQUIRE(index.size(1) == 418);
+        REQUIRE(index.size(2) == 626);
+
+        REQUIRE(index.frameAt(0) == 0);
+        REQUIRE(index.frameAt(1000) == 38);
+        REQUIRE(index.frameAt(6000) == index.frames());
+    }
+
+    SECTION("Testing data without frames") {
+
+        data.resize(10000, '\xff');
+
+        REQUIRE(MP3::FrameIndex::scan(data).empty());
+        REQUIRE(MP3::FrameIndex::scan({}).duration() == 0);
+    }
+}
+
+
+TEST_CASE("Testing the VBR headers from mp3.hpp", "[MP3::VBRHeader]") {
+
+    // MPEG 1 layer 3, 44.1 kHz, joint stereo, 128 kbit/s (417 bytes)
+    const std::array<char, 4> header = {'\xff', '\xfb', '\x90', '\x64'};
+
+    std::vector<char> frame(417, '\x00');
+    std::copy(header.begin(), header.end(), frame.begin());
+
+    auto write = [&](std::size_t position, std::uint32_t value, std::size_t bytes) {
+        for (std::size_t i = 0; i < bytes; ++i)
+            frame[position + i] = static_cast<char>(value >> (8 * (bytes - 1 - i)));
+    };
+
+    SECTION("Testing Xing headers with a LAME extension") {
+
+        // after 32 bytes of side information
+        std::memcpy(frame.data() + 36, "Xing", 4);
+        write(40, 0x0f, 4);
+        write(44, 1000, 4);
+        write(48, 417000, 4);
+
+        for (std::size_t i = 0; i < 100; ++i)
+            frame[52 + i] = static_cast<char>(i * 256 / 100);
+
+        std::memcpy(frame.data() + 156, "LAME3.100", 9);
+
+        // 576 samples of delay and 1000 samples of padding
+        write(156 + 21, (576 << 12) | 1000, 3);
+
+        auto vbr = MP3::parseVBRHeader(frame);
+
+        REQUIRE(vbr);
+        REQUIRE(vbr->frames == 1000);
+        REQUIRE(vbr->bytes == 417000);
+        REQUIRE(vbr->has_toc);
+        REQUIRE(vbr->toc[50] == 128);
+        REQUIRE(vbr->delay == 576);
+        REQUIRE(vbr->padding == 1000);
+        REQUIRE(vbr->sample_rate == 44100);
+        REQUIRE(vbr->header_size == 417);
+        REQUIRE(vbr->samples() == 1000 * 1152 - 576 - 1000);
+        REQUIRE(vbr->duration() == 26086);
+
+        REQUIRE(vbr->seek(0) == 0);
+        REQUIRE(vbr->seek(vbr->duration() / 2) == 208500);
+
+        // without a seek table the bitrate is assumed to be constant
+        vbr->has_toc = false;
+
+        REQUIRE(vbr->seek(vbr->duration() / 4) > 104000);
+        REQUIRE(vbr->seek(vbr->duration() / 4) < 104500);
+
+        SECTION("Testing the duration of a stream") {
+
+            std::vector<char> data(frame);
+
+            for (std::size_t i = 0; i < 3; ++i)
+                data.insert(data.end(), frame.begin(), frame.end());
+
+            REQUIRE(MP3::estimateDuration(data) == 26086);
+        }
+    }
+
+    SECTION("Testing Info headers without the optional fields") {
+
+        std::memcpy(frame.data() + 36, "Info", 4);
+        write(40, 0x01, 4);
+        write(44, 10, 4);
+
+        auto vbr = MP3::parseVBRHeader(frame);
+
+        REQUIRE(vbr);
+        REQUIRE(vbr->frames == 10);
+        REQUIRE(vbr->bytes == 0);
+        REQUIRE_FALSE(vbr->has_toc);
+        REQUIRE(vbr->delay == 0);
+        REQUIRE(vbr->duration() == 261);
+
+        // the frame of the header is not an audio frame, the index has the same duration
+        write(44, 100, 4);
+
+        std::vector<char> data(frame);
+
+        std::fill(frame.begin() + 36, frame.end(), '\x00');
+
+        for (std::size_t i = 0; i < 100; ++i)
+            data.insert(data.end(), frame.begin(), frame.end());
+
+        auto index = MP3::FrameIndex::scan(data);
+
+        REQUIRE(index.frames() == 100);
+        REQUIRE(index.offset(0) == 417);
+        REQUIRE(index.duration() == 2612);
+        REQUIRE(index.duration() == MP3::estimateDuration(data));
+    }
+
+    SECTION("Testing VBRI headers") {
+
+        std::memcpy(frame.data() + 36, "VBRI", 4);
+        write(40, 1, 2);
+        write(46, 10000, 4);
+        write(50, 1000, 4);
+
+        // 10 entries of 2 bytes for 100 frames each, the first half of the frames is twice as large
+        write(54, 10, 2);
+        write(56, 1, 2);
+        write(58, 2, 2);
+        write(60, 100, 2);
+
+        for (std::size_t i = 0; i < 10; ++i)
+            write(62 + 2 * i, i < 5 ? 1333 : 667, 2);
+
+        auto vbr = MP3::parseVBRHeader(frame);
+
+        REQUIRE(vbr);
+        REQUIRE(vbr->frames == 1000);
+        REQUIRE(vbr->bytes == 10000);
+        REQUIRE(vbr->has_toc);
+        REQUIRE(vbr->toc[0] == 0);
+        REQUIRE(vbr->toc[50] == 170);
+    }
+
+    SECTION("Testing frames without a VBR header") {
+
+        REQUIRE_FALSE(MP3::parseVBRHeader(frame));
+
+        // constant bitrate, 128 kbit/s are 16 bytes per ms
+        std::vector<char> data;
+
+        for (std::size_t i = 0; i < 100; ++i)
+            data.insert(data.end(), frame.begin(), frame.end());
+
+        REQUIRE(MP3::estimateDuration(data) == 417 * 100 / 16);
+        REQUIRE(MP3::estimateDuration({}) == 0);
+    }
+}
+
+
+TEST_CASE("Testing the BitReader from bitstream.hpp", "[BitReader]") {
+
+    std::vector<char> data(21);
+
+    for (std::size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<char>(i * 37 + 11);
+
+    // reference, the bit at a position
+    auto bit = [&](std::size_t position) -> std::uint32_t {
+        return position < data.size() * 8 ? (static_cast<std::uint8_t>(data[position / 8]) >> (7 - position % 8)) & 0x01 : 0;
+    };
+
+    auto expected = [&](std::size_t position, std::size_t bits) {
+        std::uint32_t value = 0;
+        for (std::size_t i = 0; i < bits; ++i)
+            value = (value << 1) | bit(position + i);
+        return value;
+    };
+
+    SECTION("Testing reads of all lengths across refills and the end of the buffer") {
+
+        for (std::size_t start = 0; start < 9; ++start) {
+
+            BitReader reader(data, start);
+
+            std::size_t position = start;
+
+            for (std::size_t bits = 1; position < data.size() * 8 + 64; bits = bits % 32 + 1) {
+
+                REQUIRE(reader.peek(bits) == expected(position, bits));
+                REQUIRE(reader.read(bits) == expected(position, bits));
+
+                position += bits;
+
+                REQUIRE(reader.position() == position);
+            }
+        }
+    }
+
+    SECTION("Testing seeking") {
+
+        BitReader reader(data);
+
+        reader.read(30);
+        reader.seek(77);
+
+        REQUIRE(reader.position() == 77);
+        REQUIRE(reader.read(19) == expected(77, 19));
+
+        reader.seek(3);
+
+        REQUIRE(reader.bit() == bit(3));
+        REQUIRE(reader.read(0) == 0);
+        REQUIRE(reader.position() == 4);
+        REQUIRE(reader.size() == 168);
+    }
+}
+
+
+TEST_CASE("Testing the Huffman decoding from huffman.hpp", "[MP3::Huffman]") {
+
+    std::vector<char> data;
+    std::size_t bits = 0;
+
+    auto write = [&](std::uint32_t value, std::size_t length) {
+        for (std::size_t i = length; i-- > 0; ++bits) {
+            if (bits % 8 == 0)
+                data.push_back(0);
+            if ((value >> i) & 0x01)
+                data.back() = static_cast<char>(data.back() | (0x80 >> (bits % 8)));
+        }
+    };
+
+    auto writeValue = [&](std::int32_t value, std::size_t linbits) {
+        std::uint32_t magnitude = static_cast<std::uint32_t>(std::abs(value));
+        if (linbits != 0 && magnitude >= 15)
+            write(magnitude - 15, linbits);
+        if (magnitude != 0)
+            write(value < 0 ? 1u : 0u, 1);
+    };
+
+    SECTION("Testing the pairs of all tables") {
+
+        std::vector<std::array<std::int32_t, 3>> expected;
+
+        for (std::uint32_t table = 1; table < 32; ++table) {
+
+            const auto& code = MP3::Huffman::TABLES[table];
+
+            for (std::size_t symbol = 0; code.dimension != 0 && symbol < code.dimension * code.dimension; ++symbol) {
+
+                std::int32_t x = static_cast<std::int32_t>(symbol / code.dimension);
+                std::int32_t y = static_cast<std::int32_t>(symbol % code.dimension);
+
+                // escaped values use the largest value of the linbits and alternating signs
+                if (x == 15 && code.linbits != 0)
+                    x += (1 << code.linbits) - 1;
+
+                if (symbol % 2 == 1)
+                    y = -y;
+
+                write(code.codes[symbol], code.lengths[symbol]);
+                writeValue(x, code.linbits);
+                writeValue(y, code.linbits);
+
+                expected.push_back({static_cast<std::int32_t>(table), x, y});
+            }
+        }
+
+        BitReader reader(data);
+
+        for (const auto& [table, x, y] : expected) {
+
+            std::int32_t decoded_x = 0;
+            std::int32_t decoded_y = 0;
+
+            MP3::Huffman::decodePair(reader, static_cast<std::uint32_t>(table), decoded_x, decoded_y);
+
+            REQUIRE(decoded_x == x);
+            REQUIRE(decoded_y == y);
+        }
+
+        REQUIRE(reader.position() == bits);
+    }
+
+    SECTION("Testing the quadruples of the count1 tables") {
+
+        for (std::uint32_t table = 0; table < 2; ++table) {
+
+            const auto& code = MP3::Huffman::COUNT1_TABLES[table];
+
+            for (std::size_t symbol = 0; symbol < 16; ++symbol) {
+                write(code.codes[symbol], code.lengths[symbol]);
+                for (std::size_t i = 0; i < 4; ++i)
+                    if ((symbol >> (3 - i)) & 0x01)
+                        write(1, 1);
+            }
+        }
+
+        BitReader reader(data);
+
+        for (std::uint32_t table = 0; table < 2; ++table) {
+
+            for (std::size_t symbol = 0; symbol < 16; ++symbol) {
+
+                std::int32_t values[4];
+
+                MP3::Huffman::decodeQuadruple(reader, table, values);
+
+                for (std::size_t i = 0; i < 4; ++i)
+                    REQUIRE(values[i] == -static_cast<std::int32_t>((symbol >> (3 - i)) & 0x01));
+            }
+        }
+
+        REQUIRE(reader.position() == bits);
+    }
+}
+
+
+/**
+ * Writes a layer 3 frame (without CRC) where the spectrum of every granule of every channel holds
+ * at most a single line of value 1, coded with Huffman table 1. The main data starts right after the
+ * side information and there are no scalefactors.
+ *
+ * t_header: The frame header, the version and the channel mode are taken from it
+ * t_size:   The size of the frame in bytes
+ * t_lines:  The index of the line by granule and channel, -1 for granules without a line
+ * t_gain:   The global gain of every granule
+ * t_short:  true if every granule is a block of short windows, false for long blocks
+ */
+std::vector<char> writeLayer3Frame(std::array<char, 4> t_header, std::size_t t_size, std::array<std::array<int, 2>, 2> t_lines, std::uint32_t t_gain, bool t_short) {
+
+    std::vector<char> frame(t_size, '\x00');
+    std::copy(t_header.begin(), t_header.end(), frame.begin());
+
+    bool mpeg1 = t_header[1] & 0x08;
+    std::size_t channels = (static_cast<std::uint8_t>(t_header[3]) >> 6) == 3 ? 1 : 2;
+    std::size_t granules = mpeg1 ? 2 : 1;
+
+    std::size_t bits = 32;
+
+    auto write = [&](std::uint32_t t_value, std::size_t t_length) {
+        for (std::size_t i = t_length; i-- > 0; ++bits)
+            if ((t_value >> i) & 0x01)
+                frame[bits / 8] = static_cast<char>(frame[bits / 8] | (0x80 >> (bits % 8)));
+    };
+
+    // pairs of zeros (code 1) up to the pair of the line, (1, 0) is coded as 01 and (0, 1) as 001, followed by a positive sign
+    auto length = [](int t_line) -> std::uint32_t {
+        return t_line < 0 ? 0 : static_cast<std::uint32_t>(t_line / 2 + (t_line % 2 == 0 ? 2 : 3) + 1);
+    };
+
+    // main_data_begin, private bits and scfsi
+    if (mpeg1)
+        write(0, channels == 1 ? 18 : 20);
+    else
+        write(0, channels == 1 ? 9 : 10);
+
+    for (std::size_t gr = 0; gr < granules; ++gr) {
+        for (std::size_t ch = 0; ch < channels; ++ch) {
+
+            int line = t_lines[gr][ch];
+
+            write(length(line), 12);
+            write(line < 0 ? 0 : static_cast<std::uint32_t>(line / 2 + 1), 9);
+            write(t_gain, 8);
+            write(0, mpeg1 ? 4 : 9);
+
+            if (t_short) {
+                // window switching, block type 2, not mixed, table 1 for both regions and no subblock gain
+                write(1, 1);
+                write(2, 2);
+                write(0, 1);
+                write(1, 5);
+                write(1, 5);
+                write(0, 9);
+            }
+
+            else {
+                // table 1 for all regions
+                write(0, 1);
+                write(1, 5);
+                write(1, 5);
+                write(1, 5);
+                write(0, 7);
+            }
+
+            // preflag (only MPEG 1), scalefac_scale and count1table_select
+            write(0, mpeg1 ? 3 : 2);
+        }
+    }
+
+    for (std::size_t gr = 0; gr < granules; ++gr) {
+        for (std::size_t ch = 0; ch < channels; ++ch) {
+
+            int line = t_lines[gr][ch];
+
+            if (line < 0)
+                continue;
+
+            for (int pair = 0; pair < line / 2; ++pair)
+                write(1, 1);
+
+            if (line % 2 == 0)
+                write(0x01, 2);
+            else
+                write(0x01, 3);
+
+            write(0, 1);
+        }
+    }
+
+    return frame;
+}
+
+
+TEST_CASE("Testing the decoder from decoder.hpp", "[MP3::Decoder]") {
+
+    // MPEG 1 layer 3, 44.1 kHz, mono, 128 kbit/s (417 bytes) with 17 bytes of side information
+    const std::array<char, 4> header = {'\xff', '\xfb', '\x90', '\xc4'};
+
+    std::vector<char> frame(417, '\x00');
+    std::copy(header.begin(), header.end(), frame.begin());
+
+    std::size_t bits = 32;
+
+    auto write = [&](std::uint32_t value, std::size_t length) {
+        for (std::size_t i = length; i-- > 0; ++bits)
+            if ((value >> i) & 0x01)
+                frame[bits / 8] = static_cast<char>(frame[bits / 8] | (0x80 >> (bits % 8)));
+    };
+
+    std::vector<std::int16_t> pcm(MP3::Decoder::MAX_SAMPLES * 2, 1);
+
+    MP3::Decoder decoder;
+
+    SECTION("Testing a silent frame") {
+
+        REQUIRE(decoder.decode(frame, pcm) == 1152);
+        REQUIRE(decoder.channels() == 1);
+        REQUIRE(decoder.sampleRate() == 44100);
+        REQUIRE(std::all_of(pcm.begin(), pcm.begin() + 1152, [](std::int16_t sample) { return sample == 0; }));
+    }
+
+    // the RMS of the samples and the frequency of a tone in them, from the number of zero crossings
+    auto measure = [](std::span<const std::int16_t> t_samples, std::size_t t_channels, std::size_t t_channel, double t_sample_rate) {
+
+        double sum = 0.0;
+        std::size_t crossings = 0;
+        std::size_t frames = t_samples.size() / t_channels;
+
+        for (std::size_t i = 0; i < frames; ++i) {
+
+            double sample = t_samples[i * t_channels + t_channel];
+
+            sum += sample * sample;
+
+            if (i > 0 && (sample >= 0) != (t_samples[(i - 1) * t_channels + t_channel] >= 0))
+                ++crossings;
+        }
+
+        return std::make_pair(std::sqrt(sum / static_cast<double>(frames)), static_cast<double>(crossings) / 2.0 * t_sample_rate / static_cast<double>(frames));
+    };
+
+    SECTION("Testing a tone in long blocks") {
+
+        std::vector<std::int16_t> output;
+
+        for (std::size_t i = 0; i < 8; ++i) {
+            REQUIRE(decoder.decode(writeLayer3Frame(header, 417, {{{40, -1}, {40, -1}}}, 210, false), pcm) == 1152);
+            output.insert(output.end(), pcm.begin(), pcm.begin() + 1152);
+        }
+
+        // a line of value 1 with a gain of 210 is a sine at full scale, at the center frequency of the line,
+        // measured after the first frames as the filterbanks start without overlap
+        auto [rms, frequency] = measure(std::span<const std::int16_t>(output).subspan(3 * 1152), 1, 0, 44100.0);
+
+        REQUIRE(rms == Approx(23170.0).epsilon(0.01));
+        REQUIRE(frequency == Approx(40.5 * 44100.0 / 1152.0).epsilon(0.02));
+
+        // a quarter of the amplitude with 8 less gain
+        std::fill(output.begin(), output.end(), 0);
+
+        for (std::size_t i = 0; i < 8; ++i) {
+            REQUIRE(decoder.decode(writeLayer3Frame(header, 417, {{{40, -1}, {40, -1}}}, 202, false), pcm) == 1152);
+            std::copy_n(pcm.begin(), 1152, output.begin() + static_cast<std::ptrdiff_t>(i * 1152));
+        }
+
+        REQUIRE(measure(std::span<const std::int16_t>(output).subspan(3 * 1152), 1, 0, 44100.0).first == Approx(23170.0 / 4.0).epsilon(0.01));
+    }
+
+    SECTION("Testing short blocks") {
+
+        // the energy of a line in a short block and the position of its center, with the silent frame after it
+        auto energy = [&](int t_line) {
+
+            MP3::Decoder short_decoder;
+            std::vector<std::int16_t> output;
+
+            REQUIRE(short_decoder.decode(writeLayer3Frame(header, 417, {{{t_line, -1}, {-1, -1}}}, 210, true), pcm) == 1152);
+            output.insert(output.end(), pcm.begin(), pcm.begin() + 1152);
+
+            REQUIRE(short_decoder.decode(frame, pcm) == 1152);
+            output.insert(output.end(), pcm.begin(), pcm.begin() + 1152);
+
+            double sum = 0.0;
+            double center = 0.0;
+
+            for (std::size_t i = 0; i < output.size(); ++i) {
+                double power = static_cast<double>(output[i]) * output[i];
+                sum += power;
+                center += power * static_cast<double>(i);
+            }
+
+            return std::make_pair(sum, center / sum);
+        };
+
+        // the first line of the three windows of the first scalefactor band (4 lines wide), the windows
+        // are 6 samples of the subbands apart, which are 192 samples of the output
+        auto first = energy(0);
+        auto second = energy(4);
+        auto third = energy(8);
+
+        REQUIRE(first.first > 0.0);
+        REQUIRE(second.first == Approx(first.first));
+        REQUIRE(third.first == Approx(first.first));
+        REQUIRE(second.second - first.second == Approx(192.0).margin(1.0));
+        REQUIRE(third.second - second.second == Approx(192.0).margin(1.0));
+    }
+
+    SECTION("Testing mid/side stereo") {
+
+        // joint stereo with mid/side stereo
+        const std::array<char, 4> joint = {'\xff', '\xfb', '\x90', '\x64'};
+
+        // the left and the right channel are (mid + side) / sqrt(2) and (mid - side) / sqrt(2)
+        for (std::size_t i = 0; i < 3; ++i)
+            REQUIRE(decoder.decode(writeLayer3Frame(joint, 417, {{{40, -1}, {40, -1}}}, 210, false), pcm) == 1152);
+
+        REQUIRE(decoder.channels() == 2);
+
+        for (std::size_t i = 0; i < 1152; ++i)
+            REQUIRE(pcm[2 * i] == pcm[2 * i + 1]);
+
+        REQUIRE(measure(std::span<const std::int16_t>(pcm.data(), 2 * 1152), 2, 0, 44100.0).first == Approx(23170.0 / std::sqrt(2.0)).epsilon(0.01));
+
+        decoder.reset();
+
+        for (std::size_t i = 0; i < 3; ++i)
+            REQUIRE(decoder.decode(writeLayer3Frame(joint, 417, {{{-1, 40}, {-1, 40}}}, 210, false), pcm) == 1152);
+
+        // up to rounding
+        for (std::size_t i = 0; i < 1152; ++i)
+            REQUIRE(std::abs(pcm[2 * i] + pcm[2 * i + 1]) <= 1);
+
+        REQUIRE(measure(std::span<const std::int16_t>(pcm.data(), 2 * 1152), 2, 1, 44100.0).first == Approx(23170.0 / std::sqrt(2.0)).epsilon(0.01));
+    }
+
+    SECTION("Testing MPEG 2 frames") {
+
+        // MPEG 2 layer 3, 22.05 kHz, mono, 64 kbit/s (208 bytes), a single granule with 9 bytes of side information
+        const std::array<char, 4> lsf = {'\xff', '\xf3', '\x80', '\xc4'};
+
+        std::vector<std::int16_t> output;
+
+        for (std::size_t i = 0; i < 10; ++i) {
+            REQUIRE(decoder.decode(writeLayer3Frame(lsf, 208, {{{40, -1}, {-1, -1}}}, 210, false), pcm) == 576);
+            output.insert(output.end(), pcm.begin(), pcm.begin() + 576);
+        }
+
+        REQUIRE(decoder.sampleRate() == 22050);
+
+        // the same tone at half the sample rate
+        auto [rms, frequency] = measure(std::span<const std::int16_t>(output).subspan(4 * 576), 1, 0, 22050.0);
+
+        REQUIRE(rms == Approx(23170.0).epsilon(0.01));
+        REQUIRE(frequency == Approx(40.5 * 22050.0 / 1152.0).epsilon(0.02));
+    }
+
+    SECTION("Testing frames that refer to missing main data") {
+
+        // 100 bytes from previous frames
+        write(100, 9);
+
+        REQUIRE(decoder.decode(frame, pcm) == 1152);
+        REQUIRE(std::all_of(pcm.begin(), pcm.begin() + 1152, [](std::int16_t sample) { return sample == 0; }));
+
+        // the main data of the first frame can be used by the second frame
+        REQUIRE(decoder.decode(frame, pcm) == 1152);
+    }
+
+    SECTION("Testing invalid frames") {
+
+        REQUIRE(decoder.decode(std::span<const char>(frame.data(), 200), pcm) == 0);
+        REQUIRE(decoder.decode(frame, std::span<std::int16_t>(pcm.data(), 1000)) == 0);
+
+        // layer 1
+        frame[1] = '\xff';
+
+        REQUIRE(decoder.decode(frame, pcm) == 0);
+    }
+
+    SECTION("Testing the synthesis filterbank") {
+
+        // a constant in the lowest subband is passed through with unity gain after the delay of the filterbank
+        MP3::DSP::Synthesis synthesis;
+
+        MP3::DSP::sample subbands[32] = {};
+        subbands[0] = 1 << (MP3::DSP::FRACTION_BITS - 1);
+
+        std::array<std::int16_t, 32> output{};
+
+        for (std::size_t i = 0; i < 40; ++i)
+            MP3::DSP::synthesize(synthesis, subbands, output.data(), 1);
+
+        for (auto sample : output)
+            REQUIRE(std::abs(sample - 16384) < 200);
+    }
+}
+
+
+TEST_CASE("Testing the vectorized filterbanks from dsp.hpp", "[MP3::DSP]") {
+
+    // random samples up to 4 times the full scale
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<MP3::DSP::sample> distribution(-(1 << 26), 1 << 26);
+
+    std::vector<MP3::DSP::sample> input(18 * 32 * 16);
+
+    for (auto& value : input)
+        value = distribution(generator);
+
+    auto initial = MP3::DSP::kernel();
+
+    REQUIRE(MP3::DSP::useKernel(MP3::DSP::SCALAR));
+
+    // runs the IMDCT with all block types and the synthesis on the input
+    auto run = [&](std::vector<std::int16_t>& pcm, std::vector<MP3::DSP::sample>& samples) {
+
+        MP3::DSP::Synthesis synthesis;
+
+        std::array<MP3::DSP::sample, 18> overlap{};
+
+        for (std::size_t i = 0; i + 18 <= input.size(); i += 18) {
+
+            std::array<MP3::DSP::sample, 18> block{};
+
+            MP3::DSP::inverseMDCT(input.data() + i, overlap.data(), block.data(), static_cast<std::uint8_t>((i / 18) % 4));
+
+            samples.insert(samples.end(), block.begin(), block.end());
+        }
+
+        for (std::size_t i = 0; i + 32 <= input.size(); i += 32) {
+            pcm.resize(pcm.size() + 32);
+            MP3::DSP::synthesize(synthesis, input.data() + i, pcm.data() + pcm.size() - 32, 1);
+        }
+    };
+
+    std::vector<std::int16_t> reference_pcm;
+    std::vector<MP3::DSP::sample> reference_samples;
+
+    run(reference_pcm, reference_samples);
+
+    for (auto kernel : {MP3::DSP::SSE2, MP3::DSP::AVX2, MP3::DSP::NEON}) {
+
+        if (!MP3::DSP::useKernel(kernel))
+            continue;
+
+        REQUIRE(MP3::DSP::kernel() == kernel);
+
+        std::vector<std::int16_t> pcm;
+        std::vector<MP3::DSP::sample> samples;
+
+        run(pcm, samples);
+
+        // the products are accumulated with 64 bits by all kernels, so the results are identical
+        REQUIRE(samples == reference_samples);
+        REQUIRE(pcm == reference_pcm);
+    }
+
+    REQUIRE(MP3::DSP::useKernel(initial));
+}
+
+
+TEST_CASE("Testing the RingBuffer", "[RingBuffer]") {
+
+    SECTION("Testing the capacity and whole frames") {
+
+        RingBuffer buffer(1000, 2);
+
+        REQUIRE(buffer.capacity() == 1024);
+        REQUIRE(buffer.channels() == 2);
+        REQUIRE(buffer.available() == 0);
+        REQUIRE(buffer.space() == 1024);
+
+        std::vector<std::int16_t> samples(3000);
+
+        for (std::size_t i = 0; i < samples.size(); ++i)
+            samples[i] = static_cast<std::int16_t>(i);
+
+        // the partial frame at the end is ignored
+        REQUIRE(buffer.write(std::span<const std::int16_t>(samples.data(), 601)) == 300);
+        REQUIRE(buffer.write(samples) == 724);
+        REQUIRE(buffer.write(samples) == 0);
+        REQUIRE(buffer.available() == 1024);
+
+        std::vector<std::int16_t> output(1000);
+
+        REQUIRE(buffer.read(output) == 500);
+        REQUIRE(std::equal(output.begin(), output.begin() + 600, samples.begin()));
+        REQUIRE(std::equal(output.begin() + 600, output.end(), samples.begin()));
+
+        // wrapping around the end of the storage
+        REQUIRE(buffer.write(std::span<const std::int16_t>(samples.data(), 400)) == 200);
+        REQUIRE(buffer.read(std::span<std::int16_t>(output.data(), 3)) == 1);
+        REQUIRE(buffer.available() == 723);
+
+        std::vector<std::int16_t> rest(2000);
+
+        REQUIRE(buffer.read(rest) == 723);
+        REQUIRE(std::equal(rest.begin(), rest.begin() + 1046, samples.begin() + 402));
+        REQUIRE(std::equal(rest.begin() + 1046, rest.begin() + 1446, samples.begin()));
+        REQUIRE(buffer.read(rest) == 0);
+    }
+
+    SECTION("Testing a producer and a consumer thread") {
+
+        constexpr std::size_t FRAMES = 1 << 20;
+
+        RingBuffer buffer(256, 2);
+
+        std::thread producer([&] {
+
+            std::vector<std::int16_t> block;
+
+            for (std::size_t frame = 0; frame < FRAMES;) {
+
+                // blocks of varying sizes
+                block.clear();
+
+                for (std::size_t i = 0; i < 1 + frame % 97 && frame + i < FRAMES; ++i) {
+                    block.push_back(static_cast<std::int16_t>(frame + i));
+                    block.push_back(static_cast<std::int16_t>(~(frame + i)));
+                }
+
+                std::span<const std::int16_t> pending(block);
+
+                while (!pending.empty()) {
+
+                    std::size_t written = buffer.write(pending);
+
+                    frame += written;
+                    pending = pending.subspan(written * 2);
+
+                    if (written == 0)
+                        std::this_thread::yield();
+                }
+            }
+        });
+
+        std::vector<std::int16_t> output(2 * 61);
+
+        std::size_t frame = 0;
+        bool ordered = true;
+
+        while (frame < FRAMES) {
+
+            std::size_t read = buffer.read(output);
+
+            for (std::size_t i = 0; i < read; ++i, ++frame)
+                ordered &= output[2 * i] == static_cast<std::int16_t>(frame) && output[2 * i + 1] == static_cast<std::int16_t>(~frame);
+
+            if (read == 0)
+                std::this_thread::yield();
+        }
+
+        producer.join();
+
+        REQUIRE(ordered);
+        REQUIRE(buffer.available() == 0);
+    }
+}
+
+
+TEST_CASE("Testing the audio sinks", "[AudioSink]") {
+
+    std::vector<std::int16_t> samples(2 * 4410 + 1);
+
+    for (std::size_t i = 0; i < samples.size(); ++i)
+        samples[i] = static_cast<std::int16_t>(i * 7919);
+
+    SECTION("Testing the null sink") {
+
+        NullSink sink;
+
+        REQUIRE(sink.write(samples) == 0);
+        REQUIRE_FALSE(sink.open(0, 2));
+        REQUIRE(sink.open(44100, 2));
+
+        REQUIRE(sink.write(samples) == 4410);
+        REQUIRE(sink.write(samples) == 4410);
+
+        // switching to mono keeps counting
+        REQUIRE(sink.open(22050, 1));
+        REQUIRE(sink.write(std::span<const std::int16_t>(samples.data(), 2205)) == 2205);
+
+        sink.close();
+
+        REQUIRE(sink.frames() == 2 * 4410 + 2205);
+        REQUIRE(sink.duration() == 300);
+        REQUIRE(sink.sampleRate() == 0);
+        REQUIRE(sink.realTimeFactor() >= 0.0);
+    }
+
+    SECTION("Testing the buffered sink") {
+
+        // records the samples and the thread that writes them, slowly
+        struct RecordingSink : public AudioSink {
+
+            bool open(std::uint32_t t_sample_rate, std::uint32_t t_channels) noexcept override {
+                ++opened;
+
+                // a format the sink does not accept
+                if (t_channels == 3)
+                    return false;
+
+                m_sample_rate = t_sample_rate;
+                m_channels = t_channels;
+                return true;
+            }
+
+            std::size_t write(std::span<const std::int16_t> t_samples) noexcept override {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+                samples.insert(samples.end(), t_samples.begin(), t_samples.end());
+                thread = std::this_thread::get_id();
+                return t_samples.size() / m_channels;
+            }
+
+            void close() noexcept override {
+                closed = samples.size();
+            }
+
+            std::vector<std::int16_t> samples;
+            std::thread::id thread;
+            std::size_t opened = 0;
+            std::size_t closed = 0;
+        };
+
+        RecordingSink target;
+
+        {
+            // a small ring, so that writing has to wait for the output thread
+            BufferedSink sink(target, 256);
+
+            REQUIRE(sink.write(samples) == 0);
+            REQUIRE(sink.open(44100, 2));
+
+            for (std::size_t offset = 0; offset + 1000 <= samples.size(); offset += 1000)
+                REQUIRE(sink.write(std::span<const std::int16_t>(samples.data() + offset, 1000)) == 500);
+
+            // the format is rejected, the sink keeps playing the old one
+            REQUIRE_FALSE(sink.open(44100, 3));
+            REQUIRE(sink.write(std::span<const std::int16_t>(samples.data() + 8000, 810)) == 405);
+
+            // the frames of the old format are written before the format changes
+            REQUIRE(sink.open(22050, 1));
+            REQUIRE(target.samples.size() == 8810);
+            REQUIRE(sink.write(std::span<const std::int16_t>(samples.data(), 11)) == 11);
+        }
+
+        REQUIRE(target.opened == 3);
+        REQUIRE(target.closed == 8821);
+        REQUIRE(target.thread != std::this_thread::get_id());
+        REQUIRE(std::equal(samples.begin(), samples.begin() + 8810, target.samples.begin()));
+        REQUIRE(std::equal(samples.begin(), samples.begin() + 11, target.samples.begin() + 8810));
+    }
+
+    SECTION("Testing the WAV sink") {
+
+        auto path = std::filesystem::temp_directory_path() / "sink_test.wav";
+
+        {
+            WAVSink sink(path.string());
+
+            REQUIRE(sink.open(44100, 2));
+            REQUIRE(sink.open(44100, 2));
+            REQUIRE_FALSE(sink.open(48000, 2));
+
+            REQUIRE(sink.write(samples) == 4410);
+        }
+
+        std::ifstream stream(path, std::ios::binary);
+        std::vector<char> file((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+        auto read = [&](std::size_t position, std::size_t bytes) {
+            std::uint32_t value = 0;
+            for (std::size_t i = 0; i < bytes; ++i)
+                value |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(file[position + i])) << (8 * i);
+            return value;
+        };
+
+        REQUIRE(file.size() == 44 + 4410 * 4);
+        REQUIRE(std::string(file.data(), 4) == "RIFF");
+        REQUIRE(read(4, 4) == file.size() - 8);
+        REQUIRE(std::string(file.data() + 8, 8) == "WAVEfmt ");
+        REQUIRE(read(20, 2) == 1);
+        REQUIRE(read(22, 2) == 2);
+        REQUIRE(read(24, 4) == 44100);
+        REQUIRE(read(28, 4) == 44100 * 4);
+        REQUIRE(read(34, 2) == 16);
+        REQUIRE(std::string(file.data() + 36, 4) == "data");
+        REQUIRE(read(40, 4) == 4410 * 4);
+
+        for (std::size_t i = 0; i < 4410 * 2; ++i)
+            REQUIRE(static_cast<std::int16_t>(read(44 + 2 * i, 2)) == samples[i]);
+
+        std::filesystem::remove(path);
+    }
+}
+
+
+/**
+ * Sink that keeps everything that is written, for the tests of the player.
+ */
+class CaptureSink : public AudioSink
+{
+public:
+    bool open(std::uint32_t t_sample_rate, std::uint32_t t_channels) noexcept override {
+        m_sample_rate = t_sample_rate;
+        m_channels = t_channels;
+        opens.push_back(t_sample_rate * 10 + t_channels);
+        return true;
+    }
+
+    std::size_t write(std::span<const std::int16_t> t_samples) noexcept override {
+        samples.insert(samples.end(), t_samples.begin(), t_samples.end());
+        writes.push_back(t_samples.size() / m_channels);
+        return t_samples.size() / m_channels;
+    }
+
+    void close() noexcept override {
+        closed = true;
+    }
+
+    std::vector<std::int16_t> samples;
+    std::vector<std::size_t> writes;
+    std::vector<std::uint32_t> opens;
+    bool closed = false;
+};
+
+
+/**
+ * Writes an MPEG 1 layer 3 file (44.1 kHz, 128 kbit/s) of silent frames, after an Info frame
+ * with a LAME extension if t_delay or t_padding are not 0.
+ */
+std::string writeStream(const std::string& t_name, std::size_t t_frames, bool t_stereo, std::uint32_t t_delay, std::uint32_t t_padding) {
+
+    auto path = (std::filesystem::temp_directory_path() / t_name).string();
+
+    std::vector<char> frame(417, '\x00');
+
+    frame[0] = '\xff';
+    frame[1] = '\xfb';
+    frame[2] = '\x90';
+    frame[3] = t_stereo ? '\x64' : '\xc4';
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+
+    if (t_delay != 0 || t_padding != 0) {
+
+        std::vector<char> info(frame);
+
+        auto write = [&](std::size_t position, std::uint32_t value, std::size_t bytes) {
+            for (std::size_t i = 0; i < bytes; ++i)
+                info[position + i] = static_cast<char>(value >> (8 * (bytes - 1 - i)));
+        };
+
+        std::size_t start = t_stereo ? 36 : 21;
+
+        std::memcpy(info.data() + start, "Info", 4);
+        write(start + 4, 0x01, 4);
+        write(start + 8, static_cast<std::uint32_t>(t_frames), 4);
+        // the LAME extension follows the only field, the number of frames
+        std::memcpy(info.data() + start + 12, "LAME3.100", 9);
+        write(start + 33, (t_delay << 12) | t_padding, 3);
+
+        stream.write(info.data(), static_cast<std::streamsize>(info.size()));
+    }
+
+    for (std::size_t i = 0; i < t_frames; ++i)
+        stream.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+
+    return path;
+}
+
+
+/**
+ * Writes an MPEG 1 layer 3 file (44.1 kHz, mono) where every granule holds a single spectral line
+ * of a different frequency and gain, after an Info frame with a LAME extension.
+ *
+ * Every third frame is a large frame (320 kbit/s) between small ones (32 kbit/s). The main data of
+ * a frame starts up to 511 bytes before the frame (main_data_begin), so it is stored in the main
+ * data of the frames before, which have to be in the bit reservoir to decode the frame.
+ */
+std::string writeToneStream(const std::string& t_name, std::size_t t_frames) {
+
+    auto path = writeStream(t_name, 0, false, 576, 1000);
+
+    std::vector<char> data;
+
+    // the main data of all frames, one after another, and the offset of the main data of every frame in it
+    std::vector<char> main_data;
+    std::vector<std::size_t> starts;
+
+    // the end of the main data that is in use
+    std::size_t used = 0;
+
+    auto write = [](std::vector<char>& t_buffer, std::size_t& t_bits, std::uint32_t t_value, std::size_t t_length) {
+        for (std::size_t b = t_length; b-- > 0; ++t_bits)
+            if ((t_value >> b) & 0x01)
+                t_buffer[t_bits / 8] = static_cast<char>(t_buffer[t_bits / 8] | (0x80 >> (t_bits % 8)));
+    };
+
+    for (std::size_t i = 0; i < t_frames; ++i) {
+
+        bool large = i % 3 == 2;
+
+        std::vector<char> frame(large ? 1044 : 104, '\x00');
+        std::size_t bits = 32;
+
+        frame[0] = '\xff';
+        frame[1] = '\xfb';
+        frame[2] = large ? '\xe0' : '\x10';
+        frame[3] = '\xc4';
+
+        std::size_t pairs[2] = {(i * 7) % 20, (i * 7 + 3) % 20};
+
+        // as far back as possible, but after the main data of the frame before
+        std::size_t position = main_data.size();
+        std::size_t start = std::max(used, position > 511 ? position - 511 : 0);
+
+        main_data.resize(position + frame.size() - 21, '\x00');
+
+        // main_data_begin, private bits and scfsi
+        write(frame, bits, static_cast<std::uint32_t>(position - start), 9);
+        write(frame, bits, 0, 9);
+
+        for (std::size_t gr = 0; gr < 2; ++gr) {
+            write(frame, bits, static_cast<std::uint32_t>(pairs[gr] + 3), 12);
+            write(frame, bits, static_cast<std::uint32_t>(pairs[gr] + 1), 9);
+            write(frame, bits, static_cast<std::uint32_t>(200 + i % 10), 8);
+            write(frame, bits, 0, 5);
+            write(frame, bits, 1, 5);
+            write(frame, bits, 1, 5);
+            write(frame, bits, 1, 5);
+            write(frame, bits, 0, 10);
+        }
+
+        // pairs of zeros (code 1) followed by the pair (1, 0) with a positive sign
+        bits = 8 * start;
+
+        for (std::size_t gr = 0; gr < 2; ++gr) {
+            for (std::size_t pair = 0; pair < pairs[gr]; ++pair)
+                write(main_data, bits, 1, 1);
+            write(main_data, bits, 0x01, 2);
+            write(main_data, bits, 0, 1);
+        }
+
+        used = (bits + 7) / 8;
+
+        starts.push_back(position);
+        data.insert(data.end(), frame.begin(), frame.end());
+    }
+
+    // the main data is stored after the side information of every frame
+    for (std::size_t i = 0, offset = 0; i < t_frames; ++i) {
+
+        std::size_t size = (i % 3 == 2 ? 1044 : 104);
+
+        std::copy_n(main_data.begin() + static_cast<std::ptrdiff_t>(starts[i]), size - 21, data.begin() + static_cast<std::ptrdiff_t>(offset + 21));
+
+        offset += size;
+    }
+
+    // the number of frames in the Info frame
+    std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+
+    char count[4] = {static_cast<char>(t_frames >> 24), static_cast<char>(t_frames >> 16), static_cast<char>(t_frames >> 8), static_cast<char>(t_frames)};
+
+    stream.seekp(21 + 8);
+    stream.write(count, 4);
+    stream.seekp(0, std::ios::end);
+    stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+    return path;
+}
+
+
+TEST_CASE("Testing gapless playback", "[Player]") {
+
+    auto first = writeStream("player_first.mp3", 20, true, 576, 1000);
+    auto second = writeStream("player_second.mp3", 10, true, 576, 1200);
+    auto plain = writeStream("player_plain.mp3", 5, true, 0, 0);
+    auto mono = writeStream("player_mono.mp3", 5, false, 1105, 1105);
+
+    SECTION("Testing the trimming of a stream") {
+
+        Song song(first);
+
+        MP3::Stream stream(song);
+
+        REQUIRE(stream.valid());
+        REQUIRE(stream.sampleRate() == 44100);
+        REQUIRE(stream.channels() == 2);
+
+        std::vector<std::int16_t> pcm(100000);
+
+        REQUIRE(stream.read(pcm) == 20 * 1152 - 576 - 1000);
+        REQUIRE(stream.finished());
+        REQUIRE(stream.read(pcm) == 0);
+
+        // without a LAME extension nothing is trimmed, the delay of the song is played as silence
+        Song delayed(plain);
+        delayed.m_delay = 100;
+
+        MP3::Stream untrimmed(delayed);
+
+        REQUIRE(untrimmed.read(pcm) == 4410 + 5 * 1152);
+
+        REQUIRE_FALSE(MP3::Stream(Song(std::filesystem::temp_directory_path() / "player_missing.mp3")).valid());
+    }
+
+    SECTION("Testing decoding ahead of time") {
+
+        Song song(second);
+
+        MP3::Stream stream(song);
+
+        std::size_t total = 10 * 1152 - 576 - 1200;
+
+        REQUIRE(stream.remaining() == total);
+        REQUIRE(stream.prefetch(1000) == 1000);
+        REQUIRE(stream.prefetch(1000) == 1000);
+        REQUIRE(stream.remaining() == total);
+
+        std::vector<std::int16_t> pcm(2 * 1500);
+
+        REQUIRE(stream.read(pcm) == 1500);
+        REQUIRE(stream.remaining() == total - 1500);
+        REQUIRE(stream.prefetch(100000) == total - 2000);
+        REQUIRE(stream.read(pcm) == 1500);
+        REQUIRE_FALSE(stream.finished());
+
+        std::vector<std::int16_t> rest(2 * total);
+
+        REQUIRE(stream.read(rest) == total - 3000);
+        REQUIRE(stream.finished());
+
+        // the remaining frames of streams without a LAME extension are estimated from the frame size
+        MP3::Stream untrimmed(Song{plain});
+
+        REQUIRE(untrimmed.remaining() == 5 * 1152);
+    }
+
+    SECTION("Testing seeking") {
+
+        auto tones = writeToneStream("player_tones.mp3", 200);
+
+        Song song(tones);
+        song.m_delay = 50;
+
+        // the whole stream decoded at once as the reference
+        std::vector<std::int16_t> reference(300000);
+
+        MP3::Stream stream(song);
+
+        std::size_t total = stream.read(reference);
+
+        REQUIRE(total == 2205 + 200 * 1152 - 576 - 1000);
+        REQUIRE(std::count(reference.begin() + 2205, reference.begin() + static_cast<std::ptrdiff_t>(total), 0) < 1000);
+
+        std::vector<std::int16_t> pcm(3000);
+
+        auto check = [&](std::uint64_t t_ms) {
+
+            REQUIRE(stream.seek(t_ms));
+
+            std::size_t start = t_ms * 44100 / 1000;
+            std::size_t frames = stream.read(pcm);
+
+            REQUIRE(frames == std::min<std::size_t>(pcm.size(), total - std::min(start, total)));
+            REQUIRE(std::equal(pcm.begin(), pcm.begin() + static_cast<std::ptrdiff_t>(frames), reference.begin() + static_cast<std::ptrdiff_t>(start)));
+        };
+
+        // into the silence, the first frames, frames in the middle and past the end
+        for (std::uint64_t ms : {0u, 20u, 51u, 70u, 1000u, 2345u, 5000u, 5210u})
+            check(ms);
+
+        // into every frame, the frame before the target frame is a large one for every third of them,
+        // which only holds part of the main data of the frames after it
+        for (std::uint64_t ms = 0; ms < 5200; ms += 26)
+            check(ms);
+
+        REQUIRE(stream.seek(100000));
+        REQUIRE(stream.read(pcm) == 0);
+        REQUIRE(stream.finished());
+
+        std::filesystem::remove(tones);
+    }
+
+    SECTION("Testing decoding across the input window") {
+
+        auto tones = writeToneStream("player_tones.mp3", 300);
+        auto garbage = std::filesystem::temp_directory_path() / "player_garbage.mp3";
+
+        std::vector<std::int16_t> reference(400000);
+
+        std::size_t total = MP3::Stream(Song(tones)).read(reference);
+
+        REQUIRE(total == 300 * 1152 - 576 - 1000);
+
+        // garbage larger than the window between two frames is skipped, the frames are decoded as before
+        std::ifstream in(tones, std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        auto offset = MP3::FrameIndex::build(Song(tones)).offset(150);
+
+        bytes.insert(bytes.begin() + static_cast<std::ptrdiff_t>(offset), MP3::Stream::WINDOW_SIZE + 1000, '\x00');
+
+        std::ofstream(garbage, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+
+        std::vector<std::int16_t> pcm(400000);
+
+        MP3::Stream stream{Song(garbage)};
+
+        REQUIRE(stream.read(pcm) == total);
+        REQUIRE(std::equal(pcm.begin(), pcm.begin() + static_cast<std::ptrdiff_t>(total), reference.begin()));
+        REQUIRE(stream.finished());
+
+        std::filesystem::remove(tones);
+        std::filesystem::remove(garbage);
+    }
+
+    SECTION("Testing the splicing of songs") {
+
+        CaptureSink sink;
+
+        Player player({Song(first), Song(std::filesystem::temp_directory_path() / "player_missing.mp3"), Song(second), Song(mono)}, sink);
+
+        player.play();
+
+        REQUIRE(player.current() == 4);
+        REQUIRE(sink.closed);
+
+        // the missing song is skipped, the sink is only reopened for the mono song
+        REQUIRE(sink.opens == std::vector<std::uint32_t>{441002, 441001});
+
+        std::size_t stereo = 20 * 1152 - 576 - 1000 + 10 * 1152 - 576 - 1200;
+
+        // every write but the last of each format is a whole block, there is no gap between the songs
+        REQUIRE(sink.samples.size() == 2 * stereo + 5 * 1152 - 2210);
+
+        std::size_t blocks = (stereo + Player::BLOCK_FRAMES - 1) / Player::BLOCK_FRAMES;
+
+        for (std::size_t i = 0; i + 1 < blocks; ++i)
+            REQUIRE(sink.writes[i] == Player::BLOCK_FRAMES);
+
+        REQUIRE(sink.writes[blocks - 1] == stereo - (blocks - 1) * Player::BLOCK_FRAMES);
+
+        // opening the next songs right away on another thread gives the same output
+        CaptureSink ahead;
+
+        Player reading({Song(first), Song(std::filesystem::temp_directory_path() / "player_missing.mp3"), Song(second), Song(mono)}, ahead, 3600);
+
+        reading.play();
+
+        REQUIRE(ahead.samples == sink.samples);
+        REQUIRE(ahead.writes == sink.writes);
+    }
+
+    for (const auto& path : {first, second, plain, mono})
+        std::filesystem::remove(path);
+}
+
+
+TEST_CASE("Testing the transcoding of UTF-16 to UTF-8", "[Unicode]") {
+
+    // code points in every range, runs of ASCII characters of different lengths in between
+    std::mt19937 random(3);
+    std::vector<std::uint32_t> codes;
+
+    for (std::size_t i = 0; i < 2000; ++i) {
+
+        switch (random() % 5) {
+            case 0:  codes.push_back(static_cast<std::uint32_t>(0x80 + random() % 0x780)); break;
+            case 1:  codes.push_back(static_cast<std::uint32_t>(0x800 + random() % 0xd000)); break;
+            case 2:  codes.push_back(static_cast<std::uint32_t>(0x10000 + random() % 0x100000)); break;
+            default:
+                for (std::size_t run = random() % 20; run > 0; --run)
+                    codes.push_back(static_cast<std::uint32_t>(0x01 + random() % 0x7f));
+        }
+    }
+
+    std::string expected;
+    std::vector<char> little;
+    std::vector<char> big;
+
+    for (auto code : codes) {
+
+        if (code < 0x80) {
+            expected += static_cast<char>(code);
+        }
+
+        else if (code < 0x800) {
+            expected += static_cast<char>(0xc0 | (code >> 6));
+            expected += static_cast<char>(0x80 | (code & 0x3f));
+        }
+
+        else if (code < 0x10000) {
+            expected += static_cast<char>(0xe0 | (code >> 12));
+            expected += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            expected += static_cast<char>(0x80 | (code & 0x3f));
+        }
+
+        else {
+            expected += static_cast<char>(0xf0 | (code >> 18));
+            expected += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+            expected += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            expected += static_cast<char>(0x80 | (code & 0x3f));
+        }
+
+        std::vector<std::uint32_t> units = {code};
+
+        if (code >= 0x10000)
+            units = {0xd800 + ((code - 0x10000) >> 10), 0xdc00 + ((code - 0x10000) & 0x3ff)};
+
+        for (auto unit : units) {
+            little.push_back(static_cast<char>(unit));
+            little.push_back(static_cast<char>(unit >> 8));
+            big.push_back(static_cast<char>(unit >> 8));
+            big.push_back(static_cast<char>(unit));
+        }
+    }
+
+    std::string output(Unicode::maxUTF8Size(little.size()), '\0');
+
+    SECTION("Testing both byte orders") {
+
+        output.resize(Unicode::utf16ToUTF8(little, false, output.data()));
+        REQUIRE(output == expected);
+
+        output.resize(Unicode::maxUTF8Size(big.size()));
+        output.resize(Unicode::utf16ToUTF8(big, true, output.data()));
+        REQUIRE(output == expected);
+    }
+
+    SECTION("Testing the terminator") {
+
+        REQUIRE(Unicode::findTerminator(little) == little.size());
+
+        // two 0x00 bytes that are not a code unit, followed by the terminator after more than a block
+        std::vector<char> text = {0x61, 0x00, 0x00, 0x01};
+
+        for (std::size_t i = 0; i < 20; ++i)
+            text.insert(text.end(), {0x62, 0x00});
+
+        text.insert(text.end(), {0x00, 0x00, 0x63, 0x00});
+
+        REQUIRE(Unicode::findTerminator(text) == 44);
+
+        // a trailing byte that isn't a whole code unit
+        REQUIRE(Unicode::findTerminator(std::span<const char>(big).first(7)) == 6);
+    }
 }
 
 